@@ -1,4 +1,6 @@
 #include "APath.h"
+#include "Landmarks.h"
+#include "RegionLabels.h"
 #include <stdio.h>
 
 void APath::print(const WayPoint& wp) {
@@ -11,21 +13,18 @@ void APath::print(int index) {
 }
 
 // http://www.policyalmanac.org/games/aStarTutorial_de.html
-APath::APath(Grid* grid) : _grid(grid) {
+APath::APath(Grid* grid, Landmarks* landmarks) : _grid(grid), _landmarks(landmarks), _regions(0) {
 	_open = new int[grid->width * grid->height];
 	_closed = new int[grid->width * grid->height];
 	_numOpen = 0;
 	_numClosed = 0;
+	_search = 0;
 	_internalGrid = new WayPoint[grid->width * grid->height];
 	for (int x = 0; x < grid->width; ++x) {
 		for (int y = 0; y < grid->height; ++y) {
 			int idx = x + y * grid->width;
 			_internalGrid[idx].index = idx;
 			_internalGrid[idx].p = p2i(x, y);
-			_internalGrid[idx].parent = -1;
-			if ( !grid->isAvailable(x,y)) {
-				_internalGrid[idx].available = false;
-			}
 		}
 	}
 	_width = grid->width;
@@ -39,53 +38,92 @@ APath::~APath() {
 }
 
 // ----------------------------------------------------------
-// add
+// touch - resets the waypoint if it belongs to an older search
+// ----------------------------------------------------------
+WayPoint& APath::touch(int index) {
+	WayPoint& wp = _internalGrid[index];
+	if (wp.search != _search) {
+		wp.search = _search;
+		wp.parent = -1;
+		wp.heapIndex = -1;
+		wp.closed = false;
+	}
+	return wp;
+}
+
+// ----------------------------------------------------------
+// heap order - lowest f first, on ties the one closer to the end
 // ----------------------------------------------------------
-float APath::add(p2i p, float g, int parent) {
-	int idx = p.x + p.y * _width;
-	if (idx >= 0) {
-		WayPoint& wp = _internalGrid[idx];
-		wp.p = p;
-		int ex = _end.x - p.x;
-		if (ex < 0) {
-			ex *= -1;
+bool APath::less(int first, int second) const {
+	const WayPoint& a = _internalGrid[first];
+	const WayPoint& b = _internalGrid[second];
+	if (a.f != b.f) {
+		return a.f < b.f;
+	}
+	return a.h < b.h;
+}
+
+void APath::siftUp(int pos) {
+	int idx = _open[pos];
+	while (pos > 0) {
+		int parent = (pos - 1) / 2;
+		if (!less(idx, _open[parent])) {
+			break;
 		}
-		int ey = _end.y - p.y;
-		if (ey < 0) {
-			ey *= -1;
+		_open[pos] = _open[parent];
+		_internalGrid[_open[pos]].heapIndex = pos;
+		pos = parent;
+	}
+	_open[pos] = idx;
+	_internalGrid[idx].heapIndex = pos;
+}
+
+void APath::siftDown(int pos) {
+	int idx = _open[pos];
+	for (;;) {
+		int child = pos * 2 + 1;
+		if (child >= _numOpen) {
+			break;
+		}
+		if (child + 1 < _numOpen && less(_open[child + 1], _open[child])) {
+			++child;
 		}
-		wp.g = g;
-		if (parent != -1) {
-			wp.g += _internalGrid[parent].g;
+		if (!less(_open[child], idx)) {
+			break;
 		}
-		wp.h = (ex + ey) * 10;
-		wp.f = wp.g + wp.h;
-		wp.parent = parent;
-		//printf("=> ");
-		//print(wp);
-		_open[_numOpen++] = idx;
-		return wp.f;
+		_open[pos] = _open[child];
+		_internalGrid[_open[pos]].heapIndex = pos;
+		pos = child;
 	}
-	return 1000.0f;
+	_open[pos] = idx;
+	_internalGrid[idx].heapIndex = pos;
 }
 
 // ----------------------------------------------------------
-// find cheapest
+// push
 // ----------------------------------------------------------
-int APath::findCheapest() {
-	float current = 1000.0f;
-	int idx = -1;
-	for (int i = 0; i < _numOpen; ++i) {
-		int cidx = _open[i];
-		float f = _internalGrid[cidx].f;
-		if (f < current) {
-			idx = cidx;
-			current = _internalGrid[_open[i]].f;
-		}
+void APath::push(int index) {
+	_open[_numOpen++] = index;
+	siftUp(_numOpen - 1);
+}
+
+// ----------------------------------------------------------
+// pop - removes the cheapest waypoint from the open heap
+// ----------------------------------------------------------
+int APath::pop() {
+	int ret = _open[0];
+	_internalGrid[ret].heapIndex = -1;
+	--_numOpen;
+	if (_numOpen > 0) {
+		_open[0] = _open[_numOpen];
+		siftDown(0);
 	}
-	return idx;
+	return ret;
 }
 
+// ----------------------------------------------------------
+// octile distance to the end or the landmark bound
+// ----------------------------------------------------------
 float APath::calculateH(p2i p) {
 	int ex = _end.x - p.x;
 	if (ex < 0) {
@@ -95,7 +133,14 @@ float APath::calculateH(p2i p) {
 	if (ey < 0) {
 		ey *= -1;
 	}
-	return (ex + ey) * 10;
+	int h = ex > ey ? ex * 10 + ey * 4 : ey * 10 + ex * 4;
+	if (_landmarks != 0) {
+		int alt = _landmarks->estimate(getIndex(p), getIndex(_end));
+		if (alt > h) {
+			h = alt;
+		}
+	}
+	return static_cast<float>(h);
 }
 
 float APath::calculateG(int firstIndex, int secondIndex) {
@@ -118,25 +163,6 @@ float APath::calculateG(p2i first, p2i second) {
 // ----------------------------------------------------------
 // get index of neighbours
 // ----------------------------------------------------------
-/*
-int APath::getNeighbours(p2i p, int* result, int max) {
-p2i dirs[] = { p2i(-1,0),p2i(1,0),p2i(0,-1),p2i(0,1) };
-int num = 0;
-for (int i = 0; i < 4; ++i) {
-p2i current = p2i(p.x + dirs[i].x, p.y + dirs[i].y);
-int cidx = current.x + current.y * _width;
-if (cidx >= 0) {
-const WayPoint& wp = _internalGrid[cidx];
-if (wp.available && num < max) {
-if (current.x != p.x || current.y != p.y) {
-result[num++] = cidx;
-}
-}
-}
-}
-return num;
-}
-*/
 int APath::getNeighbours(p2i p, int* result, int max) {
 	int num = 0;
 	int sx = p.x;
@@ -146,7 +172,7 @@ int APath::getNeighbours(p2i p, int* result, int max) {
 			p2i current = p2i(p.x + x, p.y + y);
 			if (_grid->isAvailable(sx + x, sy + y) && num < max) {
 				if (current != p) {
-					result[num++] = _grid->getIndex(current);					
+					result[num++] = _grid->getIndex(current);
 				}
 			}
 		}
@@ -154,174 +180,81 @@ int APath::getNeighbours(p2i p, int* result, int max) {
 	return num;
 }
 
-// ----------------------------------------------------------
-// close item
-// ----------------------------------------------------------
-void APath::close(p2i p) {
-	int current = p.x + p.y * _width;
-	//printf("x> ");
-	//print(current);
-	_closed[_numClosed++] = current;
-	removeWaypoint(p);
-}
-
-// ----------------------------------------------------------
-// check if open
-// ----------------------------------------------------------
-bool APath::isOpen(int index) {
-	for (int i = 0; i < _numOpen; ++i) {
-		if (_open[i] == index) {
-			return true;
-		}
-	}
-	return false;
-}
-
-int APath::find(p2i p) {
-	int idx = p.x + p.y * _width;
-	for (int i = 0; i < _numOpen; ++i) {
-		int current = _open[i];
-		if (current == idx) {
-			return i;
-		}
-	}
-	return -1;
-}
-
-void APath::removeWaypoint(p2i p) {
-	int idx = getIndex(p);
-	for (int i = 0; i < _numOpen; ++i) {
-		if (_open[i] == idx) {
-			if (_numOpen > 0) {
-				_open[i] = _open[_numOpen - 1];
-			}
-			--_numOpen;
-		}
-	}
-}
-
-// ----------------------------------------------------------
-// check if item is in open or closed list
-// ----------------------------------------------------------
-bool APath::visited(int current) {
-	for (int i = 0; i < _numOpen; ++i) {
-		if (_open[i] == current) {
-			return true;
-		}
-	}
-	for (int i = 0; i < _numClosed; ++i) {
-		if (_closed[i] == current) {
-			return true;
-		}
-	}
-	return false;
-}
-
 int APath::getIndex(p2i p) {
 	return p.x + p.y * _width;
 }
 
 // ----------------------------------------------------------
-// move next
-// ----------------------------------------------------------
-int APath::moveNext(p2i p) {
-	close(p);
-	int tmp[8];
-	float far[8];
-	int cidx = getIndex(p);
-	int ret = -1;
-	float gm = 1000.0f;
-	float cg = _internalGrid[cidx].g;
-	int num = getNeighbours(p, tmp, 8);
-	for (int i = 0; i < num; ++i) {
-		int tidx = tmp[i];
-		if (!visited(tidx) && _grid->isAvailable(p)) {
-			//printf("=> ");
-			//print(tidx);
-			float g = calculateG(tidx, cidx);
-			far[i] = add(_internalGrid[tidx].p, g, cidx);
-		}
-		else {
-			if (isOpen(tidx)) {
-				//printf(":> ");
-				//print(tidx);
-				float g = calculateG(_internalGrid[tidx].p, p) + cg;
-				float h = calculateH(_internalGrid[tidx].p);
-				far[i] = g + h;
-			}
-			else {
-				far[i] = 1000.0f;
-			}
-		}
-	}
-
-	for (int i = 0; i < num; ++i) {
-		if (far[i] < gm) {
-			ret = tmp[i];
-			gm = far[i];
-		}
-	}
-	if (ret == -1) {
-		return findCheapest();
-	}
-	return ret;
-}
-
-// ----------------------------------------------------------
-// find
+// find - returns the path from the end back to the start or
+// 0 if the end can not be reached
 // ----------------------------------------------------------
 int APath::find(p2i start, p2i end, p2i* points, int max) {
 	_numOpen = 0;
 	_numClosed = 0;
 	_start = start;
 	_end = end;
-	add(_start, 0.0f);
-	p2i c = _start;
-	int cnt = 0;
-	bool running = true;
+	if (!_grid->isAvailable(start) || !_grid->isAvailable(end)) {
+		return 0;
+	}
+	if (_regions != 0) {
+		_regions->update();
+		if (!_regions->isConnected(start, end)) {
+			return 0;
+		}
+	}
+	if (_landmarks != 0) {
+		_landmarks->update();
+	}
+	++_search;
 	int endIdx = getIndex(end);
-	while (running) {
-		//for ( int i = 0; i < 4; ++i) {
-		int idx = moveNext(c);
-		if (idx == -1) {
-			running = false;
+	WayPoint& first = touch(getIndex(start));
+	first.g = 0.0f;
+	first.h = calculateH(start);
+	first.f = first.h;
+	push(first.index);
+	int tmp[8];
+	bool found = false;
+	while (_numOpen > 0 && !found) {
+		int cidx = pop();
+		WayPoint& current = _internalGrid[cidx];
+		current.closed = true;
+		_closed[_numClosed++] = cidx;
+		if (cidx == endIdx) {
+			found = true;
 		}
 		else {
-			WayPoint ch = _internalGrid[idx];
-			c = ch.p;
-			//printf("idx: %d p: %d %d\n", idx, ch.p.x, ch.p.y);
-		}
-		++cnt;
-		if (cnt > 30) {
-			running = false;
-		}
-		if (idx == endIdx) {
-			close(_end);
-			running = false;
+			int num = getNeighbours(current.p, tmp, 8);
+			for (int i = 0; i < num; ++i) {
+				WayPoint& wp = touch(tmp[i]);
+				if (!wp.closed) {
+					float g = current.g + calculateG(current.p, wp.p);
+					if (wp.heapIndex == -1) {
+						wp.g = g;
+						wp.h = calculateH(wp.p);
+						wp.f = g + wp.h;
+						wp.parent = cidx;
+						push(wp.index);
+					}
+					else if (g < wp.g) {
+						wp.g = g;
+						wp.f = g + wp.h;
+						wp.parent = cidx;
+						siftUp(wp.heapIndex);
+					}
+				}
+			}
 		}
 	}
-	//for (int i = 0; i < _numWaypoints; ++i) {
-	//printf("%d = %d %d g: %g h: %g f: %g\n", i, _waypoints[i].p.x, _waypoints[i].p.y, _waypoints[i].g, _waypoints[i].h, _waypoints[i].f);
-	//}
-	//printf("-------------------------------\n");
-	//printf("iterations: %d\n", cnt);
-	//for (int i = 0; i < _numClosed; ++i) {
-		//printf("%d = %d %d\n", i, _internalGrid[_closed[i]].p.x, _internalGrid[_closed[i]].p.y);
-	//}
+	if (!found) {
+		return 0;
+	}
 	int ret = 0;
-	const WayPoint& last = _internalGrid[_closed[_numClosed - 1]];
-	points[ret++] = last.p;
-	//printf("#> ");
-	//print(last);
-	int parent = _internalGrid[_closed[_numClosed - 1]].parent;
-	//for (int i = 0; i < _numClosed; ++i) {
-	while (parent != -1) {
-		//printf("%d %d\n", _internalGrid[parent].p.x, _internalGrid[parent].p.y);
+	int parent = endIdx;
+	while (parent != -1 && ret < max) {
 		points[ret++] = _internalGrid[parent].p;
 		parent = _internalGrid[parent].parent;
 	}
 	return ret;
-	//print();
 }
 
 void APath::print() {
@@ -330,7 +263,7 @@ void APath::print() {
 		for (int x = 0; x < _width; ++x) {
 			int idx = x + y * _width;
 			WayPoint wp = _internalGrid[idx];
-			if (wp.available) {
+			if (_grid->isAvailable(x, y)) {
 				fprintf(fp, "%2.0f/%2.0f/%2.0f/%2d  ", wp.f, wp.g, wp.h, wp.parent);
 			}
 			else {
@@ -339,5 +272,5 @@ void APath::print() {
 		}
 		fprintf(fp, "\n");
 	}
+	fclose(fp);
 }
-
@@ -1,5 +1,8 @@
 #pragma once
-#include "src\Grid.h"
+#include "src/Grid.h"
+
+class Landmarks;
+class RegionLabels;
 
 struct WayPoint {
 	p2i p;
@@ -7,17 +10,39 @@ struct WayPoint {
 	float h;
 	float g;
 	int parent;
-	bool available;
 	int index;
-	WayPoint() : p(-1, -1), f(0.0f), h(0.0f), g(0.0f), parent(-1), available(true) {}
+	// position in the open heap or -1
+	int heapIndex;
+	// search that touched the waypoint last
+	uint32_t search;
+	bool closed;
+	WayPoint() : p(-1, -1), f(0.0f), h(0.0f), g(0.0f), parent(-1), index(-1), heapIndex(-1), search(0), closed(false) {}
 };
 
+// ---------------------------------------------------------------
+// APath
+//
+// A* on the eight connected grid with step costs of 10 and 14.
+// The open list is a binary heap and the waypoints are reset
+// lazily by a search counter so a search only touches the cells
+// it visits. The heuristic is the octile distance. With landmarks
+// the ALT bound is used if it is larger. Both are consistent so
+// a closed waypoint is never opened again.
+// ---------------------------------------------------------------
 class APath {
 
 public:
-	APath(Grid* grid);
+	APath(Grid* grid, Landmarks* landmarks = 0);
 	~APath();
 	int find(p2i start, p2i end, p2i* points, int max);
+	void setLandmarks(Landmarks* landmarks) {
+		_landmarks = landmarks;
+	}
+	// regions without a flow field, a search between two regions
+	// returns right away
+	void setRegions(RegionLabels* regions) {
+		_regions = regions;
+	}
 	int num() const {
 		return _numClosed;
 	}
@@ -25,24 +50,28 @@ public:
 		int idx = _closed[index];
 		return _internalGrid[idx].p;
 	}
+	// number of waypoints taken from the open list by the last search
+	int getNumExpanded() const {
+		return _numClosed;
+	}
 	void print();
 private:
 	void print(const WayPoint& wp);
 	void print(int index);
 	int getIndex(p2i p);
-	int moveNext(p2i p);
-	bool visited(int idx);
-	void close(p2i p);
-	int find(p2i p);
-	bool isOpen(int index);
-	void removeWaypoint(p2i p);
-	int findCheapest();
+	WayPoint& touch(int index);
+	bool less(int first, int second) const;
+	void push(int index);
+	int pop();
+	void siftUp(int pos);
+	void siftDown(int pos);
 	int getNeighbours(p2i p, int* result, int max);
-	float add(p2i p, float g = 0.0f, int parent = -1);
 	float calculateG(p2i first, p2i second);
 	float calculateG(int firstIndex, int secondIndex);
 	float calculateH(p2i p);
 	Grid* _grid;
+	Landmarks* _landmarks;
+	RegionLabels* _regions;
 	WayPoint* _internalGrid;
 	int _width;
 	int _height;
@@ -50,6 +79,7 @@ private:
 	int* _closed;
 	int _numOpen;
 	int _numClosed;
+	uint32_t _search;
 	p2i _start;
 	p2i _end;
-};
\ No newline at end of file
+};
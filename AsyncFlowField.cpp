@@ -0,0 +1,194 @@
+#include "AsyncFlowField.h"
+#include <ds_profiler.h>
+#include <string.h>
+
+// ---------------------------------------------------------------
+// ctor
+// ---------------------------------------------------------------
+AsyncFlowField::AsyncFlowField(Grid* grid) : _grid(grid), _front(0), _back(1), _building(false), _pending(false), _numCoalesced(0), _hasJob(false), _finished(false), _running(true) {
+	for (int i = 0; i < 2; ++i) {
+		_snapshots[i] = new Grid(_grid->width, _grid->height);
+		takeSnapshot(_snapshots[i]);
+		_fields[i] = new FlowField(_snapshots[i]);
+		_snapshots[i]->setTileCosts(_fields[i]->getTileCosts());
+	}
+	_front.store(_fields[0], std::memory_order_release);
+	_thread = std::thread(&AsyncFlowField::run, this);
+}
+
+// ---------------------------------------------------------------
+// dtor
+// ---------------------------------------------------------------
+AsyncFlowField::~AsyncFlowField() {
+	{
+		std::lock_guard<std::mutex> lock(_mutex);
+		_running = false;
+	}
+	_wakeUp.notify_all();
+	_thread.join();
+	for (int i = 0; i < 2; ++i) {
+		delete _fields[i];
+		delete _snapshots[i];
+	}
+}
+
+// ---------------------------------------------------------------
+// set connectivity
+// ---------------------------------------------------------------
+void AsyncFlowField::setConnectivity(FlowFieldConnectivity::Enum connectivity, CornerCutting::Enum cornerCutting) {
+	wait();
+	for (int i = 0; i < 2; ++i) {
+		_fields[i]->setConnectivity(connectivity, cornerCutting);
+	}
+	restart();
+}
+
+// ---------------------------------------------------------------
+// set method
+// ---------------------------------------------------------------
+void AsyncFlowField::setMethod(FlowFieldMethod::Enum method) {
+	wait();
+	for (int i = 0; i < 2; ++i) {
+		_fields[i]->setMethod(method);
+	}
+	restart();
+}
+
+// ---------------------------------------------------------------
+// set tile cost
+// ---------------------------------------------------------------
+void AsyncFlowField::setTileCost(int type, int cost) {
+	wait();
+	for (int i = 0; i < 2; ++i) {
+		_fields[i]->setTileCost(type, cost);
+	}
+	restart();
+}
+
+// ---------------------------------------------------------------
+// restart - a build that has finished with the old settings is
+// never published. The running build or the pending one that
+// replaces it anyway starts again on a new snapshot.
+// ---------------------------------------------------------------
+void AsyncFlowField::restart() {
+	if (!_building) {
+		return;
+	}
+	p2i end = _pending ? _pendingEnd : _end;
+	_pending = false;
+	start(end);
+}
+
+// ---------------------------------------------------------------
+// copy the cells of the grid
+// ---------------------------------------------------------------
+void AsyncFlowField::takeSnapshot(Grid* snapshot) {
+	memcpy(snapshot->items, _grid->items, _grid->width * _grid->height * sizeof(int));
+	snapshot->start = _grid->start;
+	snapshot->end = _grid->end;
+	snapshot->version = _grid->version;
+}
+
+// ---------------------------------------------------------------
+// build - synchronous build into the back field which is
+// published right away
+// ---------------------------------------------------------------
+void AsyncFlowField::build(const p2i& end) {
+	wait();
+	_building = false;
+	_pending = false;
+	_finished.store(false, std::memory_order_relaxed);
+	takeSnapshot(_snapshots[_back]);
+	_fields[_back]->build(end);
+	_front.store(_fields[_back], std::memory_order_release);
+	_back = 1 - _back;
+}
+
+// ---------------------------------------------------------------
+// request build - starts a build on the worker or remembers the
+// request if one is already running
+// ---------------------------------------------------------------
+void AsyncFlowField::requestBuild(const p2i& end) {
+	if (_building) {
+		if (_pending) {
+			++_numCoalesced;
+		}
+		_pending = true;
+		_pendingEnd = end;
+		return;
+	}
+	start(end);
+}
+
+// ---------------------------------------------------------------
+// start - the snapshot is taken on the calling thread so the
+// worker never touches the live grid
+// ---------------------------------------------------------------
+void AsyncFlowField::start(const p2i& end) {
+	takeSnapshot(_snapshots[_back]);
+	{
+		std::lock_guard<std::mutex> lock(_mutex);
+		_end = end;
+		_hasJob = true;
+		_finished.store(false, std::memory_order_relaxed);
+	}
+	_building = true;
+	_wakeUp.notify_all();
+}
+
+// ---------------------------------------------------------------
+// update - publishes a finished build and starts the pending one.
+// Returns true if the front field has changed.
+// ---------------------------------------------------------------
+bool AsyncFlowField::update() {
+	if (!_building || !_finished.load(std::memory_order_acquire)) {
+		return false;
+	}
+	_building = false;
+	_front.store(_fields[_back], std::memory_order_release);
+	_back = 1 - _back;
+	if (_pending) {
+		_pending = false;
+		start(_pendingEnd);
+	}
+	return true;
+}
+
+// ---------------------------------------------------------------
+// wait until the worker is idle. A finished build stays
+// unpublished.
+// ---------------------------------------------------------------
+void AsyncFlowField::wait() {
+	if (!_building) {
+		return;
+	}
+	std::unique_lock<std::mutex> lock(_mutex);
+	_done.wait(lock, [this] { return _finished.load(std::memory_order_acquire); });
+}
+
+// ---------------------------------------------------------------
+// worker thread
+// ---------------------------------------------------------------
+void AsyncFlowField::run() {
+	perf::setThreadName("flow field");
+	for (;;) {
+		p2i end;
+		FlowField* field = 0;
+		{
+			std::unique_lock<std::mutex> lock(_mutex);
+			_wakeUp.wait(lock, [this] { return !_running || _hasJob; });
+			if (!_running) {
+				return;
+			}
+			_hasJob = false;
+			end = _end;
+			field = _fields[_back];
+		}
+		field->build(end);
+		{
+			std::lock_guard<std::mutex> lock(_mutex);
+			_finished.store(true, std::memory_order_release);
+		}
+		_done.notify_all();
+	}
+}
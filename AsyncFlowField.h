@@ -0,0 +1,75 @@
+#pragma once
+#include "FlowField.h"
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+
+// ---------------------------------------------------------------
+// AsyncFlowField
+//
+// Two flow fields where one is built on a worker thread while the
+// other one is used. Every field is built on its own snapshot of
+// the grid that is taken when the build starts, so the game can
+// keep changing the grid. A finished build is only published by
+// update, which the game calls at the start of a tick, by swapping
+// the front pointer. Requests made while a build is running are
+// coalesced into one build that starts after the next publish.
+// build runs synchronously on the calling thread and drops any
+// running or pending request. The settings are applied to both
+// fields and restart a running build so a result of the old
+// settings is never published. The fields never use a job system
+// because the worker would share it with the main thread.
+// ---------------------------------------------------------------
+class AsyncFlowField {
+
+public:
+	AsyncFlowField(Grid* grid);
+	~AsyncFlowField();
+	void setConnectivity(FlowFieldConnectivity::Enum connectivity, CornerCutting::Enum cornerCutting);
+	void setMethod(FlowFieldMethod::Enum method);
+	void setTileCost(int type, int cost);
+	// both fields share the same costs, the table of the first one
+	// stays valid as long as the async field lives
+	const int* getTileCosts() const {
+		return _fields[0]->getTileCosts();
+	}
+	void build(const p2i& end);
+	void requestBuild(const p2i& end);
+	bool update();
+	void wait();
+	FlowField* get() const {
+		return _front.load(std::memory_order_acquire);
+	}
+	// a build is running or waiting to be started
+	bool isBusy() const {
+		return _building || _pending;
+	}
+	// number of requests merged into a later build
+	int getNumCoalesced() const {
+		return _numCoalesced;
+	}
+private:
+	AsyncFlowField(const AsyncFlowField& orig) {}
+	void run();
+	void start(const p2i& end);
+	void restart();
+	void takeSnapshot(Grid* snapshot);
+	Grid* _grid;
+	Grid* _snapshots[2];
+	FlowField* _fields[2];
+	std::atomic<FlowField*> _front;
+	int _back;
+	p2i _end;
+	p2i _pendingEnd;
+	bool _building;
+	bool _pending;
+	int _numCoalesced;
+	std::thread _thread;
+	std::mutex _mutex;
+	std::condition_variable _wakeUp;
+	std::condition_variable _done;
+	bool _hasJob;
+	std::atomic<bool> _finished;
+	bool _running;
+};
@@ -0,0 +1,426 @@
+#include "ConnectivityAnalyzer.h"
+#include "FlowField.h"
+#include "src/lib/LinearArena.h"
+#include <ds_profiler.h>
+#include <string.h>
+#include <algorithm>
+
+// ---------------------------------------------------------------
+// ctor
+// ---------------------------------------------------------------
+ConnectivityAnalyzer::ConnectivityAnalyzer(Grid* grid, FlowField* flowField) : _grid(grid), _flowField(flowField), _connected(false), _numBlocking(0), _numLengthening(0) {
+	_flags = new uint8_t[_grid->width * _grid->height];
+	memset(_flags, 0, _grid->width * _grid->height);
+}
+
+// ---------------------------------------------------------------
+// dtor
+// ---------------------------------------------------------------
+ConnectivityAnalyzer::~ConnectivityAnalyzer() {
+	delete[] _flags;
+}
+
+// ---------------------------------------------------------------
+// get neighbors of a cell by index
+// ---------------------------------------------------------------
+int ConnectivityAnalyzer::getNeighbors(int index, int* ret, int* steps) const {
+	return _flowField->getNeighbors(index % _grid->width, index / _grid->width, ret, steps, 8);
+}
+
+// ---------------------------------------------------------------
+// get corners - the passable corners of a step that disable it
+// when they are blocked. Orthogonal steps have none.
+// ---------------------------------------------------------------
+int ConnectivityAnalyzer::getCorners(int from, int to, int* corners) const {
+	int fx = from % _grid->width;
+	int fy = from / _grid->width;
+	int tx = to % _grid->width;
+	int ty = to / _grid->width;
+	if (fx == tx || fy == ty) {
+		return 0;
+	}
+	CornerCutting::Enum rule = _flowField->getCornerCutting();
+	if (rule == CornerCutting::ALLOWED) {
+		return 0;
+	}
+	bool first = _flowField->isPassable(tx, fy);
+	bool second = _flowField->isPassable(fx, ty);
+	int cnt = 0;
+	if (rule == CornerCutting::NEVER || !second) {
+		if (first) {
+			corners[cnt++] = tx + fy * _grid->width;
+		}
+	}
+	if (rule == CornerCutting::NEVER || !first) {
+		if (second) {
+			corners[cnt++] = fx + ty * _grid->width;
+		}
+	}
+	return cnt;
+}
+
+// ---------------------------------------------------------------
+// mark a cell
+// ---------------------------------------------------------------
+void ConnectivityAnalyzer::mark(int index, uint8_t flag) {
+	if ((_flags[index] & flag) == 0) {
+		_flags[index] |= flag;
+		if (flag == CELL_BLOCKING) {
+			++_numBlocking;
+		}
+		else {
+			++_numLengthening;
+		}
+	}
+}
+
+// ---------------------------------------------------------------
+// build
+// ---------------------------------------------------------------
+void ConnectivityAnalyzer::build(const p2i& start, const p2i& end) {
+	PERF_ZONE("ConnectivityAnalyzer::build");
+	memset(_flags, 0, _grid->width * _grid->height);
+	_numBlocking = 0;
+	_numLengthening = 0;
+	_connected = false;
+	if (!_flowField->isPassable(start.x, start.y) || !_flowField->isPassable(end.x, end.y)) {
+		return;
+	}
+	if (_flowField->getCost(start.x, start.y) == FLOW_FIELD_UNREACHABLE) {
+		return;
+	}
+	_connected = true;
+	int s = start.x + start.y * _grid->width;
+	int t = end.x + end.y * _grid->width;
+	mark(s, CELL_BLOCKING);
+	mark(t, CELL_BLOCKING);
+	mark(s, CELL_LENGTHENING);
+	mark(t, CELL_LENGTHENING);
+	findArticulations(s, t);
+	findCriticalCells(s, t);
+}
+
+// ---------------------------------------------------------------
+// find articulations - iterative Tarjan DFS from the start. A
+// cell v is blocking if the subtree of one of its children holds
+// the end and has no back edge above v. Everything discovered
+// after a child and before it is finished is in its subtree.
+// ---------------------------------------------------------------
+void ConnectivityAnalyzer::findArticulations(int start, int end) {
+	int total = _grid->width * _grid->height;
+	ds::LinearArena* arena = ds::getThreadArena();
+	ds::ArenaScope scope(arena);
+	int* disc = arena->allocArray<int>(total);
+	int* low = arena->allocArray<int>(total);
+	int* stack = arena->allocArray<int>(total);
+	int* next = arena->allocArray<int>(total);
+	int* counts = arena->allocArray<int>(total);
+	int* neighbors = arena->allocArray<int>(total * 8);
+	for (int i = 0; i < total; ++i) {
+		disc[i] = -1;
+	}
+	int steps[8];
+	int corners[2];
+	int time = 0;
+	int sp = 0;
+	int w = start;
+	for (;;) {
+		//
+		// visit w, its neighbors are kept with the stack entry
+		//
+		if (w != -1) {
+			disc[w] = low[w] = time++;
+			int* list = neighbors + sp * 8;
+			int cnt = getNeighbors(w, list, steps);
+			counts[sp] = 0;
+			for (int i = 0; i < cnt; ++i) {
+				if (getCorners(w, list[i], corners) == 0) {
+					list[counts[sp]++] = list[i];
+				}
+			}
+			next[sp] = 0;
+			stack[sp++] = w;
+		}
+		if (sp == 0) {
+			break;
+		}
+		int v = stack[sp - 1];
+		w = -1;
+		if (next[sp - 1] < counts[sp - 1]) {
+			int n = neighbors[(sp - 1) * 8 + next[sp - 1]++];
+			if (disc[n] == -1) {
+				w = n;
+			}
+			else if (disc[n] < low[v]) {
+				low[v] = disc[n];
+			}
+			continue;
+		}
+		--sp;
+		if (sp > 0) {
+			int p = stack[sp - 1];
+			if (low[v] < low[p]) {
+				low[p] = low[v];
+			}
+			if (low[v] >= disc[p] && disc[end] >= disc[v]) {
+				mark(p, CELL_BLOCKING);
+			}
+		}
+	}
+}
+
+// ---------------------------------------------------------------
+// is tight - the step from -> to is on a shortest path to the end
+// ---------------------------------------------------------------
+bool ConnectivityAnalyzer::isTight(const int* costs, int from, int to, int step) const {
+	if (costs[to] == FLOW_FIELD_UNREACHABLE) {
+		return false;
+	}
+	return costs[from] == costs[to] + step * _flowField->getCellCost(from % _grid->width, from / _grid->width);
+}
+
+// ---------------------------------------------------------------
+// find critical cells - the tight edges u -> w with cost(u) ==
+// cost(w) + step * tile cost(u) form the DAG of all shortest
+// paths. Blocking a cell removes the cell and the steps it is a
+// corner of, the footprint, and the cell is critical if every
+// path of the DAG touches it. See isCritical for the test.
+// ---------------------------------------------------------------
+void ConnectivityAnalyzer::findCriticalCells(int start, int end) {
+	int total = _grid->width * _grid->height;
+	ds::LinearArena* arena = ds::getThreadArena();
+	ds::ArenaScope scope(arena);
+	int* costs = arena->allocArray<int>(total);
+	uint8_t* inDag = arena->allocArray<uint8_t>(total);
+	int* queue = arena->allocArray<int>(total);
+	for (int i = 0; i < total; ++i) {
+		costs[i] = _flowField->getCost(i % _grid->width, i / _grid->width);
+		inDag[i] = 0;
+	}
+	int neighbors[8];
+	int steps[8];
+	int corners[2];
+	//
+	// collect the cells of the DAG and the smallest drop of a step
+	//
+	int num = 0;
+	int numEdges = 0;
+	int minDrop = 0;
+	queue[num++] = start;
+	inDag[start] = 1;
+	for (int head = 0; head < num; ++head) {
+		int u = queue[head];
+		int cnt = getNeighbors(u, neighbors, steps);
+		for (int i = 0; i < cnt; ++i) {
+			int w = neighbors[i];
+			if (isTight(costs, u, w, steps[i])) {
+				++numEdges;
+				if (minDrop == 0 || costs[u] - costs[w] < minDrop) {
+					minDrop = costs[u] - costs[w];
+				}
+				if (!inDag[w]) {
+					inDag[w] = 1;
+					queue[num++] = w;
+				}
+			}
+		}
+	}
+	if (num < 2 || minDrop <= 0) {
+		return;
+	}
+	int* levels = arena->allocArray<int>(num);
+	for (int i = 0; i < num; ++i) {
+		levels[i] = costs[queue[i]];
+	}
+	std::sort(levels, levels + num);
+	int numLevels = static_cast<int>(std::unique(levels, levels + num) - levels);
+	//
+	// count the edges crossing every gap and collect the steps
+	// that can be disabled by a corner
+	//
+	int* crossing = arena->allocArray<int>(numLevels + 1);
+	for (int i = 0; i <= numLevels; ++i) {
+		crossing[i] = 0;
+	}
+	CornerStep* cornerSteps = arena->allocArray<CornerStep>(numEdges * 2);
+	int numCornerSteps = 0;
+	for (int k = 0; k < num; ++k) {
+		int u = queue[k];
+		int lu = static_cast<int>(std::lower_bound(levels, levels + numLevels, costs[u]) - levels);
+		int cnt = getNeighbors(u, neighbors, steps);
+		for (int i = 0; i < cnt; ++i) {
+			int w = neighbors[i];
+			if (isTight(costs, u, w, steps[i])) {
+				int lw = static_cast<int>(std::lower_bound(levels, levels + numLevels, costs[w]) - levels);
+				++crossing[lw];
+				--crossing[lu];
+				int nc = getCorners(u, w, corners);
+				for (int j = 0; j < nc; ++j) {
+					CornerStep& cs = cornerSteps[numCornerSteps++];
+					cs.corner = corners[j];
+					cs.from = u;
+					cs.to = w;
+				}
+			}
+		}
+	}
+	for (int i = 1; i < numLevels; ++i) {
+		crossing[i] += crossing[i - 1];
+	}
+	std::sort(cornerSteps, cornerSteps + numCornerSteps, [](const CornerStep& a, const CornerStep& b) {
+		return a.corner < b.corner;
+	});
+	int* firstStep = arena->allocArray<int>(total);
+	int* numSteps = arena->allocArray<int>(total);
+	for (int i = 0; i < total; ++i) {
+		firstStep[i] = 0;
+		numSteps[i] = 0;
+	}
+	for (int i = 0; i < numCornerSteps; ++i) {
+		int c = cornerSteps[i].corner;
+		if (numSteps[c] == 0) {
+			firstStep[c] = i;
+		}
+		++numSteps[c];
+	}
+	DagState state;
+	state.costs = costs;
+	state.inDag = inDag;
+	state.levels = levels;
+	state.numLevels = numLevels;
+	state.crossing = crossing;
+	state.steps = cornerSteps;
+	state.firstStep = firstStep;
+	state.numSteps = numSteps;
+	state.minDrop = minDrop;
+	state.start = start;
+	state.end = end;
+	state.stack = arena->allocArray<int>(total);
+	state.stamps = arena->allocArray<uint32_t>(total);
+	state.stamp = 0;
+	for (int i = 0; i < total; ++i) {
+		state.stamps[i] = 0;
+	}
+	for (int c = 0; c < total; ++c) {
+		if (c != start && c != end && (inDag[c] || numSteps[c] > 0) && isCritical(state, c)) {
+			mark(c, CELL_LENGTHENING);
+		}
+	}
+}
+
+// ---------------------------------------------------------------
+// is critical - the footprint of the cell lies between the costs
+// lo and hi. Every path of the DAG enters the band below hi by
+// exactly one edge, the entry, and nothing above the band or below
+// it belongs to the footprint. So the cell is critical if no entry
+// reaches a cost below lo or the end without touching it. A path
+// drops at least minDrop per step, from an entry more than r cells
+// away it is below lo before it can get near the cell. Such an
+// entry exists if fewer entries than crossing edges are found
+// around the cell, otherwise the band is searched from the local
+// entries.
+// ---------------------------------------------------------------
+bool ConnectivityAnalyzer::isCritical(DagState& state, int cell) const {
+	const int* costs = state.costs;
+	int first = state.firstStep[cell];
+	int last = first + state.numSteps[cell];
+	int hi = -1;
+	int lo = -1;
+	if (state.inDag[cell]) {
+		hi = lo = costs[cell];
+	}
+	for (int i = first; i < last; ++i) {
+		const CornerStep& cs = state.steps[i];
+		if (hi == -1 || costs[cs.from] > hi) {
+			hi = costs[cs.from];
+		}
+		if (lo == -1 || costs[cs.to] < lo) {
+			lo = costs[cs.to];
+		}
+	}
+	int lh = static_cast<int>(std::lower_bound(state.levels, state.levels + state.numLevels, hi) - state.levels);
+	int r = (hi - lo) / state.minDrop + 1;
+	int expected = state.crossing[lh];
+	if (lh == state.numLevels - 1) {
+		++expected;
+	}
+	if (expected > 8 * (2 * r + 1) * (2 * r + 1)) {
+		return false;
+	}
+	//
+	// find the entries around the cell
+	//
+	int neighbors[8];
+	int steps[8];
+	int corners[2];
+	++state.stamp;
+	int sp = 0;
+	int found = 0;
+	int cx = cell % _grid->width;
+	int cy = cell / _grid->width;
+	int minX = std::max(cx - r, 0);
+	int maxX = std::min(cx + r, _grid->width - 1);
+	int minY = std::max(cy - r, 0);
+	int maxY = std::min(cy + r, _grid->height - 1);
+	for (int y = minY; y <= maxY; ++y) {
+		for (int x = minX; x <= maxX; ++x) {
+			int v = x + y * _grid->width;
+			if (!state.inDag[v] || costs[v] < lo || costs[v] > hi) {
+				continue;
+			}
+			int entries = v == state.start ? 1 : 0;
+			int cnt = getNeighbors(v, neighbors, steps);
+			for (int i = 0; i < cnt; ++i) {
+				int p = neighbors[i];
+				if (state.inDag[p] && costs[p] > hi && isTight(costs, p, v, steps[i])) {
+					++entries;
+				}
+			}
+			if (entries == 0) {
+				continue;
+			}
+			if (v == state.end) {
+				return false;
+			}
+			found += entries;
+			if (v != cell) {
+				state.stamps[v] = state.stamp;
+				state.stack[sp++] = v;
+			}
+		}
+	}
+	if (found != expected) {
+		return false;
+	}
+	//
+	// search the band from the entries around the footprint
+	//
+	while (sp > 0) {
+		int u = state.stack[--sp];
+		int cnt = getNeighbors(u, neighbors, steps);
+		for (int i = 0; i < cnt; ++i) {
+			int w = neighbors[i];
+			if (w == cell || !isTight(costs, u, w, steps[i])) {
+				continue;
+			}
+			int nc = getCorners(u, w, corners);
+			bool disabled = false;
+			for (int j = 0; j < nc; ++j) {
+				if (corners[j] == cell) {
+					disabled = true;
+				}
+			}
+			if (disabled) {
+				continue;
+			}
+			if (w == state.end || costs[w] < lo) {
+				return false;
+			}
+			if (state.stamps[w] != state.stamp) {
+				state.stamps[w] = state.stamp;
+				state.stack[sp++] = w;
+			}
+		}
+	}
+	return true;
+}
@@ -0,0 +1,105 @@
+#pragma once
+#include "src/Grid.h"
+
+class FlowField;
+
+// ---------------------------------------------------------------
+// flags of a cell
+// BLOCKING    : blocking the cell cuts the start from the end
+// LENGTHENING : blocking the cell makes the shortest path longer
+// ---------------------------------------------------------------
+const static uint8_t CELL_BLOCKING = 1;
+const static uint8_t CELL_LENGTHENING = 2;
+
+// ---------------------------------------------------------------
+// ConnectivityAnalyzer
+//
+// Answers for every cell whether placing a tower there would cut
+// the start from the end or make the shortest path longer. Build
+// runs once per grid change, the queries are a lookup.
+// Blocking cells are the articulation points between start and
+// end found by an iterative Tarjan DFS. A diagonal step that can
+// be disabled by blocking one of its corners is left out of the
+// DFS, the corner still connects both cells and removing the
+// corner removes the step as well, so the result is exact for all
+// corner cutting rules.
+// Lengthening cells are found on the DAG of the tight edges of
+// the flow field from the start. Blocking a cell removes the cell
+// and the diagonal steps it is a corner of. The cell is critical
+// if no path of the DAG avoids all of them. The test is exact and
+// only searches the few cost levels around the cell.
+// The flow field has to be built towards the end with exact
+// integer costs, so DIJKSTRA or PARALLEL_BFS. Tile costs are read
+// from the grid of the flow field, which can be a snapshot.
+// ---------------------------------------------------------------
+class ConnectivityAnalyzer {
+
+	// a diagonal step of the DAG and a corner that disables it
+	struct CornerStep {
+		int corner;
+		int from;
+		int to;
+	};
+
+	// temporary data of the search for critical cells
+	struct DagState {
+		const int* costs;
+		const uint8_t* inDag;
+		const int* levels;
+		int numLevels;
+		// number of edges crossing the gap above every level
+		const int* crossing;
+		const CornerStep* steps;
+		// first corner step and number of steps of every cell
+		const int* firstStep;
+		const int* numSteps;
+		// smallest cost difference of a tight edge
+		int minDrop;
+		int start;
+		int end;
+		int* stack;
+		uint32_t* stamps;
+		uint32_t stamp;
+	};
+
+public:
+	ConnectivityAnalyzer(Grid* grid, FlowField* flowField);
+	~ConnectivityAnalyzer();
+	void build(const p2i& start, const p2i& end);
+	void setFlowField(FlowField* flowField) {
+		_flowField = flowField;
+	}
+	bool isConnected() const {
+		return _connected;
+	}
+	bool isBlocking(int x, int y) const {
+		return (_flags[x + y * _grid->width] & CELL_BLOCKING) != 0;
+	}
+	bool isLengthening(int x, int y) const {
+		return (_flags[x + y * _grid->width] & CELL_LENGTHENING) != 0;
+	}
+	uint8_t get(int x, int y) const {
+		return _flags[x + y * _grid->width];
+	}
+	int getNumBlocking() const {
+		return _numBlocking;
+	}
+	int getNumLengthening() const {
+		return _numLengthening;
+	}
+private:
+	ConnectivityAnalyzer(const ConnectivityAnalyzer& orig) {}
+	int getCorners(int from, int to, int* corners) const;
+	int getNeighbors(int index, int* ret, int* steps) const;
+	void mark(int index, uint8_t flag);
+	void findArticulations(int start, int end);
+	void findCriticalCells(int start, int end);
+	bool isTight(const int* costs, int from, int to, int step) const;
+	bool isCritical(DagState& state, int cell) const;
+	Grid* _grid;
+	FlowField* _flowField;
+	uint8_t* _flags;
+	bool _connected;
+	int _numBlocking;
+	int _numLengthening;
+};
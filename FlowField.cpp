@@ -1,5 +1,16 @@
 #include "FlowField.h"
-#include <list>
+#include "src/lib/LinearArena.h"
+#include "src/lib/JobSystem.h"
+#include <ds_profiler.h>
+#include <string.h>
+#include <math.h>
+#include <atomic>
+#include <new>
+#include <bitset>
+#include <functional>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
 
 // the directions are:
 //  321
@@ -8,63 +19,225 @@
 //
 const p2i DIRECTIONS[] = { p2i(1,0),p2i(1,1),p2i(0,1),p2i(-1,1),p2i(-1,0),p2i(-1,-1),p2i(0,-1),p2i(1,-1) };
 
-FlowField::FlowField(Grid* grid) : _grid(grid) {
-	_fields = new int[_grid->width * _grid->height];
-	_dir = new int[_grid->width * _grid->height];
+// octile step costs of the eight way integration
+const int ORTHOGONAL_STEP = 10;
+const int DIAGONAL_STEP = 14;
+
+// smaller improvements do not count as a change of the eikonal field
+const float EIKONAL_TOLERANCE = 1e-3f;
+
+// ---------------------------------------------------------------
+// run on the job system if there is one. The job system only
+// gets a reference to the function so the captures of the
+// lambda are never copied to the heap. Without one the chunks run
+// in order on the calling thread, a range is never larger than
+// the chunk size either way.
+// ---------------------------------------------------------------
+template<class F>
+static void runParallel(ds::JobSystem* jobs, int count, int chunkSize, const F& fn) {
+	if (jobs != 0) {
+		jobs->parallelFor(count, chunkSize, std::cref(fn));
+		return;
+	}
+	for (int begin = 0; begin < count; begin += chunkSize) {
+		int end = begin + chunkSize;
+		fn(begin, end < count ? end : count, 0);
+	}
+}
+
+// ---------------------------------------------------------------
+// index of the lowest set bit
+// ---------------------------------------------------------------
+static inline int lowestBit(uint64_t v) {
+#ifdef _MSC_VER
+	unsigned long idx = 0;
+	_BitScanForward64(&idx, v);
+	return static_cast<int>(idx);
+#else
+	return __builtin_ctzll(v);
+#endif
+}
+
+static inline bool testBit(const uint64_t* bits, int idx) {
+	return (bits[idx >> 6] & (1ULL << (idx & 63))) != 0;
+}
+
+FlowField::FlowField(Grid* grid) : _maxTileCost(1) , _connectivity(FlowFieldConnectivity::FOUR_WAY) , _cornerCutting(CornerCutting::ALLOWED) , _method(FlowFieldMethod::DIJKSTRA) , _jobs(0) , _distance(0) , _flow(0) , _numRounds(0) , _numChanged(0) , _numExpanded(0) , _version(0) , _grid(grid) {
+	//
+	// the default costs match Grid::isAvailable: empty, start and
+	// end cost 1 and everything else is blocked
+	//
+	for (int i = 0; i < MAX_TILE_TYPES; ++i) {
+		_tileCosts[i] = 0;
+	}
+	_tileCosts[0] = 1;
+	_tileCosts[2] = 1;
+	_tileCosts[3] = 1;
+	int total = _grid->width * _grid->height;
+	_fields = new int[total];
+	_dir = new int[total];
+	_changed = new int[total];
+	for (int i = 0; i < total; ++i) {
+		_dir[i] = -1;
+	}
 }
 
 FlowField::~FlowField() {
+	delete[] _flow;
+	delete[] _distance;
+	delete[] _changed;
 	delete[] _dir;
 	delete[] _fields;
 }
 
 // -------------------------------------------------------------
-// Checks whether the index is already in the list
+// set connectivity and corner cutting. The field needs to be
+// rebuilt.
+// -------------------------------------------------------------
+void FlowField::setConnectivity(FlowFieldConnectivity::Enum connectivity, CornerCutting::Enum cornerCutting) {
+	_connectivity = connectivity;
+	_cornerCutting = cornerCutting;
+}
+
+// -------------------------------------------------------------
+// set the build method. The jobs are used by the eikonal sweeps,
+// without them everything runs on the calling thread.
+// -------------------------------------------------------------
+void FlowField::setMethod(FlowFieldMethod::Enum method, ds::JobSystem* jobs) {
+	_method = method;
+	_jobs = jobs;
+	if (_method == FlowFieldMethod::EIKONAL && _distance == 0) {
+		int total = _grid->width * _grid->height;
+		_distance = new float[total];
+		_flow = new ds::vec2[total];
+	}
+}
+
+// -------------------------------------------------------------
+// set the cost of a tile type. The field needs to be rebuilt.
 // -------------------------------------------------------------
-bool FlowField::checkIfContains(unsigned int idx, const std::list<unsigned int>& lst) const {
-	std::list<unsigned int>::const_iterator it = lst.begin();
-	while (it != lst.end()) {
-		if (*it == idx) {
-			return true;
+void FlowField::setTileCost(int type, int cost) {
+	if (type >= 0 && type < MAX_TILE_TYPES) {
+		if (cost < 0) {
+			cost = 0;
+		}
+		if (cost > MAX_TILE_COST) {
+			cost = MAX_TILE_COST;
+		}
+		_tileCosts[type] = cost;
+		_maxTileCost = 1;
+		for (int i = 0; i < MAX_TILE_TYPES; ++i) {
+			if (_tileCosts[i] > _maxTileCost) {
+				_maxTileCost = _tileCosts[i];
+			}
 		}
-		++it;
+	}
+}
+
+// -------------------------------------------------------------
+// get tile cost
+// -------------------------------------------------------------
+int FlowField::getTileCost(int type) const {
+	if (type >= 0 && type < MAX_TILE_TYPES) {
+		return _tileCosts[type];
+	}
+	return 0;
+}
+
+// -------------------------------------------------------------
+// is passable - valid and not blocked by the cost table
+// -------------------------------------------------------------
+bool FlowField::isPassable(int x, int y) const {
+	if (_grid->isValid(x, y)) {
+		return getTileCost(_grid->get(x, y)) > 0;
 	}
 	return false;
 }
 
 // -------------------------------------------------------------
-// get neighbors (N, S, W and E). Will return the indices
+// cell cost - the tile cost of a cell or 0 outside the grid
+// -------------------------------------------------------------
+int FlowField::getCellCost(int x, int y) const {
+	if (_grid->isValid(x, y)) {
+		return getTileCost(_grid->get(x, y));
+	}
+	return 0;
+}
+
+// -------------------------------------------------------------
+// can a diagonal step in the given direction be taken
 // -------------------------------------------------------------
-int FlowField::getNeighbors(int x, int y, int * ret, int max) {
+bool FlowField::isDiagonalAllowed(int x, int y, const p2i& dir) const {
+	if (_cornerCutting == CornerCutting::ALLOWED) {
+		return true;
+	}
+	bool first = isPassable(x + dir.x, y);
+	bool second = isPassable(x, y + dir.y);
+	if (_cornerCutting == CornerCutting::NO_SQUEEZE) {
+		return first || second;
+	}
+	return first && second;
+}
+
+// -------------------------------------------------------------
+// get neighbors (N, S, W and E and the diagonals in eight way
+// mode). Will return the indices and the step costs.
+// -------------------------------------------------------------
+int FlowField::getNeighbors(int x, int y, int * ret, int* steps, int max) const {
 	int cnt = 0;
-	if (_grid->isValid(x, y - 1) && _grid->isAvailable(x, y - 1)) {
+	if (_connectivity == FlowFieldConnectivity::EIGHT_WAY) {
+		for (int i = 0; i < 8 && cnt < max; ++i) {
+			const p2i& d = DIRECTIONS[i];
+			if (isPassable(x + d.x, y + d.y)) {
+				bool diagonal = (i & 1) == 1;
+				if (!diagonal || isDiagonalAllowed(x, y, d)) {
+					steps[cnt] = diagonal ? DIAGONAL_STEP : ORTHOGONAL_STEP;
+					ret[cnt++] = x + d.x + (y + d.y) * _grid->width;
+				}
+			}
+		}
+		return cnt;
+	}
+	if (isPassable(x, y - 1)) {
+		steps[cnt] = 1;
 		ret[cnt++] = x + (y - 1) * _grid->width;
 	}
-	if (_grid->isValid(x, y + 1) && _grid->isAvailable(x, y + 1)) {
+	if (isPassable(x, y + 1)) {
+		steps[cnt] = 1;
 		ret[cnt++] = x + (y + 1) * _grid->width;
 	}
-	if (_grid->isValid(x - 1, y) && _grid->isAvailable(x - 1, y)) {
+	if (isPassable(x - 1, y)) {
+		steps[cnt] = 1;
 		ret[cnt++] = x - 1 + y * _grid->width;
 	}
-	if (_grid->isValid(x + 1, y) && _grid->isAvailable(x + 1, y)) {
+	if (isPassable(x + 1, y)) {
+		steps[cnt] = 1;
 		ret[cnt++] = x + 1 + y * _grid->width;
 	}
 	return cnt;
 }
 
 // -------------------------------------------------------------
-// find the index of the neighbor with the lowest cost
+// find the index of the neighbor with the lowest cost. In eight
+// way mode the step to the neighbor is part of the cost so a
+// diagonal only wins if it is really shorter.
 // -------------------------------------------------------------
 int FlowField::findLowestCost(int x, int y) {
-	int m = 255;
+	int m = FLOW_FIELD_UNREACHABLE;
 	int ret = 14;
+	int tileCost = getTileCost(_grid->get(x, y));
 	for (int i = 0; i < 8; ++i) {
 		p2i c = p2i(x, y) + DIRECTIONS[i];
-		if (_grid->isAvailable(c.x, c.y)) {
+		bool diagonal = (i & 1) == 1;
+		if (isPassable(c.x, c.y) && (!diagonal || isDiagonalAllowed(x, y, DIRECTIONS[i]))) {
 			int idx = c.x + c.y * _grid->width;
-			if (_fields[idx] < m) {
+			int cost = _fields[idx];
+			if (cost != FLOW_FIELD_UNREACHABLE && _connectivity == FlowFieldConnectivity::EIGHT_WAY) {
+				cost += (diagonal ? DIAGONAL_STEP : ORTHOGONAL_STEP) * tileCost;
+			}
+			if (cost < m) {
 				ret = i;
-				m = _fields[idx];
+				m = cost;
 			}
 		}
 	}
@@ -72,13 +245,12 @@ int FlowField::findLowestCost(int x, int y) {
 }
 
 // -------------------------------------------------------------
-// reset fields and directions
+// reset fields
 // -------------------------------------------------------------
 void FlowField::resetFields() {
 	int total = _grid->width * _grid->height;
 	for (int i = 0; i < total; ++i) {
-		_fields[i] = 255;
-		_dir[i] = -1;
+		_fields[i] = FLOW_FIELD_UNREACHABLE;
 	}
 }
 
@@ -86,43 +258,526 @@ void FlowField::resetFields() {
 // build the flow field
 // -------------------------------------------------------------
 void FlowField::build(const p2i & end) {
+	PERF_ZONE("FlowField::build");
 	_end = end;
-	// simple Dijstra flood fill first
-	unsigned int targetID = end.y * _grid->width + end.x;
+	int targetID = end.y * _grid->width + end.x;
 	resetFields();
-	std::list<unsigned int> openList;
+	if (_method == FlowFieldMethod::EIKONAL) {
+		integrateEikonal(targetID);
+	}
+	else if (_method != FlowFieldMethod::PARALLEL_BFS || !integrateParallel(targetID)) {
+		integrate(targetID);
+	}
+	buildDirections();
+	++_version;
+}
+
+// -------------------------------------------------------------
+// integrate - Dijkstra with a bucket queue (Dial). The cost of a
+// step is the step cost times the cost of the tile that is left
+// so no pending cell is more than maxStep * _maxTileCost ahead of
+// the current one. That many + 1 buckets used as a ring are
+// enough. Every bucket is a doubly linked list threaded through
+// the cells so a cell can be moved to another bucket in constant
+// time when its cost drops. All lists are taken from the thread
+// arena.
+// -------------------------------------------------------------
+void FlowField::integrate(int targetID) {
+	int total = _grid->width * _grid->height;
+	int maxStep = _connectivity == FlowFieldConnectivity::EIGHT_WAY ? DIAGONAL_STEP : 1;
+	int numBuckets = maxStep * _maxTileCost + 1;
+	ds::LinearArena* arena = ds::getThreadArena();
+	ds::ArenaScope scope(arena);
+	int* buckets = arena->allocArray<int>(numBuckets);
+	int* next = arena->allocArray<int>(total);
+	int* prev = arena->allocArray<int>(total);
+	uint8_t* queued = arena->allocArray<uint8_t>(total);
+	for (int i = 0; i < numBuckets; ++i) {
+		buckets[i] = -1;
+	}
+	memset(queued, 0, total);
 	_fields[targetID] = 0;
-	openList.push_back(targetID);
-	int neighbors[4];
-	while (openList.size() > 0)	{
-		unsigned currentID = openList.front();
-		openList.pop_front();
-		unsigned short currentX = currentID % _grid->width;
-		unsigned short currentY = currentID / _grid->width;
-		int neighborCount = getNeighbors(currentX, currentY, neighbors, 4);
-		for (int i = 0; i < neighborCount; ++i) {             
-			unsigned int endNodeCost = _fields[currentID] + 1;
-			if (endNodeCost < _fields[neighbors[i]]) {
-				if (!checkIfContains(neighbors[i], openList)) {
-					openList.push_back(neighbors[i]);
+	buckets[0] = targetID;
+	next[targetID] = -1;
+	prev[targetID] = -1;
+	queued[targetID] = 1;
+	int numOpen = 1;
+	int current = 0;
+	int neighbors[8];
+	int steps[8];
+	_numExpanded = 0;
+	while (numOpen > 0) {
+		while (buckets[current % numBuckets] == -1) {
+			++current;
+		}
+		int bucket = current % numBuckets;
+		int currentID = buckets[bucket];
+		buckets[bucket] = next[currentID];
+		if (next[currentID] != -1) {
+			prev[next[currentID]] = -1;
+		}
+		queued[currentID] = 0;
+		--numOpen;
+		++_numExpanded;
+		int currentX = currentID % _grid->width;
+		int currentY = currentID / _grid->width;
+		int neighborCount = getNeighbors(currentX, currentY, neighbors, steps, 8);
+		for (int i = 0; i < neighborCount; ++i) {
+			int n = neighbors[i];
+			int cost = _fields[currentID] + steps[i] * _tileCosts[_grid->items[n]];
+			if (cost < _fields[n]) {
+				if (queued[n]) {
+					// unlink from the bucket of the old cost
+					if (prev[n] != -1) {
+						next[prev[n]] = next[n];
+					}
+					else {
+						buckets[_fields[n] % numBuckets] = next[n];
+					}
+					if (next[n] != -1) {
+						prev[next[n]] = prev[n];
+					}
+				}
+				else {
+					queued[n] = 1;
+					++numOpen;
+				}
+				_fields[n] = cost;
+				int b = cost % numBuckets;
+				prev[n] = -1;
+				next[n] = buckets[b];
+				if (buckets[b] != -1) {
+					prev[buckets[b]] = n;
 				}
-				_fields[neighbors[i]] = endNodeCost;
+				buckets[b] = n;
+			}
+		}
+	}
+}
+
+// -------------------------------------------------------------
+// get uniform cost - true if all passable tiles cost the same
+// -------------------------------------------------------------
+bool FlowField::getUniformCost(int* cost) const {
+	*cost = 0;
+	for (int i = 0; i < MAX_TILE_TYPES; ++i) {
+		if (_tileCosts[i] != 0) {
+			if (*cost != 0 && *cost != _tileCosts[i]) {
+				return false;
 			}
+			*cost = _tileCosts[i];
 		}
+	}
+	return *cost != 0;
+}
 
+// -------------------------------------------------------------
+// integrate parallel - level synchronous BFS. Top-down steps
+// expand the frontier queue in chunks. A cell is claimed with an
+// atomic fetch_or on the visited bitmap. All cells of a level get
+// the same cost so the claim is the atomic min of the cost. Every
+// chunk reserves its range of the next frontier with one atomic
+// add. Bottom-up steps let every unvisited cell look for a parent
+// in the frontier bitmap. They work on whole bitmap words so they
+// need no atomics at all. Returns false if the field can not be
+// built this way.
+// -------------------------------------------------------------
+bool FlowField::integrateParallel(int targetID) {
+	int cost = 0;
+	if (_connectivity != FlowFieldConnectivity::FOUR_WAY || !getUniformCost(&cost)) {
+		return false;
 	}
-	// now calculate the directions
-	for (int x = 0; x < _grid->width; ++x) {
-		for (int y = 0; y < _grid->height; ++y) {
-			if (_grid->isAvailable(x, y)) {
-				_dir[x + _grid->width * y] = findLowestCost(x, y);
+	int w = _grid->width;
+	int h = _grid->height;
+	int total = w * h;
+	int numWords = (total + 63) / 64;
+	ds::LinearArena* arena = ds::getThreadArena();
+	ds::ArenaScope scope(arena);
+	uint64_t* passable = arena->allocArray<uint64_t>(numWords);
+	uint64_t* frontierBits = arena->allocArray<uint64_t>(numWords);
+	uint64_t* nextBits = arena->allocArray<uint64_t>(numWords);
+	std::atomic<uint64_t>* visited = static_cast<std::atomic<uint64_t>*>(arena->alloc(numWords * sizeof(std::atomic<uint64_t>)));
+	int* frontier = arena->allocArray<int>(total);
+	int* next = arena->allocArray<int>(total);
+	std::atomic<int> numPassable(0);
+	runParallel(_jobs, numWords, BFS_CHUNK_SIZE, [&](int begin, int end, int worker) {
+		int cnt = 0;
+		for (int i = begin; i < end; ++i) {
+			uint64_t bits = 0;
+			int last = (i + 1) * 64 < total ? 64 : total - i * 64;
+			for (int b = 0; b < last; ++b) {
+				int type = _grid->items[i * 64 + b];
+				if (type >= 0 && type < MAX_TILE_TYPES && _tileCosts[type] != 0) {
+					bits |= 1ULL << b;
+				}
+			}
+			passable[i] = bits;
+			new (&visited[i]) std::atomic<uint64_t>(0);
+			cnt += static_cast<int>(std::bitset<64>(bits).count());
+		}
+		numPassable += cnt;
+	});
+	_fields[targetID] = 0;
+	visited[targetID >> 6] |= 1ULL << (targetID & 63);
+	frontier[0] = targetID;
+	int numFrontier = 1;
+	int remaining = numPassable - 1;
+	int level = 0;
+	bool bottomUp = false;
+	_numExpanded = 0;
+	while (numFrontier > 0) {
+		if (!bottomUp && numFrontier > remaining / BFS_ALPHA) {
+			memset(frontierBits, 0, numWords * sizeof(uint64_t));
+			for (int i = 0; i < numFrontier; ++i) {
+				frontierBits[frontier[i] >> 6] |= 1ULL << (frontier[i] & 63);
+			}
+			bottomUp = true;
+		}
+		else if (bottomUp && numFrontier < total / BFS_BETA) {
+			numFrontier = 0;
+			for (int i = 0; i < numWords; ++i) {
+				uint64_t bits = frontierBits[i];
+				while (bits != 0) {
+					frontier[numFrontier++] = i * 64 + lowestBit(bits);
+					bits &= bits - 1;
+				}
+			}
+			bottomUp = false;
+		}
+		_numExpanded += numFrontier;
+		int levelCost = (level + 1) * cost;
+		std::atomic<int> numNext(0);
+		if (bottomUp) {
+			runParallel(_jobs, numWords, BFS_CHUNK_SIZE, [&](int begin, int end, int worker) {
+				int cnt = 0;
+				for (int i = begin; i < end; ++i) {
+					uint64_t candidates = passable[i] & ~visited[i].load(std::memory_order_relaxed);
+					uint64_t found = 0;
+					while (candidates != 0) {
+						int bit = lowestBit(candidates);
+						candidates &= candidates - 1;
+						int idx = i * 64 + bit;
+						int x = idx % w;
+						int y = idx / w;
+						if ((x > 0 && testBit(frontierBits, idx - 1)) || (x < w - 1 && testBit(frontierBits, idx + 1))
+							|| (y > 0 && testBit(frontierBits, idx - w)) || (y < h - 1 && testBit(frontierBits, idx + w))) {
+							_fields[idx] = levelCost;
+							found |= 1ULL << bit;
+							++cnt;
+						}
+					}
+					nextBits[i] = found;
+					if (found != 0) {
+						visited[i].fetch_or(found, std::memory_order_relaxed);
+					}
+				}
+				numNext += cnt;
+			});
+			uint64_t* tmp = frontierBits;
+			frontierBits = nextBits;
+			nextBits = tmp;
+		}
+		else {
+			runParallel(_jobs, numFrontier, BFS_CHUNK_SIZE, [&](int begin, int end, int worker) {
+				int found[BFS_CHUNK_SIZE * 4];
+				int cnt = 0;
+				for (int i = begin; i < end; ++i) {
+					int current = frontier[i];
+					int x = current % w;
+					int y = current / w;
+					int neighbors[4];
+					int numNeighbors = 0;
+					if (y > 0) {
+						neighbors[numNeighbors++] = current - w;
+					}
+					if (y < h - 1) {
+						neighbors[numNeighbors++] = current + w;
+					}
+					if (x > 0) {
+						neighbors[numNeighbors++] = current - 1;
+					}
+					if (x < w - 1) {
+						neighbors[numNeighbors++] = current + 1;
+					}
+					for (int j = 0; j < numNeighbors; ++j) {
+						int n = neighbors[j];
+						uint64_t mask = 1ULL << (n & 63);
+						if ((passable[n >> 6] & mask) != 0 && (visited[n >> 6].load(std::memory_order_relaxed) & mask) == 0) {
+							uint64_t prev = visited[n >> 6].fetch_or(mask, std::memory_order_relaxed);
+							if ((prev & mask) == 0) {
+								_fields[n] = levelCost;
+								found[cnt++] = n;
+							}
+						}
+					}
+				}
+				int offset = numNext.fetch_add(cnt);
+				memcpy(next + offset, found, cnt * sizeof(int));
+			});
+			int* tmp = frontier;
+			frontier = next;
+			next = tmp;
+		}
+		numFrontier = numNext;
+		remaining -= numFrontier;
+		++level;
+	}
+	return true;
+}
+
+// -------------------------------------------------------------
+// integrate eikonal - fast sweeping in the four diagonal orders
+// until nothing changes anymore. Only blocks that changed or
+// have a changed neighbor are swept again. A block without a
+// change is a fixed point and stays one until a neighbor changes.
+// -------------------------------------------------------------
+void FlowField::integrateEikonal(int targetID) {
+	int total = _grid->width * _grid->height;
+	ds::LinearArena* arena = ds::getThreadArena();
+	ds::ArenaScope scope(arena);
+	SweepState state;
+	state.blocksX = (_grid->width + EIKONAL_BLOCK_SIZE - 1) / EIKONAL_BLOCK_SIZE;
+	state.blocksY = (_grid->height + EIKONAL_BLOCK_SIZE - 1) / EIKONAL_BLOCK_SIZE;
+	int numBlocks = state.blocksX * state.blocksY;
+	float* slowness = arena->allocArray<float>(total);
+	state.slowness = slowness;
+	state.active = arena->allocArray<uint8_t>(numBlocks);
+	state.changed = arena->allocArray<uint8_t>(numBlocks);
+	for (int i = 0; i < total; ++i) {
+		_distance[i] = EIKONAL_INFINITY;
+		slowness[i] = static_cast<float>(getTileCost(_grid->items[i]));
+	}
+	_distance[targetID] = 0.0f;
+	memset(state.active, 1, numBlocks);
+	_numRounds = 0;
+	_numExpanded = 0;
+	bool changed = true;
+	while (changed && _numRounds < MAX_EIKONAL_ROUNDS) {
+		PERF_ZONE("FlowField::sweep");
+		changed = false;
+		for (int i = 0; i < 4; ++i) {
+			int sx = (i == 0 || i == 3) ? 1 : -1;
+			int sy = i < 2 ? 1 : -1;
+			memset(state.changed, 0, numBlocks);
+			if (sweep(state, sx, sy)) {
+				changed = true;
+			}
+			for (int by = 0; by < state.blocksY; ++by) {
+				for (int bx = 0; bx < state.blocksX; ++bx) {
+					int b = bx + by * state.blocksX;
+					state.active[b] = state.changed[b]
+						|| (bx > 0 && state.changed[b - 1])
+						|| (bx < state.blocksX - 1 && state.changed[b + 1])
+						|| (by > 0 && state.changed[b - state.blocksX])
+						|| (by < state.blocksY - 1 && state.changed[b + state.blocksX]);
+				}
+			}
+		}
+		++_numRounds;
+	}
+	if (changed) {
+		integrateFallback(targetID);
+		return;
+	}
+	for (int i = 0; i < total; ++i) {
+		if (_distance[i] < EIKONAL_INFINITY) {
+			_fields[i] = static_cast<int>(_distance[i] * ORTHOGONAL_STEP + 0.5f);
+		}
+	}
+	buildFlowVectors();
+}
+
+// -------------------------------------------------------------
+// integrate fallback - the sweeps did not converge within
+// MAX_EIKONAL_ROUNDS, a path with more bends has not arrived
+// everywhere yet. The eight way integration without corner
+// cutting reaches the same cells as the four point stencil of the
+// sweeps and has the same scale, so it replaces the field.
+// -------------------------------------------------------------
+void FlowField::integrateFallback(int targetID) {
+	FlowFieldConnectivity::Enum connectivity = _connectivity;
+	CornerCutting::Enum cornerCutting = _cornerCutting;
+	_connectivity = FlowFieldConnectivity::EIGHT_WAY;
+	_cornerCutting = CornerCutting::NEVER;
+	int expanded = _numExpanded;
+	resetFields();
+	integrate(targetID);
+	_numExpanded += expanded;
+	_connectivity = connectivity;
+	_cornerCutting = cornerCutting;
+	int total = _grid->width * _grid->height;
+	for (int i = 0; i < total; ++i) {
+		if (_fields[i] != FLOW_FIELD_UNREACHABLE) {
+			_distance[i] = static_cast<float>(_fields[i]) / ORTHOGONAL_STEP;
+		}
+		else {
+			_distance[i] = EIKONAL_INFINITY;
+		}
+	}
+	buildFlowVectors();
+}
+
+// -------------------------------------------------------------
+// sweep - one Gauss-Seidel pass in the given order. A block only
+// depends on the blocks before it in x and y, so all blocks on
+// one anti-diagonal are independent and run in parallel.
+// -------------------------------------------------------------
+bool FlowField::sweep(SweepState& state, int sx, int sy) {
+	int bw = state.blocksX;
+	int bh = state.blocksY;
+	std::atomic<int> changed(0);
+	std::atomic<int> visited(0);
+	for (int k = 0; k < bw + bh - 1; ++k) {
+		int first = k - (bh - 1) > 0 ? k - (bh - 1) : 0;
+		int last = k < bw - 1 ? k : bw - 1;
+		auto fn = [&](int begin, int end, int worker) {
+			for (int i = begin; i < end; ++i) {
+				int bx = sx > 0 ? first + i : bw - 1 - (first + i);
+				int by = sy > 0 ? k - (first + i) : bh - 1 - (k - (first + i));
+				int b = bx + by * bw;
+				if (state.active[b]) {
+					visited += 1;
+					if (sweepBlock(state, bx, by, sx, sy)) {
+						state.changed[b] = 1;
+						changed = 1;
+					}
+				}
+			}
+		};
+		runParallel(_jobs, last - first + 1, 1, fn);
+	}
+	_numExpanded += visited * EIKONAL_BLOCK_SIZE * EIKONAL_BLOCK_SIZE;
+	return changed != 0;
+}
+
+// -------------------------------------------------------------
+// sweep block - Godunov upwind update of every cell
+// -------------------------------------------------------------
+bool FlowField::sweepBlock(const SweepState& state, int bx, int by, int sx, int sy) {
+	int w = _grid->width;
+	int h = _grid->height;
+	int x0 = bx * EIKONAL_BLOCK_SIZE;
+	int y0 = by * EIKONAL_BLOCK_SIZE;
+	int nx = x0 + EIKONAL_BLOCK_SIZE < w ? EIKONAL_BLOCK_SIZE : w - x0;
+	int ny = y0 + EIKONAL_BLOCK_SIZE < h ? EIKONAL_BLOCK_SIZE : h - y0;
+	bool changed = false;
+	for (int j = 0; j < ny; ++j) {
+		int y = sy > 0 ? y0 + j : y0 + ny - 1 - j;
+		for (int i = 0; i < nx; ++i) {
+			int x = sx > 0 ? x0 + i : x0 + nx - 1 - i;
+			int idx = x + y * w;
+			float f = state.slowness[idx];
+			if (f == 0.0f) {
+				continue;
+			}
+			float a = EIKONAL_INFINITY;
+			if (x > 0 && _distance[idx - 1] < a) {
+				a = _distance[idx - 1];
+			}
+			if (x < w - 1 && _distance[idx + 1] < a) {
+				a = _distance[idx + 1];
+			}
+			float b = EIKONAL_INFINITY;
+			if (y > 0 && _distance[idx - w] < b) {
+				b = _distance[idx - w];
+			}
+			if (y < h - 1 && _distance[idx + w] < b) {
+				b = _distance[idx + w];
+			}
+			if (a >= EIKONAL_INFINITY && b >= EIKONAL_INFINITY) {
+				continue;
+			}
+			float t = 0.0f;
+			float diff = a - b;
+			if (fabs(diff) >= f) {
+				t = (a < b ? a : b) + f;
 			}
 			else {
-				_dir[x + _grid->width * y] = 16;
+				t = (a + b + sqrtf(2.0f * f * f - diff * diff)) * 0.5f;
+			}
+			float current = _distance[idx];
+			if (t < current) {
+				_distance[idx] = t;
+				if (current - t > EIKONAL_TOLERANCE) {
+					changed = true;
+				}
 			}
 		}
 	}
+	return changed;
+}
 
+// -------------------------------------------------------------
+// build flow vectors - the normalized upwind gradient pointing
+// to the lower distance
+// -------------------------------------------------------------
+void FlowField::buildFlowVectors() {
+	int w = _grid->width;
+	int h = _grid->height;
+	auto fn = [&](int begin, int end, int worker) {
+		for (int y = begin; y < end; ++y) {
+			for (int x = 0; x < w; ++x) {
+				int idx = x + y * w;
+				float t = _distance[idx];
+				ds::vec2 v(0.0f, 0.0f);
+				if (t < EIKONAL_INFINITY) {
+					float l = x > 0 ? _distance[idx - 1] : EIKONAL_INFINITY;
+					float r = x < w - 1 ? _distance[idx + 1] : EIKONAL_INFINITY;
+					float u = y > 0 ? _distance[idx - w] : EIKONAL_INFINITY;
+					float d = y < h - 1 ? _distance[idx + w] : EIKONAL_INFINITY;
+					if (l < r && l < t) {
+						v.x = l - t;
+					}
+					else if (r < t) {
+						v.x = t - r;
+					}
+					if (u < d && u < t) {
+						v.y = u - t;
+					}
+					else if (d < t) {
+						v.y = t - d;
+					}
+					if (v.x != 0.0f || v.y != 0.0f) {
+						v = normalize(v);
+					}
+				}
+				_flow[idx] = v;
+			}
+		}
+	};
+	runParallel(_jobs, h, 64, fn);
+}
+
+// -------------------------------------------------------------
+// calculate the directions and remember which ones have changed.
+// The rows are spread over the jobs and the changes are collected
+// afterwards so the list is always in the same order.
+// -------------------------------------------------------------
+void FlowField::buildDirections() {
+	int w = _grid->width;
+	int total = w * _grid->height;
+	ds::LinearArena* arena = ds::getThreadArena();
+	ds::ArenaScope scope(arena);
+	uint8_t* changed = arena->allocArray<uint8_t>(total);
+	runParallel(_jobs, _grid->height, 64, [&](int begin, int end, int worker) {
+		for (int y = begin; y < end; ++y) {
+			for (int x = 0; x < w; ++x) {
+				int idx = x + w * y;
+				int d = 16;
+				if (isPassable(x, y)) {
+					d = findLowestCost(x, y);
+				}
+				changed[idx] = d != _dir[idx];
+				_dir[idx] = d;
+			}
+		}
+	});
+	_numChanged = 0;
+	for (int i = 0; i < total; ++i) {
+		if (changed[i]) {
+			_changed[_numChanged++] = i;
+		}
+	}
 }
 
 // -------------------------------------------------------------
@@ -141,6 +796,34 @@ int FlowField::getCost(int x, int y) const {
 	return _fields[idx];
 }
 
+// -------------------------------------------------------------
+// get distance - the continuous distance in eikonal mode and the
+// integer cost otherwise
+// -------------------------------------------------------------
+float FlowField::getDistance(int x, int y) const {
+	int idx = x + y * _grid->width;
+	if (_method == FlowFieldMethod::EIKONAL) {
+		return _distance[idx];
+	}
+	return static_cast<float>(_fields[idx]);
+}
+
+// -------------------------------------------------------------
+// get flow - the normalized direction to move in. Without the
+// eikonal field it is taken from the discrete direction.
+// -------------------------------------------------------------
+ds::vec2 FlowField::getFlow(int x, int y) const {
+	int idx = x + y * _grid->width;
+	if (_method == FlowFieldMethod::EIKONAL) {
+		return _flow[idx];
+	}
+	int d = _dir[idx];
+	if (d >= 0 && d < 8) {
+		return normalize(ds::vec2(DIRECTIONS[d].x, DIRECTIONS[d].y));
+	}
+	return ds::vec2(0.0f, 0.0f);
+}
+
 // -------------------------------------------------------------
 // get the next field based on the direction of the current cell
 // -------------------------------------------------------------
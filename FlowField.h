@@ -1,25 +1,179 @@
 #pragma once
-#include "src\Grid.h"
-#include <diesel.h>
-#include <list>
+#include "src/Grid.h"
+#include <ds_math.h>
+#include <limits.h>
+
+namespace ds {
+	class JobSystem;
+}
+
+// ---------------------------------------------------------------
+// cost of cells that can not reach the end
+// ---------------------------------------------------------------
+const static int FLOW_FIELD_UNREACHABLE = INT_MAX;
+
+// ---------------------------------------------------------------
+// Every tile type has a traversal cost. A cost of 0 means the
+// tile is blocked. Tile types outside the table are blocked.
+// MAX_TILE_TYPES is defined with the grid, which can share the
+// table of a field.
+// ---------------------------------------------------------------
+const static int MAX_TILE_COST = 255;
+
+// ---------------------------------------------------------------
+// FOUR_WAY integrates over N, S, W and E with a step cost of 1.
+// EIGHT_WAY adds the diagonals and uses octile steps of 10 and 14.
+// The step cost is multiplied by the cost of the tile that is
+// left, so the values of getCost depend on the connectivity.
+// ---------------------------------------------------------------
+struct FlowFieldConnectivity {
+
+	enum Enum {
+		FOUR_WAY,
+		EIGHT_WAY
+	};
+};
+
+// ---------------------------------------------------------------
+// when a diagonal step between two orthogonal neighbours is taken
+// ALLOWED    : always
+// NO_SQUEEZE : not if both orthogonal neighbours are blocked
+// NEVER      : not if one of the orthogonal neighbours is blocked
+// ---------------------------------------------------------------
+struct CornerCutting {
+
+	enum Enum {
+		ALLOWED,
+		NO_SQUEEZE,
+		NEVER
+	};
+};
+
+// ---------------------------------------------------------------
+// DIJKSTRA is the discrete integration over the grid graph.
+// EIKONAL solves |grad T| = tile cost with fast sweeping. It gives
+// a continuous distance field and flow vectors along its gradient
+// so walkers are not limited to eight directions. The sweeps run
+// on blocks of EIKONAL_BLOCK_SIZE cells and all blocks on one
+// anti-diagonal are processed in parallel. Every path bend around
+// an obstacle costs another round of sweeps so it is meant for
+// open maps. The integer costs are scaled like the octile costs.
+// A field that has not converged after MAX_EIKONAL_ROUNDS is
+// replaced by the eight way integration without corner cutting,
+// which reaches the same cells.
+// PARALLEL_BFS is a level synchronous BFS that expands the
+// frontier on the job system and switches between top-down and
+// bottom-up steps. It gives the same costs as DIJKSTRA but only
+// works for four way fields where all passable tiles have the
+// same cost. Otherwise DIJKSTRA is used.
+// ---------------------------------------------------------------
+struct FlowFieldMethod {
+
+	enum Enum {
+		DIJKSTRA,
+		EIKONAL,
+		PARALLEL_BFS
+	};
+};
+
+const static int EIKONAL_BLOCK_SIZE = 32;
+const static int MAX_EIKONAL_ROUNDS = 512;
+const static float EIKONAL_INFINITY = 1e30f;
+
+// direction optimizing switch points of the parallel BFS. Go
+// bottom-up when the frontier is larger than the unvisited cells
+// divided by ALPHA and back when it is smaller than all cells
+// divided by BETA.
+const static int BFS_ALPHA = 14;
+const static int BFS_BETA = 24;
+const static int BFS_CHUNK_SIZE = 1024;
 
 class FlowField {
 
+	// temporary data of the eikonal sweeps
+	struct SweepState {
+		const float* slowness;
+		uint8_t* active;
+		uint8_t* changed;
+		int blocksX;
+		int blocksY;
+	};
+
 public:
 	FlowField(Grid* grid);
 	~FlowField();
 	void build(const p2i& end);
+	void setConnectivity(FlowFieldConnectivity::Enum connectivity, CornerCutting::Enum cornerCutting);
+	void setMethod(FlowFieldMethod::Enum method, ds::JobSystem* jobs = 0);
+	FlowFieldMethod::Enum getMethod() const {
+		return _method;
+	}
+	FlowFieldConnectivity::Enum getConnectivity() const {
+		return _connectivity;
+	}
+	CornerCutting::Enum getCornerCutting() const {
+		return _cornerCutting;
+	}
+	void setTileCost(int type, int cost);
+	int getTileCost(int type) const;
+	// the cost table, Grid::setTileCosts lets the grid use it
+	const int* getTileCosts() const {
+		return _tileCosts;
+	}
+	bool isPassable(int x, int y) const;
+	// tile cost of a cell of the grid the field is built on
+	int getCellCost(int x, int y) const;
+	int getNeighbors(int x, int y, int* ret, int* steps, int max) const;
 	int get(int x, int y) const;
 	int getCost(int x, int y) const;
+	float getDistance(int x, int y) const;
+	ds::vec2 getFlow(int x, int y) const;
 	p2i next(const p2i& current);
 	bool hasNext(const p2i& current);
+	uint32_t getVersion() const {
+		return _version;
+	}
+	int getChanged(const int** ret) const {
+		*ret = _changed;
+		return _numChanged;
+	}
+	// number of cells taken from the open list or visited by the
+	// sweeps of the last build
+	int getNumExpanded() const {
+		return _numExpanded;
+	}
+	// number of eikonal rounds (4 sweeps each) of the last build
+	int getNumRounds() const {
+		return _numRounds;
+	}
 private:
-	bool checkIfContains(unsigned int idx, const std::list<unsigned int>& lst) const;
-	int getNeighbors(int x, int y, int* ret, int max);
+	bool isDiagonalAllowed(int x, int y, const p2i& dir) const;
 	int findLowestCost(int x, int y);
 	void resetFields();
+	void integrate(int targetID);
+	void integrateEikonal(int targetID);
+	void integrateFallback(int targetID);
+	bool integrateParallel(int targetID);
+	bool getUniformCost(int* cost) const;
+	bool sweep(SweepState& state, int sx, int sy);
+	bool sweepBlock(const SweepState& state, int bx, int by, int sx, int sy);
+	void buildFlowVectors();
+	void buildDirections();
+	int _tileCosts[MAX_TILE_TYPES];
+	int _maxTileCost;
+	FlowFieldConnectivity::Enum _connectivity;
+	CornerCutting::Enum _cornerCutting;
+	FlowFieldMethod::Enum _method;
+	ds::JobSystem* _jobs;
+	float* _distance;
+	ds::vec2* _flow;
+	int _numRounds;
 	int* _fields;
 	int* _dir;
+	int* _changed;
+	int _numChanged;
+	int _numExpanded;
+	uint32_t _version;
 	Grid* _grid;
 	p2i _end;
 };
@@ -0,0 +1,161 @@
+#include "Landmarks.h"
+#include "FlowField.h"
+#include "src/lib/LinearArena.h"
+#include <ds_profiler.h>
+
+// ---------------------------------------------------------------
+// ctor
+// ---------------------------------------------------------------
+Landmarks::Landmarks(Grid* grid, int count) : _grid(grid), _count(count), _num(0), _start(-1, -1), _end(-1, -1), _version(0), _valid(false) {
+	if (_count > MAX_LANDMARKS) {
+		_count = MAX_LANDMARKS;
+	}
+	_flowField = new FlowField(_grid);
+	_flowField->setConnectivity(FlowFieldConnectivity::EIGHT_WAY, CornerCutting::ALLOWED);
+	_tables = new int[_count * _grid->width * _grid->height];
+}
+
+// ---------------------------------------------------------------
+// dtor
+// ---------------------------------------------------------------
+Landmarks::~Landmarks() {
+	delete[] _tables;
+	delete _flowField;
+}
+
+// ---------------------------------------------------------------
+// update - refresh the tables if the grid has changed. The
+// landmarks are kept as long as all of them are still passable
+// and start and end have not moved so only the floods are
+// repeated.
+// ---------------------------------------------------------------
+void Landmarks::update() {
+	if (_valid && _version == _grid->version) {
+		return;
+	}
+	p2i start = _grid->getStart();
+	p2i end = _grid->getEnd();
+	bool keep = _valid && _num > 0 && start.x == _start.x && start.y == _start.y && end.x == _end.x && end.y == _end.y;
+	for (int i = 0; i < _num && keep; ++i) {
+		keep = _grid->isAvailable(_landmarks[i]);
+	}
+	if (!keep) {
+		rebuild();
+		return;
+	}
+	PERF_ZONE("Landmarks::update");
+	_version = _grid->version;
+	for (int i = 0; i < _num; ++i) {
+		_flowField->build(_landmarks[i]);
+		copyTable(i);
+	}
+}
+
+// ---------------------------------------------------------------
+// copy the costs of the last build into the table
+// ---------------------------------------------------------------
+void Landmarks::copyTable(int index) {
+	int* table = _tables + index * _grid->width * _grid->height;
+	for (int y = 0; y < _grid->height; ++y) {
+		for (int x = 0; x < _grid->width; ++x) {
+			table[x + y * _grid->width] = _flowField->getCost(x, y);
+		}
+	}
+}
+
+// ---------------------------------------------------------------
+// add a landmark and lower the distances to the nearest one
+// ---------------------------------------------------------------
+void Landmarks::add(const p2i& p, int* nearest) {
+	int total = _grid->width * _grid->height;
+	_landmarks[_num] = p;
+	_flowField->build(p);
+	copyTable(_num);
+	const int* table = _tables + _num * total;
+	for (int i = 0; i < total; ++i) {
+		if (_num == 0 || table[i] < nearest[i]) {
+			nearest[i] = table[i];
+		}
+	}
+	++_num;
+}
+
+// ---------------------------------------------------------------
+// rebuild - end and start followed by farthest point selection
+// ---------------------------------------------------------------
+void Landmarks::rebuild() {
+	PERF_ZONE("Landmarks::rebuild");
+	_num = 0;
+	_version = _grid->version;
+	_valid = true;
+	_start = _grid->getStart();
+	_end = _grid->getEnd();
+	int total = _grid->width * _grid->height;
+	//
+	// nearest holds the distance of every cell to the closest
+	// landmark so far. Every landmark after end and start is the
+	// cell with the largest distance to its nearest landmark.
+	//
+	ds::LinearArena* arena = ds::getThreadArena();
+	ds::ArenaScope scope(arena);
+	int* nearest = arena->allocArray<int>(total);
+	if (_count > 0 && _grid->isValid(_end) && _grid->isAvailable(_end)) {
+		add(_end, nearest);
+	}
+	if (_num < _count && _grid->isValid(_start) && _grid->isAvailable(_start) && (_start.x != _end.x || _start.y != _end.y)) {
+		add(_start, nearest);
+	}
+	if (_num == 0) {
+		//
+		// without start and end the first landmark is the cell
+		// farthest from the first passable cell
+		//
+		p2i seed = p2i(-1, -1);
+		for (int i = 0; i < total && seed.x == -1; ++i) {
+			if (_grid->isAvailable(i % _grid->width, i / _grid->width)) {
+				seed = p2i(i % _grid->width, i / _grid->width);
+			}
+		}
+		if (seed.x == -1) {
+			return;
+		}
+		_flowField->build(seed);
+		for (int i = 0; i < total; ++i) {
+			nearest[i] = _flowField->getCost(i % _grid->width, i / _grid->width);
+		}
+	}
+	while (_num < _count) {
+		int best = -1;
+		int bestDistance = 0;
+		for (int i = 0; i < total; ++i) {
+			if (nearest[i] != FLOW_FIELD_UNREACHABLE && nearest[i] > bestDistance) {
+				best = i;
+				bestDistance = nearest[i];
+			}
+		}
+		if (best == -1) {
+			break;
+		}
+		add(p2i(best % _grid->width, best / _grid->width), nearest);
+	}
+}
+
+// ---------------------------------------------------------------
+// estimate - lower bound of the distance between two cells
+// ---------------------------------------------------------------
+int Landmarks::estimate(int from, int to) const {
+	int total = _grid->width * _grid->height;
+	int ret = 0;
+	for (int i = 0; i < _num; ++i) {
+		const int* table = _tables + i * total;
+		int a = table[from];
+		int b = table[to];
+		if (a != FLOW_FIELD_UNREACHABLE && b != FLOW_FIELD_UNREACHABLE) {
+			int d = a > b ? a - b : b - a;
+			if (d > ret) {
+				ret = d;
+			}
+		}
+	}
+	return ret;
+}
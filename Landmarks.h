@@ -0,0 +1,52 @@
+#pragma once
+#include "src/Grid.h"
+
+class FlowField;
+
+const static int MAX_LANDMARKS = 16;
+
+// ---------------------------------------------------------------
+// Landmarks
+//
+// Distance tables of a few landmark cells for the ALT heuristic.
+// The tables are eight way flow fields with the 10/14 step costs
+// A* uses. For every landmark L the triangle inequality gives
+// |d(L,t) - d(L,v)| <= d(v,t), the best of these is a much tighter
+// lower bound than the plain distance on maze like levels.
+// The end and the start of the grid are the first landmarks. A
+// landmark at the target makes the bound exact, so searches
+// towards the end expand little more than the path itself. The
+// others are picked by farthest point selection, every next one
+// is the cell farthest from all chosen ones. The tables are
+// refreshed lazily by update when the grid version has changed.
+// ---------------------------------------------------------------
+class Landmarks {
+
+public:
+	Landmarks(Grid* grid, int count = 8);
+	~Landmarks();
+	void update();
+	void rebuild();
+	int estimate(int from, int to) const;
+	int num() const {
+		return _num;
+	}
+	p2i get(int index) const {
+		return _landmarks[index];
+	}
+private:
+	Landmarks(const Landmarks& orig) {}
+	void copyTable(int index);
+	void add(const p2i& p, int* nearest);
+	Grid* _grid;
+	FlowField* _flowField;
+	int _count;
+	int _num;
+	p2i _landmarks[MAX_LANDMARKS];
+	// start and end of the grid at the last rebuild
+	p2i _start;
+	p2i _end;
+	int* _tables;
+	uint32_t _version;
+	bool _valid;
+};
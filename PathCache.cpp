@@ -0,0 +1,285 @@
+#include "PathCache.h"
+#include "APath.h"
+#include <ds_profiler.h>
+#include <string.h>
+
+// the directions are:
+//  321
+//  4x0
+//  567
+//
+const p2i PATH_DIRECTIONS[] = { p2i(1,0),p2i(1,1),p2i(0,1),p2i(-1,1),p2i(-1,0),p2i(-1,-1),p2i(0,-1),p2i(1,-1) };
+
+// ---------------------------------------------------------------
+// ctor
+// ---------------------------------------------------------------
+PathCache::PathCache(Grid* grid, APath* path, int capacity) : _grid(grid), _path(path), _arena(PATH_CACHE_ARENA_SIZE), _capacity(capacity), _numHits(0), _numMisses(0), _numEvicted(0) {
+	int total = _grid->width * _grid->height;
+	_entries = new PathCacheEntry[_capacity];
+	for (int i = 0; i < _capacity; ++i) {
+		_entries[i].stamp = 0;
+	}
+	_numBuckets = 1;
+	while (_numBuckets < _capacity * 2) {
+		_numBuckets *= 2;
+	}
+	_buckets = new int[_numBuckets];
+	_cells = new PathRef*[total];
+	_passable = new uint8_t[total];
+	clear();
+}
+
+// ---------------------------------------------------------------
+// dtor
+// ---------------------------------------------------------------
+PathCache::~PathCache() {
+	delete[] _passable;
+	delete[] _cells;
+	delete[] _buckets;
+	delete[] _entries;
+}
+
+// ---------------------------------------------------------------
+// clear - drops all paths and takes a new snapshot of the grid
+// ---------------------------------------------------------------
+void PathCache::clear() {
+	int total = _grid->width * _grid->height;
+	_arena.reset();
+	_used = 0;
+	for (int i = 0; i < _capacity; ++i) {
+		_entries[i].used = false;
+		++_entries[i].stamp;
+		_entries[i].next = i + 1 < _capacity ? i + 1 : -1;
+	}
+	_free = 0;
+	_numUsed = 0;
+	for (int i = 0; i < _numBuckets; ++i) {
+		_buckets[i] = -1;
+	}
+	memset(_cells, 0, total * sizeof(PathRef*));
+	for (int i = 0; i < total; ++i) {
+		_passable[i] = _grid->isAvailable(i % _grid->width, i / _grid->width) ? 1 : 0;
+	}
+	_version = _grid->version;
+}
+
+// ---------------------------------------------------------------
+// update - applies the grid changes since the last query
+// ---------------------------------------------------------------
+void PathCache::update() {
+	if (_version == _grid->version) {
+		return;
+	}
+	PERF_ZONE("PathCache::update");
+	int changes[GRID_CHANGE_LOG_SIZE];
+	int num = _grid->getChanges(_version, changes, GRID_CHANGE_LOG_SIZE);
+	if (num == -1) {
+		clear();
+		return;
+	}
+	_version = _grid->version;
+	bool opened = false;
+	for (int i = 0; i < num; ++i) {
+		int idx = changes[i];
+		int x = idx % _grid->width;
+		int y = idx / _grid->width;
+		uint8_t passable = _grid->isAvailable(x, y) ? 1 : 0;
+		if (passable != _passable[idx]) {
+			_passable[idx] = passable;
+			if (passable) {
+				opened = true;
+			}
+			else {
+				for (int dy = -1; dy < 2; ++dy) {
+					for (int dx = -1; dx < 2; ++dx) {
+						evictCell(x + dx, y + dy);
+					}
+				}
+			}
+		}
+	}
+	if (opened) {
+		clear();
+	}
+}
+
+// ---------------------------------------------------------------
+// evict all paths passing through the cell
+// ---------------------------------------------------------------
+void PathCache::evictCell(int x, int y) {
+	if (!_grid->isValid(x, y)) {
+		return;
+	}
+	int idx = _grid->getIndex(x, y);
+	PathRef* ref = _cells[idx];
+	while (ref != 0) {
+		const PathCacheEntry& entry = _entries[ref->entry];
+		if (entry.used && entry.stamp == ref->stamp) {
+			evict(ref->entry);
+		}
+		ref = ref->next;
+	}
+	_cells[idx] = 0;
+}
+
+// ---------------------------------------------------------------
+// evict - the steps stay in the arena until the next clear
+// ---------------------------------------------------------------
+void PathCache::evict(int entry) {
+	PathCacheEntry& e = _entries[entry];
+	int* current = &_buckets[getBucket(e.start, e.end)];
+	while (*current != entry) {
+		current = &_entries[*current].next;
+	}
+	*current = e.next;
+	e.used = false;
+	++e.stamp;
+	e.next = _free;
+	_free = entry;
+	--_numUsed;
+	++_numEvicted;
+}
+
+// ---------------------------------------------------------------
+// get bucket
+// ---------------------------------------------------------------
+int PathCache::getBucket(int start, int end) const {
+	uint32_t h = static_cast<uint32_t>(start) * 0x9E3779B1u ^ static_cast<uint32_t>(end) * 0x85EBCA77u;
+	return (h ^ (h >> 16)) & (_numBuckets - 1);
+}
+
+// ---------------------------------------------------------------
+// lookup
+// ---------------------------------------------------------------
+int PathCache::lookup(int start, int end) const {
+	int current = _buckets[getBucket(start, end)];
+	while (current != -1) {
+		const PathCacheEntry& e = _entries[current];
+		if (e.start == start && e.end == end) {
+			return current;
+		}
+		current = e.next;
+	}
+	return -1;
+}
+
+// ---------------------------------------------------------------
+// insert - encodes the steps and adds the path to the reverse
+// index of every cell it passes through
+// ---------------------------------------------------------------
+void PathCache::insert(int start, int end, const p2i* points, int num) {
+	int size = 0;
+	int run = 0;
+	for (int i = 1; i < num; ++i) {
+		bool same = i > 1 && points[i].x - points[i - 1].x == points[i - 1].x - points[i - 2].x && points[i].y - points[i - 1].y == points[i - 1].y - points[i - 2].y;
+		if (!same || run == MAX_PATH_RUN) {
+			++size;
+			run = 0;
+		}
+		++run;
+	}
+	int needed = size + num * static_cast<int>(sizeof(PathRef)) + 16;
+	if (needed > PATH_CACHE_ARENA_SIZE) {
+		return;
+	}
+	if (_free == -1 || _used + needed > PATH_CACHE_ARENA_SIZE) {
+		clear();
+	}
+	int index = _free;
+	PathCacheEntry& e = _entries[index];
+	_free = e.next;
+	e.start = start;
+	e.end = end;
+	e.numPoints = num;
+	e.size = size;
+	e.data = size > 0 ? static_cast<uint8_t*>(_arena.alloc(size, 1)) : 0;
+	//
+	// every byte holds the direction in the upper 3 bits and the
+	// length of the run - 1 in the lower 5 bits
+	//
+	int current = -1;
+	for (int i = 1; i < num; ++i) {
+		int dx = points[i].x - points[i - 1].x;
+		int dy = points[i].y - points[i - 1].y;
+		int dir = 0;
+		while (PATH_DIRECTIONS[dir].x != dx || PATH_DIRECTIONS[dir].y != dy) {
+			++dir;
+		}
+		if (current == -1 || (e.data[current] >> 5) != dir || (e.data[current] & 31) == MAX_PATH_RUN - 1) {
+			e.data[++current] = static_cast<uint8_t>(dir << 5);
+		}
+		else {
+			++e.data[current];
+		}
+	}
+	if (num > 0) {
+		PathRef* refs = _arena.allocArray<PathRef>(num);
+		for (int i = 0; i < num; ++i) {
+			int idx = _grid->getIndex(points[i]);
+			refs[i].entry = index;
+			refs[i].stamp = e.stamp;
+			refs[i].next = _cells[idx];
+			_cells[idx] = &refs[i];
+		}
+	}
+	_used += needed;
+	e.used = true;
+	int bucket = getBucket(start, end);
+	e.next = _buckets[bucket];
+	_buckets[bucket] = index;
+	++_numUsed;
+}
+
+// ---------------------------------------------------------------
+// decode - the first point is the end like APath returns it
+// ---------------------------------------------------------------
+int PathCache::decode(const PathCacheEntry& entry, p2i* points, int max) const {
+	if (entry.numPoints == 0 || max <= 0) {
+		return 0;
+	}
+	int ret = 0;
+	p2i current = p2i(entry.end % _grid->width, entry.end / _grid->width);
+	points[ret++] = current;
+	for (int i = 0; i < entry.size && ret < max; ++i) {
+		const p2i& dir = PATH_DIRECTIONS[entry.data[i] >> 5];
+		int run = (entry.data[i] & 31) + 1;
+		for (int j = 0; j < run && ret < max; ++j) {
+			current = current + dir;
+			points[ret++] = current;
+		}
+	}
+	return ret;
+}
+
+// ---------------------------------------------------------------
+// find - same result as APath::find
+// ---------------------------------------------------------------
+int PathCache::find(p2i start, p2i end, p2i* points, int max) {
+	update();
+	if (!_grid->isValid(start) || !_grid->isValid(end)) {
+		return 0;
+	}
+	int s = _grid->getIndex(start);
+	int e = _grid->getIndex(end);
+	int entry = lookup(s, e);
+	if (entry != -1) {
+		++_numHits;
+		return decode(_entries[entry], points, max);
+	}
+	++_numMisses;
+	//
+	// the search always gets the complete path so a truncated one
+	// is never cached
+	//
+	int total = _grid->width * _grid->height;
+	ds::LinearArena* arena = ds::getThreadArena();
+	ds::ArenaScope scope(arena);
+	p2i* tmp = arena->allocArray<p2i>(total);
+	int num = _path->find(start, end, tmp, total);
+	insert(s, e, tmp, num);
+	int ret = num < max ? num : max;
+	for (int i = 0; i < ret; ++i) {
+		points[i] = tmp[i];
+	}
+	return ret;
+}
@@ -0,0 +1,98 @@
+#pragma once
+#include "src/Grid.h"
+#include "src/lib/LinearArena.h"
+
+class APath;
+
+// bytes of compressed paths and reverse index entries before the
+// cache starts over
+const static int PATH_CACHE_ARENA_SIZE = 1024 * 1024;
+// longest run of equal steps stored in one byte
+const static int MAX_PATH_RUN = 32;
+
+// ---------------------------------------------------------------
+// one cached search result. A path of 0 points is a cached miss.
+// ---------------------------------------------------------------
+struct PathCacheEntry {
+	int start;
+	int end;
+	int numPoints;
+	int size;
+	uint8_t* data;
+	// next entry in the bucket or the free list
+	int next;
+	// bumped on eviction so stale references can be detected
+	uint32_t stamp;
+	bool used;
+};
+
+// ---------------------------------------------------------------
+// reference of a path from a cell it passes through
+// ---------------------------------------------------------------
+struct PathRef {
+	int entry;
+	uint32_t stamp;
+	PathRef* next;
+};
+
+// ---------------------------------------------------------------
+// PathCache
+//
+// Caches the results of APath::find by start and end. The cache
+// follows the grid version: before every query the changes of the
+// grid since the last query are applied. A cell that gets blocked
+// only evicts the paths passing through it or one of its eight
+// neighbours, found by a cell to path reverse index. A cell that
+// becomes passable can make any path shorter, also the cached
+// misses, so it clears the cache.
+// The paths are stored as run length encoded steps, one byte per
+// run of up to MAX_PATH_RUN steps in the same direction. The steps
+// and the reverse index are taken from an arena. Evicted paths
+// leave holes so when the arena or the entries are used up the
+// cache starts over.
+// ---------------------------------------------------------------
+class PathCache {
+
+public:
+	PathCache(Grid* grid, APath* path, int capacity = 256);
+	~PathCache();
+	int find(p2i start, p2i end, p2i* points, int max);
+	void update();
+	void clear();
+	int num() const {
+		return _numUsed;
+	}
+	int getNumHits() const {
+		return _numHits;
+	}
+	int getNumMisses() const {
+		return _numMisses;
+	}
+	int getNumEvicted() const {
+		return _numEvicted;
+	}
+private:
+	PathCache(const PathCache& orig) {}
+	int getBucket(int start, int end) const;
+	int lookup(int start, int end) const;
+	void insert(int start, int end, const p2i* points, int num);
+	void evict(int entry);
+	void evictCell(int x, int y);
+	int decode(const PathCacheEntry& entry, p2i* points, int max) const;
+	Grid* _grid;
+	APath* _path;
+	ds::LinearArena _arena;
+	int _used;
+	PathCacheEntry* _entries;
+	int _capacity;
+	int _numUsed;
+	int _free;
+	int* _buckets;
+	int _numBuckets;
+	PathRef** _cells;
+	uint8_t* _passable;
+	uint32_t _version;
+	int _numHits;
+	int _numMisses;
+	int _numEvicted;
+};
@@ -0,0 +1,88 @@
+#include "PathSmoother.h"
+#include "FlowField.h"
+#include <ds_profiler.h>
+
+// ---------------------------------------------------------------
+// cost of a cell for the line of sight test, 0 means blocked
+// ---------------------------------------------------------------
+static int getCellCost(const Grid* grid, const FlowField* flowField, int x, int y) {
+	if (!grid->isValid(x, y)) {
+		return 0;
+	}
+	if (flowField != 0) {
+		return flowField->getTileCost(grid->get(x, y));
+	}
+	return grid->isAvailable(x, y) ? 1 : 0;
+}
+
+// ---------------------------------------------------------------
+// has line of sight - supercover traversal
+// ---------------------------------------------------------------
+bool hasLineOfSight(const Grid* grid, const FlowField* flowField, p2i from, p2i to) {
+	int cost = getCellCost(grid, flowField, from.x, from.y);
+	if (cost == 0) {
+		return false;
+	}
+	int nx = to.x > from.x ? to.x - from.x : from.x - to.x;
+	int ny = to.y > from.y ? to.y - from.y : from.y - to.y;
+	int sx = to.x > from.x ? 1 : -1;
+	int sy = to.y > from.y ? 1 : -1;
+	int x = from.x;
+	int y = from.y;
+	int ix = 0;
+	int iy = 0;
+	while (ix < nx || iy < ny) {
+		//
+		// compare where the segment crosses the next vertical and the
+		// next horizontal cell border. Both scaled by 2 * nx * ny.
+		//
+		int decision = (1 + 2 * ix) * ny - (1 + 2 * iy) * nx;
+		if (decision == 0) {
+			if (getCellCost(grid, flowField, x + sx, y) != cost || getCellCost(grid, flowField, x, y + sy) != cost) {
+				return false;
+			}
+			x += sx;
+			y += sy;
+			++ix;
+			++iy;
+		}
+		else if (decision < 0) {
+			x += sx;
+			++ix;
+		}
+		else {
+			y += sy;
+			++iy;
+		}
+		if (getCellCost(grid, flowField, x, y) != cost) {
+			return false;
+		}
+	}
+	return true;
+}
+
+// ---------------------------------------------------------------
+// pull string - keeps the last cell that can be seen from the
+// current anchor. Every test starts at the anchor so the path
+// never leaves the cells the traversal has checked.
+// ---------------------------------------------------------------
+int pullString(const Grid* grid, const FlowField* flowField, const p2i* path, int num, p2i* waypoints, int max) {
+	PERF_ZONE("pullString");
+	if (num <= 0 || max <= 0) {
+		return 0;
+	}
+	p2i anchor = path[0];
+	p2i last = path[num - 1];
+	int ret = 0;
+	waypoints[ret++] = anchor;
+	for (int i = 2; i < num && ret < max; ++i) {
+		if (!hasLineOfSight(grid, flowField, anchor, path[i])) {
+			anchor = path[i - 1];
+			waypoints[ret++] = anchor;
+		}
+	}
+	if (num > 1 && ret < max) {
+		waypoints[ret++] = last;
+	}
+	return ret;
+}
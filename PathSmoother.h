@@ -0,0 +1,27 @@
+#pragma once
+#include "src/Grid.h"
+
+class FlowField;
+
+// ---------------------------------------------------------------
+// String pulling of grid paths. A path of neighbouring cells from
+// APath or traced through a flow field is reduced to the cells
+// where it has to bend.
+//
+// The line of sight test is a supercover traversal between the
+// cell centers. It visits every cell the segment touches. If the
+// segment passes exactly through a corner both cells next to the
+// corner have to be clear so it never squeezes between two
+// blocked cells. With a flow field a cell is clear if it has the
+// same tile cost as the first cell so the pulled path never cuts
+// through more expensive terrain. Without one the cells have to
+// be available in the grid.
+// ---------------------------------------------------------------
+bool hasLineOfSight(const Grid* grid, const FlowField* flowField, p2i from, p2i to);
+
+// ---------------------------------------------------------------
+// Writes the first and the last cell and every cell where the
+// path bends to waypoints and returns the number of waypoints.
+// waypoints may be the path itself.
+// ---------------------------------------------------------------
+int pullString(const Grid* grid, const FlowField* flowField, const p2i* path, int num, p2i* waypoints, int max);
@@ -0,0 +1,519 @@
+#include "RectPath.h"
+#include <ds_profiler.h>
+#include <string.h>
+
+// ---------------------------------------------------------------
+// ctor
+// ---------------------------------------------------------------
+RectPath::RectPath(Grid* grid) : _grid(grid), _numFreeRects(0), _numSlots(0), _numRects(0), _numOpen(0), _numExpanded(0), _search(0), _end(-1), _version(0), _valid(false) {
+	int total = _grid->width * _grid->height;
+	_passable = new uint8_t[total];
+	_rectIndex = new int[total];
+	// there can never be more rectangles than free cells
+	_rects = new NavRect[total];
+	_freeRects = new int[total];
+	_nodes = new RectNode[total];
+	_open = new int[total];
+	_changes = new int[GRID_CHANGE_LOG_SIZE];
+}
+
+// ---------------------------------------------------------------
+// dtor
+// ---------------------------------------------------------------
+RectPath::~RectPath() {
+	delete[] _changes;
+	delete[] _open;
+	delete[] _nodes;
+	delete[] _freeRects;
+	delete[] _rects;
+	delete[] _rectIndex;
+	delete[] _passable;
+}
+
+// ---------------------------------------------------------------
+// is free - passable in the snapshot and not part of a rectangle
+// ---------------------------------------------------------------
+bool RectPath::isFree(int x, int y) const {
+	if (!_grid->isValid(x, y)) {
+		return false;
+	}
+	int idx = x + y * _grid->width;
+	return _passable[idx] && _rectIndex[idx] == -1;
+}
+
+// ---------------------------------------------------------------
+// is border - the cell is on the first or last row or column of
+// its rectangle
+// ---------------------------------------------------------------
+bool RectPath::isBorder(int index) const {
+	const NavRect& r = _rects[_rectIndex[index]];
+	int x = index % _grid->width;
+	int y = index / _grid->width;
+	return x == r.x || y == r.y || x == r.x + r.width - 1 || y == r.y + r.height - 1;
+}
+
+// ---------------------------------------------------------------
+// grow - the largest rectangle at the cell that is grown either
+// along the row first or along the column first
+// ---------------------------------------------------------------
+NavRect RectPath::grow(int x, int y, bool horizontal) const {
+	NavRect r = { x, y, 1, 1 };
+	if (horizontal) {
+		while (isFree(r.x + r.width, y)) {
+			++r.width;
+		}
+		for (;;) {
+			int ny = r.y + r.height;
+			bool free = _grid->isValid(x, ny);
+			for (int i = 0; i < r.width && free; ++i) {
+				free = isFree(r.x + i, ny);
+			}
+			if (!free) {
+				break;
+			}
+			++r.height;
+		}
+	}
+	else {
+		while (isFree(x, r.y + r.height)) {
+			++r.height;
+		}
+		for (;;) {
+			int nx = r.x + r.width;
+			bool free = _grid->isValid(nx, y);
+			for (int i = 0; i < r.height && free; ++i) {
+				free = isFree(nx, r.y + i);
+			}
+			if (!free) {
+				break;
+			}
+			++r.width;
+		}
+	}
+	return r;
+}
+
+// ---------------------------------------------------------------
+// decompose - covers the free cells of the area by rectangles.
+// The cells are scanned row by row so a free cell never has free
+// cells above or left of it and the rectangles only grow right
+// and down.
+// ---------------------------------------------------------------
+void RectPath::decompose(int left, int top, int right, int bottom) {
+	for (int y = top; y <= bottom; ++y) {
+		for (int x = left; x <= right; ++x) {
+			if (!isFree(x, y)) {
+				continue;
+			}
+			NavRect first = grow(x, y, true);
+			NavRect second = grow(x, y, false);
+			const NavRect& r = first.width * first.height >= second.width * second.height ? first : second;
+			int id = _numFreeRects > 0 ? _freeRects[--_numFreeRects] : _numSlots++;
+			_rects[id] = r;
+			++_numRects;
+			for (int ry = r.y; ry < r.y + r.height; ++ry) {
+				for (int rx = r.x; rx < r.x + r.width; ++rx) {
+					_rectIndex[rx + ry * _grid->width] = id;
+				}
+			}
+		}
+	}
+}
+
+// ---------------------------------------------------------------
+// dissolve - releases the rectangle and extends the bounds
+// (left, top, right, bottom) by it
+// ---------------------------------------------------------------
+void RectPath::dissolve(int rect, int* bounds) {
+	const NavRect& r = _rects[rect];
+	int right = r.x + r.width - 1;
+	int bottom = r.y + r.height - 1;
+	for (int y = r.y; y <= bottom; ++y) {
+		for (int x = r.x; x <= right; ++x) {
+			_rectIndex[x + y * _grid->width] = -1;
+		}
+	}
+	bounds[0] = r.x < bounds[0] ? r.x : bounds[0];
+	bounds[1] = r.y < bounds[1] ? r.y : bounds[1];
+	bounds[2] = right > bounds[2] ? right : bounds[2];
+	bounds[3] = bottom > bounds[3] ? bottom : bounds[3];
+	_freeRects[_numFreeRects++] = rect;
+	--_numRects;
+}
+
+// ---------------------------------------------------------------
+// remove cell - splits the rectangle of a blocked cell again
+// ---------------------------------------------------------------
+void RectPath::removeCell(int index) {
+	int x = index % _grid->width;
+	int y = index / _grid->width;
+	int bounds[] = { x, y, x, y };
+	dissolve(_rectIndex[index], bounds);
+	_passable[index] = 0;
+	decompose(bounds[0], bounds[1], bounds[2], bounds[3]);
+}
+
+// ---------------------------------------------------------------
+// add cell - an opened cell is decomposed together with the
+// rectangles of its four neighbours
+// ---------------------------------------------------------------
+void RectPath::addCell(int index) {
+	int x = index % _grid->width;
+	int y = index / _grid->width;
+	int bounds[] = { x, y, x, y };
+	_passable[index] = 1;
+	const int DX[] = { 1, -1, 0, 0 };
+	const int DY[] = { 0, 0, 1, -1 };
+	for (int i = 0; i < 4; ++i) {
+		int nx = x + DX[i];
+		int ny = y + DY[i];
+		if (_grid->isValid(nx, ny)) {
+			int rect = _rectIndex[nx + ny * _grid->width];
+			if (rect != -1) {
+				dissolve(rect, bounds);
+			}
+		}
+	}
+	decompose(bounds[0], bounds[1], bounds[2], bounds[3]);
+}
+
+// ---------------------------------------------------------------
+// rebuild - decomposes the whole grid
+// ---------------------------------------------------------------
+void RectPath::rebuild() {
+	PERF_ZONE("RectPath::rebuild");
+	int total = _grid->width * _grid->height;
+	for (int i = 0; i < total; ++i) {
+		_passable[i] = _grid->isAvailable(i % _grid->width, i / _grid->width) ? 1 : 0;
+		_rectIndex[i] = -1;
+	}
+	_numFreeRects = 0;
+	_numSlots = 0;
+	_numRects = 0;
+	_version = _grid->version;
+	_valid = true;
+	decompose(0, 0, _grid->width - 1, _grid->height - 1);
+}
+
+// ---------------------------------------------------------------
+// update - applies the changes of the grid since the last update
+// ---------------------------------------------------------------
+void RectPath::update() {
+	if (!_valid) {
+		rebuild();
+		return;
+	}
+	if (_version == _grid->version) {
+		return;
+	}
+	PERF_ZONE("RectPath::update");
+	int num = _grid->getChanges(_version, _changes, GRID_CHANGE_LOG_SIZE);
+	if (num == -1) {
+		rebuild();
+		return;
+	}
+	_version = _grid->version;
+	for (int i = 0; i < num; ++i) {
+		int idx = _changes[i];
+		bool passable = _grid->isAvailable(idx % _grid->width, idx / _grid->width);
+		if (passable == (_passable[idx] != 0)) {
+			continue;
+		}
+		if (passable) {
+			addCell(idx);
+		}
+		else {
+			removeCell(idx);
+		}
+	}
+}
+
+// ---------------------------------------------------------------
+// touch - resets the node if it belongs to an older search
+// ---------------------------------------------------------------
+RectNode& RectPath::touch(int index) {
+	RectNode& node = _nodes[index];
+	if (node.search != _search) {
+		node.search = _search;
+		node.parent = -1;
+		node.heapIndex = -1;
+		node.closed = false;
+	}
+	return node;
+}
+
+// ---------------------------------------------------------------
+// heap order - lowest f first, on ties the one closer to the end
+// ---------------------------------------------------------------
+bool RectPath::less(int first, int second) const {
+	const RectNode& a = _nodes[first];
+	const RectNode& b = _nodes[second];
+	if (a.f != b.f) {
+		return a.f < b.f;
+	}
+	return a.h < b.h;
+}
+
+void RectPath::siftUp(int pos) {
+	int idx = _open[pos];
+	while (pos > 0) {
+		int parent = (pos - 1) / 2;
+		if (!less(idx, _open[parent])) {
+			break;
+		}
+		_open[pos] = _open[parent];
+		_nodes[_open[pos]].heapIndex = pos;
+		pos = parent;
+	}
+	_open[pos] = idx;
+	_nodes[idx].heapIndex = pos;
+}
+
+void RectPath::siftDown(int pos) {
+	int idx = _open[pos];
+	for (;;) {
+		int child = pos * 2 + 1;
+		if (child >= _numOpen) {
+			break;
+		}
+		if (child + 1 < _numOpen && less(_open[child + 1], _open[child])) {
+			++child;
+		}
+		if (!less(_open[child], idx)) {
+			break;
+		}
+		_open[pos] = _open[child];
+		_nodes[_open[pos]].heapIndex = pos;
+		pos = child;
+	}
+	_open[pos] = idx;
+	_nodes[idx].heapIndex = pos;
+}
+
+// ---------------------------------------------------------------
+// push
+// ---------------------------------------------------------------
+void RectPath::push(int index) {
+	_open[_numOpen++] = index;
+	siftUp(_numOpen - 1);
+}
+
+// ---------------------------------------------------------------
+// pop - removes the cheapest node from the open heap
+// ---------------------------------------------------------------
+int RectPath::pop() {
+	int ret = _open[0];
+	_nodes[ret].heapIndex = -1;
+	--_numOpen;
+	if (_numOpen > 0) {
+		_open[0] = _open[_numOpen];
+		siftDown(0);
+	}
+	return ret;
+}
+
+// ---------------------------------------------------------------
+// octile distance between two cells
+// ---------------------------------------------------------------
+int RectPath::getDistance(int first, int second) const {
+	int dx = first % _grid->width - second % _grid->width;
+	int dy = first / _grid->width - second / _grid->width;
+	if (dx < 0) {
+		dx = -dx;
+	}
+	if (dy < 0) {
+		dy = -dy;
+	}
+	return dx > dy ? dx * 10 + dy * 4 : dy * 10 + dx * 4;
+}
+
+// ---------------------------------------------------------------
+// relax - opens the node or lowers its cost
+// ---------------------------------------------------------------
+void RectPath::relax(int from, int to, int cost) {
+	RectNode& node = touch(to);
+	if (node.closed) {
+		return;
+	}
+	int g = _nodes[from].g + cost;
+	if (node.heapIndex == -1) {
+		node.g = g;
+		node.h = getDistance(to, _end);
+		node.f = g + node.h;
+		node.parent = from;
+		push(to);
+	}
+	else if (g < node.g) {
+		node.g = g;
+		node.f = g + node.h;
+		node.parent = from;
+		siftUp(node.heapIndex);
+	}
+}
+
+// ---------------------------------------------------------------
+// expand border - the successors of a cell on the border of its
+// rectangle
+// ---------------------------------------------------------------
+void RectPath::expandBorder(int index) {
+	int width = _grid->width;
+	int x = index % width;
+	int y = index / width;
+	int rect = _rectIndex[index];
+	const NavRect& r = _rects[rect];
+	int right = r.x + r.width - 1;
+	int bottom = r.y + r.height - 1;
+	//
+	// border cells around it, corners can be cut like in APath
+	//
+	for (int dy = -1; dy < 2; ++dy) {
+		for (int dx = -1; dx < 2; ++dx) {
+			if ((dx == 0 && dy == 0) || !_grid->isValid(x + dx, y + dy)) {
+				continue;
+			}
+			int n = index + dx + dy * width;
+			if (_rectIndex[n] != -1 && isBorder(n)) {
+				relax(index, n, dx != 0 && dy != 0 ? 14 : 10);
+			}
+		}
+	}
+	//
+	// diagonals through the inside up to the next border cell, a
+	// single step was already taken above
+	//
+	for (int i = 0; i < 4; ++i) {
+		int dx = i & 1 ? 1 : -1;
+		int dy = i & 2 ? 1 : -1;
+		int cx = x + dx;
+		int cy = y + dy;
+		int steps = 1;
+		while (cx > r.x && cx < right && cy > r.y && cy < bottom) {
+			cx += dx;
+			cy += dy;
+			++steps;
+		}
+		if (steps > 1 && cx >= r.x && cx <= right && cy >= r.y && cy <= bottom) {
+			relax(index, cx + cy * width, steps * 14);
+		}
+	}
+	//
+	// cells on the opposite side that are closer than a diagonal
+	//
+	if (r.height > 2 && (y == r.y || y == bottom)) {
+		int d = r.height - 1;
+		int ty = y == r.y ? bottom : r.y;
+		int first = x - d + 1 > r.x ? x - d + 1 : r.x;
+		int last = x + d - 1 < right ? x + d - 1 : right;
+		for (int tx = first; tx <= last; ++tx) {
+			int n = tx + ty * width;
+			relax(index, n, getDistance(index, n));
+		}
+	}
+	if (r.width > 2 && (x == r.x || x == right)) {
+		int d = r.width - 1;
+		int tx = x == r.x ? right : r.x;
+		int first = y - d + 1 > r.y ? y - d + 1 : r.y;
+		int last = y + d - 1 < bottom ? y + d - 1 : bottom;
+		for (int ty = first; ty <= last; ++ty) {
+			int n = tx + ty * width;
+			relax(index, n, getDistance(index, n));
+		}
+	}
+	//
+	// the end inside the rectangle
+	//
+	if (_rectIndex[_end] == rect && !isBorder(_end)) {
+		relax(index, _end, getDistance(index, _end));
+	}
+}
+
+// ---------------------------------------------------------------
+// expand rect - a start inside its rectangle reaches every cell
+// of the border directly
+// ---------------------------------------------------------------
+void RectPath::expandRect(int index) {
+	const NavRect& r = _rects[_rectIndex[index]];
+	int right = r.x + r.width - 1;
+	int bottom = r.y + r.height - 1;
+	for (int x = r.x; x <= right; ++x) {
+		int top = x + r.y * _grid->width;
+		int low = x + bottom * _grid->width;
+		relax(index, top, getDistance(index, top));
+		relax(index, low, getDistance(index, low));
+	}
+	for (int y = r.y + 1; y < bottom; ++y) {
+		int left = r.x + y * _grid->width;
+		int last = right + y * _grid->width;
+		relax(index, left, getDistance(index, left));
+		relax(index, last, getDistance(index, last));
+	}
+}
+
+// ---------------------------------------------------------------
+// build path - follows the parents from the end and fills in the
+// cells between two nodes with diagonal steps first
+// ---------------------------------------------------------------
+int RectPath::buildPath(int start, int end, p2i* points, int max) const {
+	int width = _grid->width;
+	int ret = 0;
+	int current = end;
+	int cx = end % width;
+	int cy = end / width;
+	if (ret < max) {
+		points[ret++] = p2i(cx, cy);
+	}
+	while (current != start && ret < max) {
+		int parent = _nodes[current].parent;
+		int px = parent % width;
+		int py = parent / width;
+		while ((cx != px || cy != py) && ret < max) {
+			cx += px > cx ? 1 : (px < cx ? -1 : 0);
+			cy += py > cy ? 1 : (py < cy ? -1 : 0);
+			points[ret++] = p2i(cx, cy);
+		}
+		current = parent;
+	}
+	return ret;
+}
+
+// ---------------------------------------------------------------
+// find - returns the path from the end back to the start or
+// 0 if the end can not be reached
+// ---------------------------------------------------------------
+int RectPath::find(p2i start, p2i end, p2i* points, int max) {
+	_numOpen = 0;
+	_numExpanded = 0;
+	if (!_grid->isAvailable(start) || !_grid->isAvailable(end)) {
+		return 0;
+	}
+	update();
+	PERF_ZONE("RectPath::find");
+	++_search;
+	int startIdx = _grid->getIndex(start);
+	_end = _grid->getIndex(end);
+	RectNode& first = touch(startIdx);
+	if (_rectIndex[startIdx] == _rectIndex[_end]) {
+		touch(_end).parent = startIdx;
+		return buildPath(startIdx, _end, points, max);
+	}
+	first.g = 0;
+	first.h = getDistance(startIdx, _end);
+	first.f = first.h;
+	push(startIdx);
+	bool startInside = !isBorder(startIdx);
+	while (_numOpen > 0) {
+		int current = pop();
+		_nodes[current].closed = true;
+		++_numExpanded;
+		if (current == _end) {
+			return buildPath(startIdx, _end, points, max);
+		}
+		if (current == startIdx && startInside) {
+			expandRect(current);
+		}
+		else {
+			expandBorder(current);
+		}
+	}
+	return 0;
+}
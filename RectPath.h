@@ -0,0 +1,107 @@
+#pragma once
+#include "src/Grid.h"
+
+// ---------------------------------------------------------------
+// empty rectangle of the decomposition
+// ---------------------------------------------------------------
+struct NavRect {
+	int x;
+	int y;
+	int width;
+	int height;
+};
+
+struct RectNode {
+	int g;
+	int f;
+	int h;
+	int parent;
+	// position in the open heap or -1
+	int heapIndex;
+	// search that touched the node last
+	uint32_t search;
+	bool closed;
+	RectNode() : g(0), f(0), h(0), parent(-1), heapIndex(-1), search(0), closed(false) {}
+};
+
+// ---------------------------------------------------------------
+// RectPath
+//
+// A* with rectangular symmetry reduction. The free cells are split
+// into empty rectangles and only the cells on their borders take
+// part in the search. Inside a rectangle every octile path between
+// two cells is free, so a border cell is connected to
+// - its eight grid neighbours on a border
+// - the border cell at the end of every diagonal through the
+//   inside of its rectangle
+// - the cells of the opposite side that can only be reached by
+//   diagonal and straight steps through the inside
+// Every other path across a rectangle is a walk along a border
+// followed by one of these. The start and the end can be inside a
+// rectangle, the start is connected to its whole border and the
+// end to the border cells of its rectangle. The result is the same
+// path length as APath and the path is expanded back to cells.
+// update reads the change log of the grid. A blocked cell only
+// splits its own rectangle again, an opened cell merges with the
+// rectangles next to it.
+// ---------------------------------------------------------------
+class RectPath {
+
+public:
+	RectPath(Grid* grid);
+	~RectPath();
+	void update();
+	void rebuild();
+	int find(p2i start, p2i end, p2i* points, int max);
+	int numRects() const {
+		return _numRects;
+	}
+	// rectangle of a cell or -1 if it is blocked
+	int getRectIndex(int x, int y) const {
+		return _rectIndex[x + y * _grid->width];
+	}
+	const NavRect& getRect(int index) const {
+		return _rects[index];
+	}
+	// number of nodes taken from the open list by the last search
+	int getNumExpanded() const {
+		return _numExpanded;
+	}
+private:
+	RectPath(const RectPath& orig) {}
+	bool isFree(int x, int y) const;
+	bool isBorder(int index) const;
+	NavRect grow(int x, int y, bool horizontal) const;
+	void decompose(int left, int top, int right, int bottom);
+	void dissolve(int rect, int* bounds);
+	void removeCell(int index);
+	void addCell(int index);
+	RectNode& touch(int index);
+	bool less(int first, int second) const;
+	void push(int index);
+	int pop();
+	void siftUp(int pos);
+	void siftDown(int pos);
+	int getDistance(int first, int second) const;
+	void relax(int from, int to, int cost);
+	void expandBorder(int index);
+	void expandRect(int index);
+	int buildPath(int start, int end, p2i* points, int max) const;
+	Grid* _grid;
+	uint8_t* _passable;
+	int* _rectIndex;
+	NavRect* _rects;
+	int* _freeRects;
+	int _numFreeRects;
+	int _numSlots;
+	int _numRects;
+	RectNode* _nodes;
+	int* _open;
+	int _numOpen;
+	int _numExpanded;
+	uint32_t _search;
+	int _end;
+	int* _changes;
+	uint32_t _version;
+	bool _valid;
+};
@@ -0,0 +1,361 @@
+#include "RegionLabels.h"
+#include "FlowField.h"
+#include "src/lib/LinearArena.h"
+#include <ds_profiler.h>
+#include <string.h>
+
+// ---------------------------------------------------------------
+// a mark holds the epoch of the split in the upper bits and the
+// search in the lower ones
+// ---------------------------------------------------------------
+const static int MARK_SHIFT = 3;
+const static uint32_t MAX_EPOCH = 1u << (32 - MARK_SHIFT);
+
+// ---------------------------------------------------------------
+// ctor
+// ---------------------------------------------------------------
+RegionLabels::RegionLabels(Grid* grid, const FlowField* flowField) : _grid(grid), _flowField(flowField), _eightWay(true), _numIds(0), _numRegions(0), _epoch(1), _numVisited(0), _version(0), _valid(false) {
+	int total = _grid->width * _grid->height;
+	_passable = new uint8_t[total];
+	_labels = new int[total];
+	// every split or opened cell takes new ids, running out of them
+	// rebuilds everything
+	_capacity = total * 2 + MAX_REGION_SEARCHES;
+	_parents = new int[_capacity];
+	_marks = new uint32_t[total];
+	memset(_marks, 0, total * sizeof(uint32_t));
+	_changes = new int[GRID_CHANGE_LOG_SIZE];
+}
+
+// ---------------------------------------------------------------
+// dtor
+// ---------------------------------------------------------------
+RegionLabels::~RegionLabels() {
+	delete[] _changes;
+	delete[] _marks;
+	delete[] _parents;
+	delete[] _labels;
+	delete[] _passable;
+}
+
+// ---------------------------------------------------------------
+// is passable - reads the grid, the labels use the snapshot
+// ---------------------------------------------------------------
+bool RegionLabels::isPassable(int index) const {
+	if (_flowField != 0) {
+		return _flowField->getTileCost(_grid->items[index]) > 0;
+	}
+	return _grid->isAvailable(index % _grid->width, index / _grid->width);
+}
+
+// ---------------------------------------------------------------
+// get the passable neighbors of the snapshot
+// ---------------------------------------------------------------
+int RegionLabels::getNeighbors(int index, int* ret) const {
+	int x = index % _grid->width;
+	int y = index / _grid->width;
+	int cnt = 0;
+	for (int dy = -1; dy < 2; ++dy) {
+		for (int dx = -1; dx < 2; ++dx) {
+			if ((dx == 0 && dy == 0) || (!_eightWay && dx != 0 && dy != 0)) {
+				continue;
+			}
+			if (_grid->isValid(x + dx, y + dy)) {
+				int n = index + dx + dy * _grid->width;
+				if (_passable[n]) {
+					ret[cnt++] = n;
+				}
+			}
+		}
+	}
+	return cnt;
+}
+
+// ---------------------------------------------------------------
+// find - root of a region id with path halving
+// ---------------------------------------------------------------
+int RegionLabels::find(int id) {
+	while (_parents[id] != id) {
+		_parents[id] = _parents[_parents[id]];
+		id = _parents[id];
+	}
+	return id;
+}
+
+// ---------------------------------------------------------------
+// create region
+// ---------------------------------------------------------------
+int RegionLabels::createRegion() {
+	int id = _numIds++;
+	_parents[id] = id;
+	++_numRegions;
+	return id;
+}
+
+// ---------------------------------------------------------------
+// rebuild - flood fill of all regions
+// ---------------------------------------------------------------
+void RegionLabels::rebuild() {
+	PERF_ZONE("RegionLabels::rebuild");
+	int total = _grid->width * _grid->height;
+	_eightWay = _flowField == 0 || (_flowField->getConnectivity() == FlowFieldConnectivity::EIGHT_WAY && _flowField->getCornerCutting() == CornerCutting::ALLOWED);
+	_numIds = 0;
+	_numRegions = 0;
+	_version = _grid->version;
+	_valid = true;
+	for (int i = 0; i < total; ++i) {
+		_passable[i] = isPassable(i) ? 1 : 0;
+		_labels[i] = -1;
+	}
+	ds::LinearArena* arena = ds::getThreadArena();
+	ds::ArenaScope scope(arena);
+	int* queue = arena->allocArray<int>(total);
+	int neighbors[8];
+	for (int i = 0; i < total; ++i) {
+		if (_passable[i] && _labels[i] == -1) {
+			int id = createRegion();
+			int num = 0;
+			queue[num++] = i;
+			_labels[i] = id;
+			for (int head = 0; head < num; ++head) {
+				int cnt = getNeighbors(queue[head], neighbors);
+				for (int j = 0; j < cnt; ++j) {
+					if (_labels[neighbors[j]] == -1) {
+						_labels[neighbors[j]] = id;
+						queue[num++] = neighbors[j];
+					}
+				}
+			}
+		}
+	}
+}
+
+// ---------------------------------------------------------------
+// update - applies the changes of the grid since the last update
+// ---------------------------------------------------------------
+void RegionLabels::update() {
+	if (!_valid) {
+		rebuild();
+		return;
+	}
+	if (_version == _grid->version) {
+		return;
+	}
+	PERF_ZONE("RegionLabels::update");
+	_numVisited = 0;
+	int num = _grid->getChanges(_version, _changes, GRID_CHANGE_LOG_SIZE);
+	if (num == -1) {
+		rebuild();
+		return;
+	}
+	_version = _grid->version;
+	for (int i = 0; i < num; ++i) {
+		int idx = _changes[i];
+		bool passable = isPassable(idx);
+		if (passable == (_passable[idx] != 0)) {
+			continue;
+		}
+		if (_numIds + MAX_REGION_SEARCHES > _capacity) {
+			rebuild();
+			return;
+		}
+		if (passable) {
+			open(idx);
+		}
+		else {
+			block(idx);
+		}
+	}
+}
+
+// ---------------------------------------------------------------
+// open - joins the regions around the cell
+// ---------------------------------------------------------------
+void RegionLabels::open(int index) {
+	_passable[index] = 1;
+	int neighbors[8];
+	int cnt = getNeighbors(index, neighbors);
+	if (cnt == 0) {
+		_labels[index] = createRegion();
+		return;
+	}
+	int root = find(_labels[neighbors[0]]);
+	for (int i = 1; i < cnt; ++i) {
+		int other = find(_labels[neighbors[i]]);
+		if (other != root) {
+			_parents[other] = root;
+			--_numRegions;
+		}
+	}
+	_labels[index] = root;
+}
+
+// ---------------------------------------------------------------
+// block - the region of the cell disappears if it was alone and
+// may split if its neighbours are not connected around it
+// ---------------------------------------------------------------
+void RegionLabels::block(int index) {
+	_passable[index] = 0;
+	_labels[index] = -1;
+	int seeds[8];
+	int cnt = getNeighbors(index, seeds);
+	if (cnt == 0) {
+		--_numRegions;
+		return;
+	}
+	int num = groupNeighbors(index, seeds, cnt);
+	if (num > 1) {
+		split(seeds, num);
+	}
+}
+
+// ---------------------------------------------------------------
+// group neighbors - keeps one seed of every group of neighbours
+// that are connected inside the 3x3 block around the cell
+// ---------------------------------------------------------------
+int RegionLabels::groupNeighbors(int index, int* seeds, int num) {
+	int x = index % _grid->width;
+	int y = index / _grid->width;
+	//
+	// flood fill of the block, the center is blocked
+	//
+	int groups[9];
+	for (int i = 0; i < 9; ++i) {
+		groups[i] = -1;
+	}
+	int numGroups = 0;
+	int stack[9];
+	for (int i = 0; i < 9; ++i) {
+		int cx = x + i % 3 - 1;
+		int cy = y + i / 3 - 1;
+		if (groups[i] != -1 || !_grid->isValid(cx, cy) || !_passable[cx + cy * _grid->width]) {
+			continue;
+		}
+		int sp = 0;
+		stack[sp++] = i;
+		groups[i] = numGroups;
+		while (sp > 0) {
+			int c = stack[--sp];
+			for (int j = 0; j < 9; ++j) {
+				int dx = j % 3 - c % 3;
+				int dy = j / 3 - c / 3;
+				bool adjacent = (dx != 0 || dy != 0) && dx >= -1 && dx <= 1 && dy >= -1 && dy <= 1 && (_eightWay || dx == 0 || dy == 0);
+				int nx = x + j % 3 - 1;
+				int ny = y + j / 3 - 1;
+				if (adjacent && groups[j] == -1 && _grid->isValid(nx, ny) && _passable[nx + ny * _grid->width]) {
+					groups[j] = numGroups;
+					stack[sp++] = j;
+				}
+			}
+		}
+		++numGroups;
+	}
+	int ret = 0;
+	bool used[9] = { false };
+	for (int i = 0; i < num; ++i) {
+		int dx = seeds[i] % _grid->width - x;
+		int dy = seeds[i] / _grid->width - y;
+		int g = groups[(dy + 1) * 3 + dx + 1];
+		if (!used[g]) {
+			used[g] = true;
+			seeds[ret++] = seeds[i];
+		}
+	}
+	return ret;
+}
+
+// ---------------------------------------------------------------
+// split - lock step searches from the seeds. A search touching a
+// cell of another running search joins it, the other one visits
+// its cells again. A search without cells left has found a new
+// region.
+// ---------------------------------------------------------------
+void RegionLabels::split(const int* seeds, int num) {
+	PERF_ZONE("RegionLabels::split");
+	int total = _grid->width * _grid->height;
+	if (++_epoch >= MAX_EPOCH) {
+		memset(_marks, 0, total * sizeof(uint32_t));
+		_epoch = 1;
+	}
+	ds::LinearArena* arena = ds::getThreadArena();
+	ds::ArenaScope scope(arena);
+	int* queues[MAX_REGION_SEARCHES];
+	int heads[MAX_REGION_SEARCHES];
+	int tails[MAX_REGION_SEARCHES];
+	int owners[MAX_REGION_SEARCHES];
+	bool running[MAX_REGION_SEARCHES];
+	for (int i = 0; i < num; ++i) {
+		queues[i] = arena->allocArray<int>(total);
+		queues[i][0] = seeds[i];
+		heads[i] = 0;
+		tails[i] = 1;
+		owners[i] = i;
+		running[i] = true;
+		_marks[seeds[i]] = (_epoch << MARK_SHIFT) | i;
+	}
+	int numRunning = num;
+	int neighbors[8];
+	while (numRunning > 1) {
+		for (int s = 0; s < num && numRunning > 1; ++s) {
+			if (!running[s]) {
+				continue;
+			}
+			if (heads[s] == tails[s]) {
+				int id = createRegion();
+				for (int i = 0; i < tails[s]; ++i) {
+					_labels[queues[s][i]] = id;
+				}
+				running[s] = false;
+				--numRunning;
+				continue;
+			}
+			int u = queues[s][heads[s]++];
+			++_numVisited;
+			int cnt = getNeighbors(u, neighbors);
+			for (int i = 0; i < cnt; ++i) {
+				int n = neighbors[i];
+				uint32_t mark = _marks[n];
+				if ((mark >> MARK_SHIFT) == _epoch) {
+					int other = static_cast<int>(mark & ((1u << MARK_SHIFT) - 1));
+					if (other == s) {
+						continue;
+					}
+					int owner = other;
+					while (owners[owner] != owner) {
+						owner = owners[owner];
+					}
+					if (owner != s) {
+						owners[s] = owner;
+						running[s] = false;
+						--numRunning;
+						break;
+					}
+				}
+				_marks[n] = (_epoch << MARK_SHIFT) | s;
+				queues[s][tails[s]++] = n;
+			}
+		}
+	}
+}
+
+// ---------------------------------------------------------------
+// get
+// ---------------------------------------------------------------
+int RegionLabels::get(int x, int y) {
+	int idx = x + y * _grid->width;
+	if (_labels[idx] == -1) {
+		return -1;
+	}
+	return find(_labels[idx]);
+}
+
+// ---------------------------------------------------------------
+// is connected - both cells are passable and in the same region
+// ---------------------------------------------------------------
+bool RegionLabels::isConnected(const p2i& first, const p2i& second) {
+	if (!_grid->isValid(first) || !_grid->isValid(second)) {
+		return false;
+	}
+	int a = get(first.x, first.y);
+	return a != -1 && a == get(second.x, second.y);
+}
@@ -0,0 +1,70 @@
+#pragma once
+#include "src/Grid.h"
+
+class FlowField;
+
+// at most this many searches run when a blocked cell splits a region
+const static int MAX_REGION_SEARCHES = 8;
+
+// ---------------------------------------------------------------
+// RegionLabels
+//
+// Labels the connected regions of passable cells so two cells can
+// be tested for a connection in constant time. Without a flow
+// field the cells of Grid::isAvailable are used with eight way
+// steps like APath. With a flow field its tile costs are used and
+// the steps are eight way only if corners can always be cut,
+// otherwise a diagonal always has a passable corner and four way
+// steps give the same regions.
+// update reads the change log of the grid. Every cell holds a
+// region id and the ids are merged by union-find, so opening a
+// cell only joins the regions around it. Blocking a cell can split
+// its region. The neighbours that are not connected inside the
+// 3x3 block around it start searches that run in lock step. A
+// search meeting another one joins it, a search running out of
+// cells has found a new region and relabels it. The last running
+// search keeps the old id, so only the smaller parts are visited.
+// ---------------------------------------------------------------
+class RegionLabels {
+
+public:
+	RegionLabels(Grid* grid, const FlowField* flowField = 0);
+	~RegionLabels();
+	void update();
+	void rebuild();
+	// region of a cell or -1 if it is blocked
+	int get(int x, int y);
+	bool isConnected(const p2i& first, const p2i& second);
+	int num() const {
+		return _numRegions;
+	}
+	// number of cells visited by the searches of the last update
+	int getNumVisited() const {
+		return _numVisited;
+	}
+private:
+	RegionLabels(const RegionLabels& orig) {}
+	bool isPassable(int index) const;
+	int getNeighbors(int index, int* ret) const;
+	int find(int id);
+	int createRegion();
+	void open(int index);
+	void block(int index);
+	int groupNeighbors(int index, int* seeds, int num);
+	void split(const int* seeds, int num);
+	Grid* _grid;
+	const FlowField* _flowField;
+	bool _eightWay;
+	uint8_t* _passable;
+	int* _labels;
+	int* _parents;
+	int _capacity;
+	int _numIds;
+	int _numRegions;
+	uint32_t* _marks;
+	uint32_t _epoch;
+	int* _changes;
+	int _numVisited;
+	uint32_t _version;
+	bool _valid;
+};
@@ -0,0 +1,56 @@
+#include "BenchRunner.h"
+#include <string.h>
+
+// ---------------------------------------------------------------
+// a case is enabled if the filter is part of its name
+// ---------------------------------------------------------------
+bool BenchRunner::isEnabled(const char* name) const {
+	if (_filter == 0) {
+		return true;
+	}
+	return strstr(name, _filter) != 0;
+}
+
+// ---------------------------------------------------------------
+// add result and print a short summary
+// ---------------------------------------------------------------
+void BenchRunner::add(const char* name, const char* map, int width, int height, std::vector<double>& samples, uint64_t allocations) {
+	BenchResult r;
+	strncpy(r.name, name, sizeof(r.name) - 1);
+	r.name[sizeof(r.name) - 1] = '\0';
+	strncpy(r.map, map, sizeof(r.map) - 1);
+	r.map[sizeof(r.map) - 1] = '\0';
+	r.width = width;
+	r.height = height;
+	r.iterations = static_cast<int>(samples.size());
+	std::sort(samples.begin(), samples.end());
+	r.minMs = samples[0];
+	r.medianMs = samples[samples.size() / 2];
+	double sum = 0.0;
+	for (size_t i = 0; i < samples.size(); ++i) {
+		sum += samples[i];
+	}
+	r.meanMs = sum / samples.size();
+	r.allocations = allocations;
+	_results.push_back(r);
+	fprintf(stderr, "%-24s %-8s %5dx%-5d %12.4f ms (%d runs)\n", r.name, r.map, r.width, r.height, r.medianMs, r.iterations);
+}
+
+// ---------------------------------------------------------------
+// write all results as JSON
+// ---------------------------------------------------------------
+void BenchRunner::writeJSON(FILE* fp) const {
+	fprintf(fp, "{\n");
+	fprintf(fp, "  \"version\": 1,\n");
+	fprintf(fp, "  \"seed\": %u,\n", _seed);
+	fprintf(fp, "  \"results\": [\n");
+	for (size_t i = 0; i < _results.size(); ++i) {
+		const BenchResult& r = _results[i];
+		fprintf(fp, "    { \"name\": \"%s\", \"map\": \"%s\", \"width\": %d, \"height\": %d, \"iterations\": %d, "
+			"\"min_ms\": %.6f, \"median_ms\": %.6f, \"mean_ms\": %.6f, \"allocations\": %llu }%s\n",
+			r.name, r.map, r.width, r.height, r.iterations, r.minMs, r.medianMs, r.meanMs,
+			static_cast<unsigned long long>(r.allocations), i + 1 < _results.size() ? "," : "");
+	}
+	fprintf(fp, "  ]\n");
+	fprintf(fp, "}\n");
+}
@@ -0,0 +1,93 @@
+#pragma once
+#include <stdio.h>
+#include <stdint.h>
+#include <vector>
+#include <chrono>
+#include <algorithm>
+#include "../src/lib/AllocationCounter.h"
+
+// ---------------------------------------------------------------
+// result of one benchmark case
+// ---------------------------------------------------------------
+struct BenchResult {
+	char name[64];
+	char map[16];
+	int width;
+	int height;
+	int iterations;
+	double minMs;
+	double medianMs;
+	double meanMs;
+	uint64_t allocations;
+};
+
+// ---------------------------------------------------------------
+// BenchRunner
+//
+// Runs every case at least MIN_ITERATIONS times and keeps going
+// until MIN_TOTAL_MS have passed or MAX_ITERATIONS are reached.
+// The setup function is called before every iteration and is
+// not measured. Results are written as JSON.
+// ---------------------------------------------------------------
+class BenchRunner {
+
+	typedef std::chrono::high_resolution_clock Clock;
+
+public:
+	BenchRunner(const char* filter, uint32_t seed) : _filter(filter), _seed(seed) {}
+	bool isEnabled(const char* name) const;
+	template<class Setup, class Body>
+	void run(const char* name, const char* map, int width, int height, Setup setup, Body body);
+	template<class Body>
+	void run(const char* name, const char* map, int width, int height, Body body) {
+		run(name, map, width, height, []() {}, body);
+	}
+	void writeJSON(FILE* fp) const;
+private:
+	void add(const char* name, const char* map, int width, int height, std::vector<double>& samples, uint64_t allocations);
+	const char* _filter;
+	uint32_t _seed;
+	std::vector<BenchResult> _results;
+};
+
+const int MIN_ITERATIONS = 3;
+const int MAX_ITERATIONS = 1000;
+const double MIN_TOTAL_MS = 250.0;
+const double SINGLE_RUN_MS = 2000.0;
+
+// ---------------------------------------------------------------
+// run one case
+// ---------------------------------------------------------------
+template<class Setup, class Body>
+void BenchRunner::run(const char* name, const char* map, int width, int height, Setup setup, Body body) {
+	if (!isEnabled(name)) {
+		return;
+	}
+	std::vector<double> samples;
+	uint64_t allocations = 0;
+	double total = 0.0;
+	// warm up - very slow cases only run once
+	setup();
+	uint64_t before = ds::getNumAllocations();
+	Clock::time_point start = Clock::now();
+	body();
+	double first = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+	if (first >= SINGLE_RUN_MS) {
+		samples.push_back(first);
+		allocations = ds::getNumAllocations() - before;
+	}
+	else {
+		while ((int)samples.size() < MAX_ITERATIONS && ((int)samples.size() < MIN_ITERATIONS || total < MIN_TOTAL_MS)) {
+			setup();
+			before = ds::getNumAllocations();
+			start = Clock::now();
+			body();
+			double ms = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+			allocations += ds::getNumAllocations() - before;
+			samples.push_back(ms);
+			total += ms;
+		}
+		allocations /= samples.size();
+	}
+	add(name, map, width, height, samples, allocations);
+}
@@ -0,0 +1,194 @@
+#include "MapCorpus.h"
+#include "../src/Grid.h"
+
+const char* MAP_TYPE_NAMES[] = { "open", "maze", "rooms", "spiral", "terrain" };
+
+const char* getMapTypeName(MapType::Enum type) {
+	return MAP_TYPE_NAMES[type];
+}
+
+// ---------------------------------------------------------------
+// fill the entire grid
+// ---------------------------------------------------------------
+static void fill(Grid* grid, int v) {
+	int total = grid->width * grid->height;
+	for (int i = 0; i < total; ++i) {
+		grid->items[i] = v;
+	}
+}
+
+// ---------------------------------------------------------------
+// open field with scattered single blockers like placed towers
+// ---------------------------------------------------------------
+static void generateOpen(Grid* grid, BenchRandom& rnd) {
+	fill(grid, 0);
+	int total = grid->width * grid->height;
+	for (int i = 0; i < total / 10; ++i) {
+		grid->items[rnd.next() % total] = 1;
+	}
+	grid->set(0, 0, 0);
+	grid->set(grid->width - 1, grid->height - 1, 0);
+	grid->setStart(0, 0);
+	grid->setEnd(grid->width - 1, grid->height - 1);
+}
+
+// ---------------------------------------------------------------
+// perfect maze built by an iterative recursive backtracker on
+// the odd cells
+// ---------------------------------------------------------------
+static void generateMaze(Grid* grid, BenchRandom& rnd) {
+	fill(grid, 1);
+	int cw = (grid->width - 1) / 2;
+	int ch = (grid->height - 1) / 2;
+	int* stack = new int[cw * ch];
+	int num = 0;
+	grid->items[grid->getIndex(1, 1)] = 0;
+	stack[num++] = 0;
+	const p2i dirs[] = { p2i(1,0), p2i(-1,0), p2i(0,1), p2i(0,-1) };
+	while (num > 0) {
+		int current = stack[num - 1];
+		int cx = current % cw;
+		int cy = current / cw;
+		int candidates[4];
+		int numCandidates = 0;
+		for (int i = 0; i < 4; ++i) {
+			int nx = cx + dirs[i].x;
+			int ny = cy + dirs[i].y;
+			if (nx >= 0 && nx < cw && ny >= 0 && ny < ch && grid->get(nx * 2 + 1, ny * 2 + 1) == 1) {
+				candidates[numCandidates++] = i;
+			}
+		}
+		if (numCandidates == 0) {
+			--num;
+		}
+		else {
+			const p2i& d = dirs[candidates[rnd.next() % numCandidates]];
+			int nx = cx + d.x;
+			int ny = cy + d.y;
+			grid->items[grid->getIndex(cx * 2 + 1 + d.x, cy * 2 + 1 + d.y)] = 0;
+			grid->items[grid->getIndex(nx * 2 + 1, ny * 2 + 1)] = 0;
+			stack[num++] = nx + ny * cw;
+		}
+	}
+	delete[] stack;
+	grid->setStart(1, 1);
+	grid->setEnd(cw * 2 - 1, ch * 2 - 1);
+}
+
+// ---------------------------------------------------------------
+// carve a rectangle
+// ---------------------------------------------------------------
+static void carve(Grid* grid, int x0, int y0, int x1, int y1) {
+	for (int y = y0; y <= y1; ++y) {
+		for (int x = x0; x <= x1; ++x) {
+			if (grid->isValid(x, y)) {
+				grid->items[grid->getIndex(x, y)] = 0;
+			}
+		}
+	}
+}
+
+// ---------------------------------------------------------------
+// rooms connected by L shaped corridors
+// ---------------------------------------------------------------
+static void generateRooms(Grid* grid, BenchRandom& rnd) {
+	fill(grid, 1);
+	int numRooms = grid->width * grid->height / 150;
+	if (numRooms < 2) {
+		numRooms = 2;
+	}
+	p2i first(-1, -1);
+	p2i last(-1, -1);
+	for (int i = 0; i < numRooms; ++i) {
+		int w = rnd.next(2, 8);
+		int h = rnd.next(2, 6);
+		int x = rnd.next(0, grid->width - 1 - w);
+		int y = rnd.next(0, grid->height - 1 - h);
+		carve(grid, x, y, x + w, y + h);
+		p2i center(x + w / 2, y + h / 2);
+		if (i == 0) {
+			first = center;
+		}
+		else {
+			carve(grid, last.x < center.x ? last.x : center.x, last.y, last.x < center.x ? center.x : last.x, last.y);
+			carve(grid, center.x, last.y < center.y ? last.y : center.y, center.x, last.y < center.y ? center.y : last.y);
+		}
+		last = center;
+	}
+	grid->setStart(first);
+	grid->setEnd(last);
+}
+
+// ---------------------------------------------------------------
+// nested rings with the openings on alternating sides, so the
+// path from the border to the center winds around every ring
+// ---------------------------------------------------------------
+static void generateSpiral(Grid* grid) {
+	fill(grid, 0);
+	int ring = 0;
+	for (int d = 1; d * 2 + 2 < grid->width && d * 2 + 2 < grid->height; d += 2) {
+		int x0 = d;
+		int y0 = d;
+		int x1 = grid->width - 1 - d;
+		int y1 = grid->height - 1 - d;
+		for (int x = x0; x <= x1; ++x) {
+			grid->items[grid->getIndex(x, y0)] = 1;
+			grid->items[grid->getIndex(x, y1)] = 1;
+		}
+		for (int y = y0; y <= y1; ++y) {
+			grid->items[grid->getIndex(x0, y)] = 1;
+			grid->items[grid->getIndex(x1, y)] = 1;
+		}
+		if ((ring & 1) == 0) {
+			grid->items[grid->getIndex(x0 + 1, y0)] = 0;
+		}
+		else {
+			grid->items[grid->getIndex(x1 - 1, y1)] = 0;
+		}
+		++ring;
+	}
+	int cx = grid->width / 2;
+	int cy = grid->height / 2;
+	grid->items[grid->getIndex(cx, cy)] = 0;
+	grid->setStart(0, 0);
+	grid->setEnd(cx, cy);
+}
+
+// ---------------------------------------------------------------
+// open field covered with patches of mud and swamp which are
+// passable at a higher cost
+// ---------------------------------------------------------------
+static void generateTerrain(Grid* grid, BenchRandom& rnd) {
+	generateOpen(grid, rnd);
+	int numPatches = grid->width * grid->height / 40;
+	for (int i = 0; i < numPatches; ++i) {
+		int w = rnd.next(1, 6);
+		int h = rnd.next(1, 6);
+		int x = rnd.next(0, grid->width - 1);
+		int y = rnd.next(0, grid->height - 1);
+		int type = (rnd.next() & 1) ? TERRAIN_MUD : TERRAIN_SWAMP;
+		for (int py = y; py < y + h && py < grid->height; ++py) {
+			for (int px = x; px < x + w && px < grid->width; ++px) {
+				int idx = grid->getIndex(px, py);
+				if (grid->items[idx] == 0) {
+					grid->items[idx] = type;
+				}
+			}
+		}
+	}
+}
+
+// ---------------------------------------------------------------
+// generate map
+// ---------------------------------------------------------------
+void generateMap(Grid* grid, MapType::Enum type, uint32_t seed) {
+	BenchRandom rnd(seed * 31 + type);
+	switch (type) {
+		case MapType::OPEN: generateOpen(grid, rnd); break;
+		case MapType::MAZE: generateMaze(grid, rnd); break;
+		case MapType::ROOMS: generateRooms(grid, rnd); break;
+		case MapType::SPIRAL: generateSpiral(grid); break;
+		case MapType::TERRAIN: generateTerrain(grid, rnd); break;
+		default: break;
+	}
+}
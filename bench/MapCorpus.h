@@ -0,0 +1,55 @@
+#pragma once
+#include <stdint.h>
+
+struct Grid;
+
+// ---------------------------------------------------------------
+// kinds of generated maps
+// ---------------------------------------------------------------
+struct MapType {
+
+	enum Enum {
+		OPEN,
+		MAZE,
+		ROOMS,
+		SPIRAL,
+		TERRAIN,
+		NUM
+	};
+};
+
+const char* getMapTypeName(MapType::Enum type);
+
+// ---------------------------------------------------------------
+// small deterministic random number generator so the corpus is
+// the same on every machine
+// ---------------------------------------------------------------
+struct BenchRandom {
+
+	uint32_t state;
+
+	BenchRandom(uint32_t seed) : state(seed != 0 ? seed : 0x9e3779b9) {}
+
+	uint32_t next() {
+		state ^= state << 13;
+		state ^= state >> 17;
+		state ^= state << 5;
+		return state;
+	}
+
+	int next(int min, int max) {
+		return min + static_cast<int>(next() % static_cast<uint32_t>(max - min + 1));
+	}
+};
+
+// tile types of the terrain map and the costs the benchmark uses
+const int TERRAIN_MUD = 4;
+const int TERRAIN_SWAMP = 5;
+const int TERRAIN_MUD_COST = 4;
+const int TERRAIN_SWAMP_COST = 9;
+
+// ---------------------------------------------------------------
+// fills the grid with a map of the given type. Start and end are
+// always set and connected.
+// ---------------------------------------------------------------
+void generateMap(Grid* grid, MapType::Enum type, uint32_t seed);
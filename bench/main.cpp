@@ -0,0 +1,2022 @@
+#ifdef BENCH_WITH_GAME
+#define DS_IMPLEMENTATION
+#include <diesel.h>
+#define STB_IMAGE_IMPLEMENTATION
+#include <stb_image.h>
+#define SPRITE_IMPLEMENTATION
+#include <SpriteBatchBuffer.h>
+#define GAMESETTINGS_IMPLEMENTATION
+#include <ds_tweakable.h>
+#define DS_GAME_UI_IMPLEMENTATION
+#include <ds_game_ui.h>
+#define DS_TWEENING_IMPLEMENTATION
+#include <ds_tweening.h>
+#define DS_IMGUI_IMPLEMENTATION
+#include <ds_imgui.h>
+#endif
+#define DS_PROFILER_IMPLEMENTATION
+#include <ds_profiler.h>
+#ifdef BENCH_WITH_GAME
+#define BASE_APP_IMPLEMENTATION
+#include <ds_base_app.h>
+#else
+#define DS_EVENT_STREAM_IMPLEMENTATION
+#include <ds_event_stream.h>
+#define SPRITE_NO_DIESEL
+#define SPRITE_IMPLEMENTATION
+#include <SpriteBatchBuffer.h>
+#endif
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <thread>
+#include <atomic>
+#include "BenchRunner.h"
+#include "MapCorpus.h"
+#include "../src/Grid.h"
+#include "../FlowField.h"
+#include "../AsyncFlowField.h"
+#include "../APath.h"
+#include "../Landmarks.h"
+#include "../PathCache.h"
+#include "../PathSmoother.h"
+#include "../ConnectivityAnalyzer.h"
+#include "../RegionLabels.h"
+#include "../RectPath.h"
+#include "../src/Simulation.h"
+#include "../src/EventTypes.h"
+#include "../src/PathTable.h"
+#include "../src/CrowdSeparation.h"
+#include "../src/utils/CSVFile.h"
+#include "../src/lib/LinearArena.h"
+#include "../src/lib/ReplayLog.h"
+#include "../src/lib/TweenEngine.h"
+#include "../src/lib/JobSystem.h"
+#ifdef BENCH_WITH_GAME
+#include "../src/Battleground.h"
+#endif
+
+// ---------------------------------------------------------------
+// Headless benchmarks of the core engines. Nothing here opens a
+// window. The core engines build on every platform, see
+// CMakeLists.txt. With BENCH_WITH_GAME the battleground cases are
+// compiled in as well. They need diesel and the base app, so only
+// the Visual Studio project defines it.
+//
+// usage: Bench [--out file.json] [--filter name] [--max-size n] [--seed n] [--replay file] [--validate]
+//
+// --validate runs the validation cases instead of the benchmarks.
+// They check the engines against a reference and the exit code is
+// 1 if one of them fails. ctest runs them.
+//
+// --replay runs a log recorded by the game through the complete
+// battleground simulation as fast as possible. It loads the level
+// and definitions like the game so it has to be started in the
+// game directory. It fails if a warmed up tick allocates. It
+// needs BENCH_WITH_GAME.
+// ---------------------------------------------------------------
+
+struct MapSize {
+	int width;
+	int height;
+};
+
+const MapSize MAP_SIZES[] = { { 20, 12 }, { 64, 64 }, { 256, 256 }, { 1024, 1024 }, { 4096, 4096 } };
+const int NUM_MAP_SIZES = 5;
+
+// APath keeps a WayPoint for every cell and the landmarks K distance tables
+const int MAX_APATH_CELLS = 1024 * 1024;
+
+const int NUM_CSV_LINES = 100000;
+
+// ticks before the allocation check starts and ticks it covers
+const int WARM_UP_TICKS = 60;
+const int CHECKED_TICKS = 240;
+
+// eikonal costs in percent of the octile costs give or take one
+// diagonal step through swamp
+const int EIKONAL_MIN_RATIO = 85;
+const int EIKONAL_MAX_RATIO = 125;
+const int EIKONAL_SLACK = 14 * TERRAIN_SWAMP_COST;
+
+// ---------------------------------------------------------------
+// add a walker at the center of a cell
+// ---------------------------------------------------------------
+static void addWalker(Walkers* walkers, int x, int y) {
+	ID id = walkers->add();
+	Walker& w = walkers->get(id);
+	w.gridPos = p2i(x, y);
+	w.pos = ds::vec2(START_X + x * 46, START_Y + y * 46);
+	w.rotation = 0.0f;
+	w.velocity = 80.0f;
+	w.type = WalkerType::SIMPLE_CELL;
+	w.definitionIndex = 0;
+	w.energy = 100;
+	w.pathID = -1;
+	w.distance = 0.0f;
+	w.offset = ds::vec2(0.0f, 0.0f);
+}
+
+// ---------------------------------------------------------------
+// random free cell the flow field reaches, the end if none is found
+// ---------------------------------------------------------------
+static p2i getRandomReachableCell(const Grid& grid, const FlowField& flowField, BenchRandom& rnd) {
+	for (int tries = 0; tries < 100000; ++tries) {
+		int x = rnd.next(0, grid.width - 1);
+		int y = rnd.next(0, grid.height - 1);
+		if (grid.isAvailable(x, y) && flowField.getCost(x, y) != FLOW_FIELD_UNREACHABLE) {
+			return p2i(x, y);
+		}
+	}
+	return grid.getEnd();
+}
+
+// ---------------------------------------------------------------
+// fill walkers at random reachable cells
+// ---------------------------------------------------------------
+static void createWalkers(Walkers* walkers, const Grid& grid, const FlowField& flowField, BenchRandom& rnd) {
+	walkers->clear();
+	int total = grid.width * grid.height;
+	int tries = 0;
+	while (walkers->numObjects < 4096 && tries < 100000) {
+		++tries;
+		int idx = rnd.next() % total;
+		int x = idx % grid.width;
+		int y = idx / grid.width;
+		if (grid.isAvailable(x, y) && flowField.getCost(x, y) != FLOW_FIELD_UNREACHABLE) {
+			addWalker(walkers, x, y);
+		}
+	}
+}
+
+// ---------------------------------------------------------------
+// benchmarks running on one generated map
+// ---------------------------------------------------------------
+static void runMapBenchmarks(BenchRunner& runner, MapType::Enum type, const MapSize& size, uint32_t seed, ds::JobSystem* jobs) {
+	const char* name = getMapTypeName(type);
+	Grid grid(size.width, size.height);
+	generateMap(&grid, type, seed);
+	p2i start = grid.getStart();
+	p2i end = grid.getEnd();
+	int total = size.width * size.height;
+
+	FlowField flowField(&grid);
+	flowField.setTileCost(TERRAIN_MUD, TERRAIN_MUD_COST);
+	flowField.setTileCost(TERRAIN_SWAMP, TERRAIN_SWAMP_COST);
+	runner.run("flowfield.build", name, size.width, size.height, [&]() {
+		flowField.build(end);
+	});
+	flowField.build(end);
+
+	if (runner.isEnabled("flowfield.build_parallel")) {
+		FlowField parallel(&grid);
+		parallel.setMethod(FlowFieldMethod::PARALLEL_BFS, jobs);
+		runner.run("flowfield.build_parallel", name, size.width, size.height, [&]() {
+			parallel.build(end);
+		});
+	}
+
+	if (runner.isEnabled("flowfield.build_8way")) {
+		FlowField octile(&grid);
+		octile.setTileCost(TERRAIN_MUD, TERRAIN_MUD_COST);
+		octile.setTileCost(TERRAIN_SWAMP, TERRAIN_SWAMP_COST);
+		octile.setConnectivity(FlowFieldConnectivity::EIGHT_WAY, CornerCutting::NEVER);
+		runner.run("flowfield.build_8way", name, size.width, size.height, [&]() {
+			octile.build(end);
+		});
+	}
+
+	//
+	// the cost of a rebuild request on the calling thread. The last
+	// build is finished and published before every request.
+	//
+	if (runner.isEnabled("flowfield.request_async")) {
+		AsyncFlowField async(&grid);
+		async.setTileCost(TERRAIN_MUD, TERRAIN_MUD_COST);
+		async.setTileCost(TERRAIN_SWAMP, TERRAIN_SWAMP_COST);
+		runner.run("flowfield.request_async", name, size.width, size.height, [&]() {
+			async.wait();
+			async.update();
+		}, [&]() {
+			async.requestBuild(end);
+		});
+		async.wait();
+	}
+
+	//
+	// the eikonal sweeps need a round per bend of the path so they
+	// are only measured on the open maps
+	//
+	if ((type == MapType::OPEN || type == MapType::TERRAIN) && runner.isEnabled("flowfield.build_eikonal")) {
+		FlowField eikonal(&grid);
+		eikonal.setTileCost(TERRAIN_MUD, TERRAIN_MUD_COST);
+		eikonal.setTileCost(TERRAIN_SWAMP, TERRAIN_SWAMP_COST);
+		eikonal.setConnectivity(FlowFieldConnectivity::EIGHT_WAY, CornerCutting::NEVER);
+		eikonal.setMethod(FlowFieldMethod::EIKONAL, jobs);
+		runner.run("flowfield.build_eikonal", name, size.width, size.height, [&]() {
+			eikonal.build(end);
+		});
+	}
+
+	if (total <= MAX_APATH_CELLS && runner.isEnabled("apath.find")) {
+		APath path(&grid);
+		p2i* points = new p2i[total];
+		runner.run("apath.find", name, size.width, size.height, [&]() {
+			path.find(start, end, points, total);
+		});
+		delete[] points;
+	}
+
+	//
+	// the landmark tables are built once before the measurement. The
+	// queries run between random reachable cells since the start and
+	// the end of the grid are landmarks themselves and would make the
+	// bound exact. The expansions of both searches go to stderr. The
+	// target of a tenth of the expansions is not reached, the corpus
+	// up to 1024x1024 measures between 1.0x and 6.4x.
+	//
+	if (total <= MAX_APATH_CELLS && runner.isEnabled("apath.find_alt")) {
+		const int numPairs = 16;
+		p2i from[numPairs];
+		p2i to[numPairs];
+		BenchRandom rnd(seed);
+		for (int i = 0; i < numPairs; ++i) {
+			from[i] = getRandomReachableCell(grid, flowField, rnd);
+			to[i] = getRandomReachableCell(grid, flowField, rnd);
+		}
+		APath plain(&grid);
+		Landmarks landmarks(&grid);
+		landmarks.update();
+		APath path(&grid, &landmarks);
+		p2i* points = new p2i[total];
+		int plainExpanded = 0;
+		int expanded = 0;
+		for (int i = 0; i < numPairs; ++i) {
+			plain.find(from[i], to[i], points, total);
+			plainExpanded += plain.getNumExpanded();
+			path.find(from[i], to[i], points, total);
+			expanded += path.getNumExpanded();
+		}
+		runner.run("apath.find_alt", name, size.width, size.height, [&]() {
+			for (int i = 0; i < numPairs; ++i) {
+				path.find(from[i], to[i], points, total);
+			}
+		});
+		float ratio = static_cast<float>(plainExpanded) / static_cast<float>(expanded > 0 ? expanded : 1);
+		fprintf(stderr, "apath %s %dx%d: %d expanded, %d with landmarks over %d random pairs (%.1fx)", name, size.width, size.height, plainExpanded, expanded, numPairs, ratio);
+		if (expanded * 10 > plainExpanded) {
+			fprintf(stderr, " - 10x target not reached");
+		}
+		fprintf(stderr, "\n");
+		delete[] points;
+	}
+
+	//
+	// the decomposition is built once before the measurement, the
+	// expansions of both searches go to stderr for comparison
+	//
+	if (total <= MAX_APATH_CELLS && runner.isEnabled("rectpath.find")) {
+		APath plain(&grid);
+		RectPath path(&grid);
+		path.rebuild();
+		p2i* points = new p2i[total];
+		plain.find(start, end, points, total);
+		runner.run("rectpath.find", name, size.width, size.height, [&]() {
+			path.find(start, end, points, total);
+		});
+		fprintf(stderr, "rectpath %s %dx%d: %d rectangles, %d expanded, %d without\n", name, size.width, size.height, path.numRects(), path.getNumExpanded(), plain.getNumExpanded());
+		delete[] points;
+	}
+
+	//
+	// walkers from the same start to the same end only run the
+	// search once, all following queries are decoded from the cache
+	//
+	if (total <= MAX_APATH_CELLS && runner.isEnabled("pathcache.find")) {
+		APath path(&grid);
+		PathCache cache(&grid, &path);
+		p2i* points = new p2i[total];
+		cache.find(start, end, points, total);
+		runner.run("pathcache.find", name, size.width, size.height, [&]() {
+			cache.find(start, end, points, total);
+		});
+		delete[] points;
+	}
+
+	if (total <= MAX_APATH_CELLS && runner.isEnabled("path.pull")) {
+		APath path(&grid);
+		p2i* points = new p2i[total];
+		p2i* waypoints = new p2i[total];
+		int num = path.find(start, end, points, total);
+		int numWaypoints = 0;
+		runner.run("path.pull", name, size.width, size.height, [&]() {
+			numWaypoints = pullString(&grid, 0, points, num, waypoints, total);
+		});
+		fprintf(stderr, "path %s %dx%d: %d cells, %d waypoints\n", name, size.width, size.height, num, numWaypoints);
+		delete[] waypoints;
+		delete[] points;
+	}
+
+	//
+	// the analysis runs on the eight way field the game uses
+	//
+	if (runner.isEnabled("connectivity.build")) {
+		FlowField octile(&grid);
+		octile.setTileCost(TERRAIN_MUD, TERRAIN_MUD_COST);
+		octile.setTileCost(TERRAIN_SWAMP, TERRAIN_SWAMP_COST);
+		octile.setConnectivity(FlowFieldConnectivity::EIGHT_WAY, CornerCutting::NEVER);
+		octile.build(end);
+		ConnectivityAnalyzer analyzer(&grid, &octile);
+		runner.run("connectivity.build", name, size.width, size.height, [&]() {
+			analyzer.build(start, end);
+		});
+		fprintf(stderr, "connectivity %s %dx%d: %d blocking, %d lengthening\n", name, size.width, size.height, analyzer.getNumBlocking(), analyzer.getNumLengthening());
+	}
+
+	//
+	// a random free cell is blocked and opened again. Every update
+	// only sees one change.
+	//
+	if (runner.isEnabled("regions.update")) {
+		RegionLabels regions(&grid, &flowField);
+		regions.update();
+		BenchRandom rnd(seed);
+		runner.run("regions.update", name, size.width, size.height, [&]() {
+			int idx = rnd.next(0, total - 1);
+			if (grid.items[idx] == 0) {
+				grid.set(idx % size.width, idx / size.width, 1);
+				regions.update();
+				grid.set(idx % size.width, idx / size.width, 0);
+				regions.update();
+			}
+		});
+	}
+
+	if (type == MapType::OPEN && runner.isEnabled("grid.load")) {
+		grid.save("bench_grid");
+		Grid loaded(size.width, size.height);
+		runner.run("grid.load", name, size.width, size.height, [&]() {
+			loaded.load("bench_grid");
+		});
+		remove("bench_grid.lvl");
+	}
+
+	if (runner.isEnabled("walkers.update")) {
+		BenchRandom rnd(seed);
+		Walkers* source = new Walkers;
+		Walkers* walkers = new Walkers;
+		createWalkers(source, grid, flowField, rnd);
+		runner.run("walkers.update", name, size.width, size.height, [&]() {
+			*walkers = *source;
+		}, [&]() {
+			moveWalkers(*walkers, &flowField, 0, 1.0f / 60.0f);
+		});
+		delete walkers;
+		delete source;
+	}
+
+	//
+	// the same number of walkers spread along the pulled path from
+	// the start to the end
+	//
+	if (runner.isEnabled("walkers.follow_path") && flowField.getCost(start.x, start.y) != FLOW_FIELD_UNREACHABLE) {
+		std::vector<p2i> cells;
+		p2i current = start;
+		while (flowField.hasNext(current)) {
+			cells.push_back(current);
+			current = flowField.next(current);
+		}
+		cells.push_back(end);
+		int num = pullString(&grid, &flowField, cells.data(), static_cast<int>(cells.size()), cells.data(), static_cast<int>(cells.size()));
+		PathTable paths(num);
+		int pathID = paths.add(cells.data(), num);
+		BenchRandom rnd(seed);
+		Walkers* source = new Walkers;
+		Walkers* walkers = new Walkers;
+		while (source->numObjects < 4096) {
+			Walker& w = source->get(source->add());
+			w.pathID = pathID;
+			w.distance = paths.getLength(pathID) * static_cast<float>(rnd.next(0, 1000)) / 1000.0f;
+			paths.evaluate(pathID, w.distance, &w.pos, &w.rotation);
+			w.offset = ds::vec2(0.0f, 0.0f);
+			w.gridPos = start;
+			w.velocity = 80.0f;
+			w.type = WalkerType::SIMPLE_CELL;
+			w.definitionIndex = 0;
+			w.energy = 100;
+		}
+		runner.run("walkers.follow_path", name, size.width, size.height, [&]() {
+			*walkers = *source;
+		}, [&]() {
+			moveWalkers(*walkers, &flowField, 0, 1.0f / 60.0f, &paths);
+		});
+		delete walkers;
+		delete source;
+	}
+}
+
+// ---------------------------------------------------------------
+// DataArray add, iterate and remove in random order
+// ---------------------------------------------------------------
+static void runDataArrayBenchmark(BenchRunner& runner, uint32_t seed) {
+	Walkers* walkers = new Walkers;
+	ID* ids = new ID[4096];
+	BenchRandom rnd(seed);
+	float sum = 0.0f;
+	runner.run("dataarray.add_iterate_remove", "none", 0, 0, [&]() {
+		walkers->clear();
+		for (int i = 0; i < 4096; ++i) {
+			ids[i] = walkers->add();
+			walkers->get(ids[i]).velocity = static_cast<float>(i);
+		}
+		for (uint32_t i = 0; i < walkers->numObjects; ++i) {
+			sum += walkers->objects[i].velocity;
+		}
+		for (int i = 4095; i > 0; --i) {
+			int j = rnd.next() % (i + 1);
+			ID tmp = ids[i];
+			ids[i] = ids[j];
+			ids[j] = tmp;
+		}
+		for (int i = 0; i < 4096; ++i) {
+			walkers->remove(ids[i]);
+		}
+	});
+	delete[] ids;
+	delete walkers;
+	if (sum < 0.0f) {
+		printf("%g\n", sum);
+	}
+}
+
+// ---------------------------------------------------------------
+// crowd separation of walkers scattered over a square with about
+// two neighbours in reach of every walker. The map name is the
+// number of walkers.
+// ---------------------------------------------------------------
+static void runCrowdBenchmark(BenchRunner& runner, uint32_t seed) {
+	const int COUNTS[] = { 4096, 32768 };
+	for (int c = 0; c < 2; ++c) {
+		int count = COUNTS[c];
+		int side = static_cast<int>(sqrtf(static_cast<float>(count)) * SEPARATION_RADIUS * 1.2f);
+		BenchRandom rnd(seed);
+		float* x = new float[count];
+		float* y = new float[count];
+		float* forceX = new float[count];
+		float* forceY = new float[count];
+		for (int i = 0; i < count; ++i) {
+			x[i] = static_cast<float>(rnd.next(0, side));
+			y[i] = static_cast<float>(rnd.next(0, side));
+		}
+		CrowdSeparation crowd(count);
+		char name[16];
+		snprintf(name, sizeof(name), "%d", count);
+		runner.run("crowd.separation", name, side, side, [&]() {
+			crowd.compute(x, y, count, forceX, forceY);
+		});
+		delete[] forceY;
+		delete[] forceX;
+		delete[] y;
+		delete[] x;
+	}
+}
+
+// ---------------------------------------------------------------
+// bullets against walkers scattered over the screen
+// ---------------------------------------------------------------
+static void runBulletBenchmark(BenchRunner& runner, uint32_t seed) {
+	BenchRandom rnd(seed);
+	Walkers* sourceWalkers = new Walkers;
+	Walkers* walkers = new Walkers;
+	Bullets* sourceBullets = new Bullets;
+	Bullets* bullets = new Bullets;
+	for (int i = 0; i < 2048; ++i) {
+		Walker& w = sourceWalkers->get(sourceWalkers->add());
+		w.pos = ds::vec2(static_cast<float>(rnd.next(0, 1020)), static_cast<float>(rnd.next(0, 760)));
+		w.gridPos = p2i(0, 0);
+		w.velocity = 80.0f;
+		w.rotation = 0.0f;
+		w.type = WalkerType::SIMPLE_CELL;
+		w.definitionIndex = 0;
+		w.energy = 100;
+		w.pathID = -1;
+		w.distance = 0.0f;
+		w.offset = ds::vec2(0.0f, 0.0f);
+		Bullet& b = sourceBullets->get(sourceBullets->add());
+		b.pos = ds::vec2(static_cast<float>(rnd.next(0, 1020)), static_cast<float>(rnd.next(0, 760)));
+		float angle = static_cast<float>(rnd.next(0, 359)) * ds::PI / 180.0f;
+		b.velocity = 400.0f * ds::vec2(cos(angle), sin(angle));
+		b.radius = 6.0f;
+		b.timer = 0.0f;
+		b.ttl = 1.0f;
+		b.energy = 20;
+	}
+	runner.run("bullets.update", "none", 0, 0, [&]() {
+		*walkers = *sourceWalkers;
+		*bullets = *sourceBullets;
+	}, [&]() {
+		moveBullets(*bullets, *walkers, 0, 1.0f / 60.0f);
+	});
+	delete bullets;
+	delete sourceBullets;
+	delete walkers;
+	delete sourceWalkers;
+}
+
+// ---------------------------------------------------------------
+// load and parse a generated CSV file
+// ---------------------------------------------------------------
+static void runCSVBenchmark(BenchRunner& runner, uint32_t seed) {
+	if (!runner.isEnabled("csv.load")) {
+		return;
+	}
+	BenchRandom rnd(seed);
+	FILE* fp = fopen("bench_data.csv", "w");
+	if (fp == 0) {
+		return;
+	}
+	fprintf(fp, "# generated by the benchmark\n");
+	for (int i = 0; i < NUM_CSV_LINES; ++i) {
+		fprintf(fp, "%d, %d, %d, %d, %d, %d, %d, %d, %d, %d.5\n", rnd.next(0, 512), rnd.next(0, 512), 30, 30,
+			rnd.next(1, 2000), rnd.next(0, 255), rnd.next(0, 255), rnd.next(0, 255), 255, rnd.next(10, 200));
+	}
+	fclose(fp);
+	int sum = 0;
+	runner.run("csv.load", "none", 0, 0, [&]() {
+		ds::ArenaScope scope(ds::getThreadArena());
+		CSVFile file(ds::getThreadArena());
+		if (file.load("bench_data.csv", ".")) {
+			for (size_t i = 0; i < file.size(); ++i) {
+				const TextLine& tl = file.get(i);
+				for (int j = 0; j < 9; ++j) {
+					sum += tl.get_int(j);
+				}
+				sum += static_cast<int>(tl.get_float(9));
+			}
+		}
+	});
+	remove("bench_data.csv");
+	if (sum == 42) {
+		printf("%d\n", sum);
+	}
+}
+
+// ---------------------------------------------------------------
+// sprites submitted through the recording backend. Measures the
+// CPU side of the sprite batch buffer without any GPU work.
+// ---------------------------------------------------------------
+static void runSpriteBenchmark(BenchRunner& runner, uint32_t seed) {
+	if (!runner.isEnabled("sprites.add") && !runner.isEnabled("sprites.add_packed")) {
+		return;
+	}
+	BenchRandom rnd(seed);
+	const int num = 20000;
+	Sprite* sprites = new Sprite[num];
+	for (int i = 0; i < num; ++i) {
+		sprites[i] = Sprite(ds::vec2(static_cast<float>(rnd.next(0, 1020)), static_cast<float>(rnd.next(0, 760))), ds::vec4(0, 60, 12, 12));
+	}
+	RecordingSpriteBatchBackend backend;
+	SpriteBatchBuffer buffer(SpriteBatchBufferInfo(2048, NO_RID), &backend);
+	runner.run("sprites.add", "none", 0, 0, [&]() {
+		buffer.begin();
+		for (int i = 0; i < num; ++i) {
+			buffer.add(sprites[i]);
+		}
+		buffer.flush();
+	});
+	const SpriteBatchStats& stats = backend.getCurrentFrame();
+	fprintf(stderr, "sprites.add: %u sprites, %u flushes, %u bytes per frame\n", stats.sprites, stats.flushes, stats.bytes);
+	//
+	// the same sprites packed into 16 bytes each, the rect is looked
+	// up in the atlas once before the measurement
+	//
+	if (runner.isEnabled("sprites.add_packed")) {
+		SpriteAtlas atlas;
+		uint16_t rect = atlas.add(sprites[0].textureRect);
+		RecordingSpriteBatchBackend packedBackend;
+		PackedSpriteBatchBuffer packed(SpriteBatchBufferInfo(2048, NO_RID), &atlas, &packedBackend);
+		runner.run("sprites.add_packed", "none", 0, 0, [&]() {
+			packed.begin();
+			for (int i = 0; i < num; ++i) {
+				const Sprite& sprite = sprites[i];
+				packed.add(sprite.position, rect, sprite.scaling, sprite.rotation, sprite.color);
+			}
+			packed.flush();
+		});
+		const SpriteBatchStats& packedStats = packedBackend.getCurrentFrame();
+		fprintf(stderr, "sprites.add_packed: %u sprites, %u flushes, %u bytes per frame\n", packedStats.sprites, packedStats.flushes, packedStats.bytes);
+	}
+	delete[] sprites;
+}
+
+#ifdef BENCH_WITH_GAME
+// ---------------------------------------------------------------
+// render the battleground into the recording backend. A few
+// towers and walkers are added first so every layer has sprites.
+// ---------------------------------------------------------------
+static void runRenderBenchmark(BenchRunner& runner, uint32_t seed) {
+	if (!runner.isEnabled("render.battleground")) {
+		return;
+	}
+	RecordingSpriteBatchBackend backend;
+	SpriteBatchBuffer buffer(SpriteBatchBufferInfo(2048, NO_RID), &backend);
+	ds::EventStream events;
+	Battleground battleground(&buffer);
+	battleground.prepare(&events);
+	battleground.reset(seed);
+	BenchRandom rnd(seed);
+	ds::ReplayCommand commands[16];
+	for (int i = 0; i < 16; ++i) {
+		ds::ReplayCommand& cmd = commands[i];
+		cmd.type = CommandType::PLACE_TOWER;
+		cmd.index = 0;
+		cmd.x = static_cast<int16_t>(rnd.next(0, GRID_SIZE_X - 1));
+		cmd.y = static_cast<int16_t>(rnd.next(0, GRID_SIZE_Y - 1));
+		cmd.value = 0.0f;
+	}
+	battleground.tick(1.0f / 60.0f, commands, 16);
+	ds::ReplayCommand start;
+	start.type = CommandType::START_WALKERS;
+	start.index = 0;
+	start.x = 64;
+	start.y = 0;
+	start.value = 0.05f;
+	battleground.tick(1.0f / 60.0f, &start, 1);
+	for (int i = 0; i < 240; ++i) {
+		events.reset();
+		battleground.tick(1.0f / 60.0f, 0, 0);
+	}
+	runner.run("render.battleground", "none", GRID_SIZE_X, GRID_SIZE_Y, [&]() {
+		buffer.begin();
+		battleground.render();
+		buffer.flush();
+	});
+	const SpriteBatchStats& stats = backend.getCurrentFrame();
+	fprintf(stderr, "render.battleground: %u sprites, %u flushes, %u bytes per frame\n", stats.sprites, stats.flushes, stats.bytes);
+}
+
+// ---------------------------------------------------------------
+// replay a recorded game without rendering
+// ---------------------------------------------------------------
+static bool runReplayBenchmark(BenchRunner& runner, const char* fileName) {
+	ds::ReplayLog log;
+	if (!log.load(fileName)) {
+		fprintf(stderr, "cannot load replay %s\n", fileName);
+		return false;
+	}
+	ds::EventStream events;
+	Battleground battleground(0);
+	battleground.prepare(&events);
+	ds::ReplayCommand commands[ds::MAX_REPLAY_COMMANDS];
+	int ticks = 0;
+	runner.run("replay", "replay", 0, 0, [&]() {
+		battleground.reset(log.getSeed());
+		log.rewind();
+	}, [&]() {
+		float dt = 0.0f;
+		int num = 0;
+		ticks = 0;
+		while (log.nextTick(&dt, commands, &num)) {
+			events.reset();
+			battleground.tick(dt, commands, num);
+			++ticks;
+		}
+	});
+	//
+	// the runner has played the log at least once, so every
+	// buffer is warmed up and a tick must not allocate anymore
+	//
+	battleground.reset(log.getSeed());
+	log.rewind();
+	uint64_t allocations = 0;
+	float dt = 0.0f;
+	int num = 0;
+	while (log.nextTick(&dt, commands, &num)) {
+		events.reset();
+		uint64_t before = ds::getNumAllocations();
+		battleground.tick(dt, commands, num);
+		allocations += ds::getNumAllocations() - before;
+	}
+	fprintf(stderr, "replay %s: %d ticks, seed %u, %llu allocations\n", fileName, ticks, log.getSeed(), static_cast<unsigned long long>(allocations));
+	if (allocations != 0) {
+		fprintf(stderr, "replay %s: warmed up ticks allocate\n", fileName);
+		return false;
+	}
+	return true;
+}
+#endif
+
+// ---------------------------------------------------------------
+// the terrain costs of the corpus for a flow field or an async one
+// ---------------------------------------------------------------
+template<class T>
+static void setTerrainCosts(T* field) {
+	field->setTileCost(TERRAIN_MUD, TERRAIN_MUD_COST);
+	field->setTileCost(TERRAIN_SWAMP, TERRAIN_SWAMP_COST);
+}
+
+// ---------------------------------------------------------------
+// block or open random cells. Only free cells and walls are
+// toggled so start, end and terrain stay in place.
+// ---------------------------------------------------------------
+static void toggleRandomCells(Grid* grid, BenchRandom& rnd, int num) {
+	int total = grid->width * grid->height;
+	for (int i = 0; i < num; ++i) {
+		int idx = rnd.next(0, total - 1);
+		if (grid->items[idx] == 0) {
+			grid->set(idx % grid->width, idx / grid->width, 1);
+		}
+		else if (grid->items[idx] == 1) {
+			grid->set(idx % grid->width, idx / grid->width, 0);
+		}
+	}
+}
+
+// ---------------------------------------------------------------
+// validation: bulk adds of more sprites than the buffer holds
+// must be split into full batches and every flush must move to
+// the next upload buffer
+// ---------------------------------------------------------------
+static bool validateSpriteSplit() {
+	const int max = 256;
+	const int numBuffers = 3;
+	const int counts[] = { 1, 255, 256, 257, 1000, 4096 };
+	RecordingSpriteBatchBackend backend;
+	SpriteBatchBufferInfo info(max, NO_RID);
+	info.numUploadBuffers = numBuffers;
+	SpriteBatchBuffer buffer(info, &backend);
+	Sprite* sprites = new Sprite[4096];
+	bool ok = true;
+	unsigned int flushes = 0;
+	for (int i = 0; i < 6; ++i) {
+		unsigned int n = counts[i];
+		buffer.begin();
+		buffer.add(sprites, n);
+		buffer.flush();
+		const SpriteBatchStats& stats = backend.getCurrentFrame();
+		unsigned int expected = (n + max - 1) / max;
+		if (stats.flushes != expected || stats.sprites != n || stats.bytes != n * sizeof(Sprite) || stats.largestBatch > max) {
+			fprintf(stderr, "sprites.split: %u sprites gave %u flushes, %u sprites, %u bytes - expected %u flushes, %u bytes\n",
+				n, stats.flushes, stats.sprites, stats.bytes, expected, static_cast<unsigned int>(n * sizeof(Sprite)));
+			ok = false;
+		}
+		flushes += expected;
+		if (backend.getCurrentUploadBuffer() != static_cast<int>(flushes % numBuffers)) {
+			fprintf(stderr, "sprites.split: upload buffer %d after %u flushes\n", backend.getCurrentUploadBuffer(), flushes);
+			ok = false;
+		}
+	}
+	for (int i = 0; i < numBuffers; ++i) {
+		unsigned int expected = flushes / numBuffers + (i < static_cast<int>(flushes % numBuffers) ? 1 : 0);
+		if (backend.getNumUploads(i) != expected) {
+			fprintf(stderr, "sprites.split: %u uploads into buffer %d - expected %u\n", backend.getNumUploads(i), i, expected);
+			ok = false;
+		}
+	}
+	delete[] sprites;
+	return ok;
+}
+
+// ---------------------------------------------------------------
+// validation: a warmed up tick of the core simulation must not
+// touch the heap. The flow fields are built on the job system
+// every tick.
+// ---------------------------------------------------------------
+static bool validateTickAllocations(uint32_t seed, ds::JobSystem* jobs) {
+	Grid grid(256, 256);
+	generateMap(&grid, MapType::ROOMS, seed);
+	p2i end = grid.getEnd();
+	FlowField flowField(&grid);
+	flowField.setMethod(FlowFieldMethod::PARALLEL_BFS, jobs);
+	FlowField eikonal(&grid);
+	eikonal.setMethod(FlowFieldMethod::EIKONAL, jobs);
+	flowField.build(end);
+	BenchRandom rnd(seed);
+	Walkers* walkers = new Walkers;
+	createWalkers(walkers, grid, flowField, rnd);
+	// the stream allocates its first blocks on the first event
+	ds::EventStream events;
+	WalkerEvent event;
+	events.add(EventType::WALKER_ESCAPED, &event, sizeof(WalkerEvent));
+	uint64_t before = 0;
+	for (int i = 0; i < WARM_UP_TICKS + CHECKED_TICKS; ++i) {
+		if (i == WARM_UP_TICKS) {
+			before = ds::getNumAllocations();
+		}
+		events.reset();
+		flowField.build(end);
+		eikonal.build(end);
+		moveWalkers(*walkers, &flowField, &events, 1.0f / 60.0f);
+	}
+	uint64_t allocations = ds::getNumAllocations() - before;
+	delete walkers;
+	if (allocations != 0) {
+		fprintf(stderr, "alloc.tick: %llu allocations in %d ticks\n", static_cast<unsigned long long>(allocations), CHECKED_TICKS);
+		return false;
+	}
+	return true;
+}
+
+// ---------------------------------------------------------------
+// validation: profiler rings are given back by exiting threads.
+// Many short threads one after another must all be recorded, more
+// threads than rings at the same time are counted as dropped and
+// after they have exited a new thread gets a ring again.
+// ---------------------------------------------------------------
+static bool validateProfilerThreads() {
+	bool ok = true;
+	int dropped = perf::getNumDroppedThreads();
+	for (int i = 0; i < perf::MAX_PROFILER_THREADS * 4; ++i) {
+		std::thread thread([]() {
+			perf::beginZone("validate");
+			perf::endZone();
+		});
+		thread.join();
+	}
+	if (perf::getNumDroppedThreads() != dropped) {
+		fprintf(stderr, "profiler: %d short threads dropped\n", perf::getNumDroppedThreads() - dropped);
+		ok = false;
+	}
+	const int numThreads = perf::MAX_PROFILER_THREADS + 4;
+	std::thread threads[numThreads];
+	std::atomic<int> numStarted(0);
+	std::atomic<bool> release(false);
+	for (int i = 0; i < numThreads; ++i) {
+		threads[i] = std::thread([&]() {
+			perf::beginZone("validate");
+			++numStarted;
+			while (!release.load()) {
+				std::this_thread::yield();
+			}
+			perf::endZone();
+		});
+	}
+	while (numStarted.load() < numThreads) {
+		std::this_thread::yield();
+	}
+	release.store(true);
+	for (int i = 0; i < numThreads; ++i) {
+		threads[i].join();
+	}
+	int concurrent = perf::getNumDroppedThreads() - dropped;
+	if (concurrent < 4) {
+		fprintf(stderr, "profiler: %d of %d concurrent threads dropped\n", concurrent, numThreads);
+		ok = false;
+	}
+	std::thread last([]() {
+		perf::beginZone("validate");
+		perf::endZone();
+	});
+	last.join();
+	if (perf::getNumDroppedThreads() - dropped != concurrent) {
+		fprintf(stderr, "profiler: no ring for a thread after the others exited\n");
+		ok = false;
+	}
+	return ok;
+}
+
+// ---------------------------------------------------------------
+// validation: one tween per easing function from 10 to 30. Every
+// tween must end at its end value (sinus returns to its start),
+// report exactly one event with its user data in the tick its
+// duration is reached and be inactive afterwards. A linear tween
+// is checked halfway and a stopped tween must not report.
+// ---------------------------------------------------------------
+static bool validateTweens() {
+	const int numEasings = ds::TweenEasing::NUM;
+	const float dt = 1.0f / 60.0f;
+	ds::TweenEngine engine(64, EventType::TWEEN_FINISHED);
+	ds::EventStream events;
+	float values[numEasings + 2];
+	float durations[numEasings + 2];
+	ID ids[numEasings + 2];
+	int reported[numEasings + 2];
+	for (int i = 0; i < numEasings; ++i) {
+		durations[i] = 0.5f + 0.05f * i;
+		ids[i] = engine.start(&values[i], 10.0f, 30.0f, durations[i], static_cast<ds::TweenEasing::Enum>(i), i);
+	}
+	int half = numEasings;
+	int stopped = numEasings + 1;
+	durations[half] = 1.0f;
+	ids[half] = engine.start(&values[half], 10.0f, 30.0f, durations[half], ds::TweenEasing::LINEAR, half);
+	durations[stopped] = 1.0f;
+	ids[stopped] = engine.start(&values[stopped], 10.0f, 30.0f, durations[stopped], ds::TweenEasing::LINEAR, stopped);
+	memset(reported, 0, sizeof(reported));
+	bool ok = true;
+	float elapsed = 0.0f;
+	for (int t = 1; t <= 120 && engine.num() > 0; ++t) {
+		events.reset();
+		engine.tick(dt, &events);
+		elapsed += dt;
+		if (t == 30 && fabs(values[half] - 20.0f) > 0.01f) {
+			fprintf(stderr, "tweens: linear is %g halfway instead of 20\n", values[half]);
+			ok = false;
+		}
+		if (t == 10) {
+			engine.stop(ids[stopped]);
+		}
+		uint32_t idx = events.firstOfType(EventType::TWEEN_FINISHED);
+		while (idx != ds::NO_EVENT) {
+			ds::TweenEvent event;
+			events.get(idx, &event);
+			idx = events.nextOfType(idx);
+			int i = event.userData;
+			if (i < 0 || i >= numEasings + 2 || event.id != ids[i]) {
+				fprintf(stderr, "tweens: unknown event %d\n", i);
+				ok = false;
+				continue;
+			}
+			++reported[i];
+			float expected = i == ds::TweenEasing::SINUS ? 10.0f : 30.0f;
+			if (fabs(values[i] - expected) > 0.001f) {
+				fprintf(stderr, "tweens: easing %d ends at %g instead of %g\n", i, values[i], expected);
+				ok = false;
+			}
+			if (elapsed < durations[i] || elapsed - dt >= durations[i]) {
+				fprintf(stderr, "tweens: easing %d reported at %g for duration %g\n", i, elapsed, durations[i]);
+				ok = false;
+			}
+			if (engine.isActive(event.id)) {
+				fprintf(stderr, "tweens: easing %d still active after its event\n", i);
+				ok = false;
+			}
+		}
+	}
+	for (int i = 0; i < numEasings + 2; ++i) {
+		int expected = i == stopped ? 0 : 1;
+		if (reported[i] != expected) {
+			fprintf(stderr, "tweens: tween %d reported %d times instead of %d\n", i, reported[i], expected);
+			ok = false;
+		}
+	}
+	if (engine.num() != 0) {
+		fprintf(stderr, "tweens: %d tweens left\n", engine.num());
+		ok = false;
+	}
+	return ok;
+}
+
+// ---------------------------------------------------------------
+// validation: a small simulation driven by a replay log. PLACE
+// commands put a wall on a free cell, SPAWN commands add a walker
+// and every tick moves the walkers on the flow field. Returns a
+// hash of the grid and the walkers.
+// ---------------------------------------------------------------
+const uint8_t REPLAY_PLACE = 0;
+const uint8_t REPLAY_SPAWN = 1;
+
+static uint32_t hashBytes(uint32_t hash, const void* data, int size) {
+	const uint8_t* bytes = static_cast<const uint8_t*>(data);
+	for (int i = 0; i < size; ++i) {
+		hash = (hash ^ bytes[i]) * 16777619u;
+	}
+	return hash;
+}
+
+static uint32_t playReplay(ds::ReplayLog& log, int* numTicks) {
+	const MapSize& size = MAP_SIZES[1];
+	Grid grid(size.width, size.height);
+	generateMap(&grid, MapType::ROOMS, log.getSeed());
+	p2i end = grid.getEnd();
+	FlowField flowField(&grid);
+	flowField.build(end);
+	Walkers* walkers = new Walkers;
+	ds::EventStream events;
+	ds::ReplayCommand commands[ds::MAX_REPLAY_COMMANDS];
+	float dt = 0.0f;
+	int num = 0;
+	*numTicks = 0;
+	log.rewind();
+	while (log.nextTick(&dt, commands, &num)) {
+		events.reset();
+		bool changed = false;
+		for (int i = 0; i < num; ++i) {
+			const ds::ReplayCommand& cmd = commands[i];
+			if (!grid.isValid(cmd.x, cmd.y)) {
+				continue;
+			}
+			if (cmd.type == REPLAY_PLACE && grid.get(cmd.x, cmd.y) == 0) {
+				grid.set(cmd.x, cmd.y, 1);
+				changed = true;
+			}
+			else if (cmd.type == REPLAY_SPAWN && flowField.getCost(cmd.x, cmd.y) != FLOW_FIELD_UNREACHABLE && walkers->numObjects < 4096) {
+				addWalker(walkers, cmd.x, cmd.y);
+			}
+		}
+		if (changed) {
+			flowField.build(end);
+		}
+		moveWalkers(*walkers, &flowField, &events, dt);
+		++*numTicks;
+	}
+	uint32_t hash = 2166136261u;
+	hash = hashBytes(hash, grid.items, size.width * size.height * sizeof(int));
+	hash = hashBytes(hash, &walkers->numObjects, sizeof(walkers->numObjects));
+	for (uint32_t i = 0; i < walkers->numObjects; ++i) {
+		const Walker& w = walkers->objects[i];
+		hash = hashBytes(hash, &w.pos, sizeof(w.pos));
+		hash = hashBytes(hash, &w.energy, sizeof(w.energy));
+	}
+	delete walkers;
+	return hash;
+}
+
+// ---------------------------------------------------------------
+// validation: a recorded log must replay to the same state every
+// time, also after a save and load. One tick records more than
+// MAX_REPLAY_COMMANDS commands, only that many are stored and the
+// ticks after it must still be read correctly.
+// ---------------------------------------------------------------
+static bool validateReplay(uint32_t seed) {
+	const int numTicks = 240;
+	const int overfullTick = 60;
+	const MapSize& size = MAP_SIZES[1];
+	ds::ReplayLog log;
+	log.start(seed);
+	BenchRandom rnd(seed);
+	ds::ReplayCommand* commands = new ds::ReplayCommand[ds::MAX_REPLAY_COMMANDS * 2];
+	for (int t = 0; t < numTicks; ++t) {
+		int num = t == overfullTick ? ds::MAX_REPLAY_COMMANDS * 2 : rnd.next(0, 3);
+		for (int i = 0; i < num; ++i) {
+			ds::ReplayCommand& cmd = commands[i];
+			cmd.type = rnd.next(0, 3) == 0 ? REPLAY_PLACE : REPLAY_SPAWN;
+			cmd.index = 0;
+			cmd.x = static_cast<int16_t>(rnd.next(0, size.width - 1));
+			cmd.y = static_cast<int16_t>(rnd.next(0, size.height - 1));
+			cmd.value = 0.0f;
+		}
+		log.recordTick(1.0f / 60.0f, commands, num);
+	}
+	delete[] commands;
+	bool ok = true;
+	int first = 0;
+	int second = 0;
+	uint32_t hash = playReplay(log, &first);
+	if (playReplay(log, &second) != hash || first != numTicks || second != numTicks) {
+		fprintf(stderr, "replay: two runs of %d ticks differ\n", numTicks);
+		ok = false;
+	}
+	if (!log.save("bench_replay.rpl")) {
+		fprintf(stderr, "replay: cannot save the log\n");
+		return false;
+	}
+	ds::ReplayLog loaded;
+	int third = 0;
+	if (!loaded.load("bench_replay.rpl") || playReplay(loaded, &third) != hash || third != numTicks) {
+		fprintf(stderr, "replay: the loaded log differs\n");
+		ok = false;
+	}
+	remove("bench_replay.rpl");
+	return ok;
+}
+
+// ---------------------------------------------------------------
+// validation: packSprite round trip. The fields are unpacked like
+// PackedSprites.hlsl does and must stay within the precision of
+// their format: positions are truncated to 1/16 and clamped to
+// [-2048, 2048), halfs keep 11 bits and flush values below 2^-14
+// to zero, colors keep 8 bits. The packed buffer must upload 16
+// bytes per sprite.
+// ---------------------------------------------------------------
+static bool checkPacked(const char* field, float v, float expected, float error) {
+	if (fabs(v - expected) > error) {
+		fprintf(stderr, "packed sprites: %s %g unpacks to %g\n", field, expected, v);
+		return false;
+	}
+	return true;
+}
+
+static bool validatePackedSprites(uint32_t seed) {
+	bool ok = sizeof(PackedSprite) == 16;
+	BenchRandom rnd(seed);
+	for (int i = 0; i < 4096; ++i) {
+		ds::vec2 pos(rnd.next(-2048000, 2047000) / 1000.0f, rnd.next(-2048000, 2047000) / 1000.0f);
+		uint16_t rect = static_cast<uint16_t>(rnd.next(0, MAX_ATLAS_RECTS - 1));
+		ds::vec2 scaling(rnd.next(1, 16000) / 1000.0f, rnd.next(-16000, -1) / 1000.0f);
+		float rotation = rnd.next(-6283, 6283) / 1000.0f;
+		ds::Color color(rnd.next(0, 255), rnd.next(0, 255), rnd.next(0, 255), rnd.next(0, 255));
+		PackedSprite p = packSprite(pos, rect, scaling, rotation, color);
+		ok &= checkPacked("x", p.x / 16.0f, pos.x, 1.0f / 16.0f);
+		ok &= checkPacked("y", p.y / 16.0f, pos.y, 1.0f / 16.0f);
+		ok &= checkPacked("rect", p.rect, rect, 0.0f);
+		ok &= checkPacked("scale x", unpackHalf(p.scaleX), scaling.x, fabs(scaling.x) / 2048.0f);
+		ok &= checkPacked("scale y", unpackHalf(p.scaleY), scaling.y, fabs(scaling.y) / 2048.0f);
+		ok &= checkPacked("rotation", unpackHalf(p.rotation), rotation, fabs(rotation) / 2048.0f);
+		for (int c = 0; c < 4; ++c) {
+			float channel = ((p.color >> (c * 8)) & 0xff) / 255.0f;
+			ok &= checkPacked("color", channel, color.data[c], 0.5f / 255.0f);
+		}
+	}
+	//
+	// the limits of the formats
+	//
+	PackedSprite p = packSprite(ds::vec2(5000.0f, -5000.0f), 0, ds::vec2(1e-5f, 70000.0f), -1e-6f, ds::Color(2.0f, -1.0f, 0.0f, 1.0f));
+	ok &= checkPacked("x", p.x / 16.0f, 2047.9375f, 0.0f);
+	ok &= checkPacked("y", p.y / 16.0f, -2048.0f, 0.0f);
+	ok &= checkPacked("scale x", unpackHalf(p.scaleX), 0.0f, 0.0f);
+	ok &= checkPacked("rotation", unpackHalf(p.rotation), 0.0f, 0.0f);
+	if (!isinf(unpackHalf(p.scaleY))) {
+		fprintf(stderr, "packed sprites: scale y 70000 unpacks to %g\n", unpackHalf(p.scaleY));
+		ok = false;
+	}
+	if (p.color != 0xff0000ffu) {
+		fprintf(stderr, "packed sprites: clamped color is %08x\n", p.color);
+		ok = false;
+	}
+	//
+	// the buffer uploads the packed sprites
+	//
+	SpriteAtlas atlas;
+	RecordingSpriteBatchBackend backend;
+	PackedSpriteBatchBuffer buffer(SpriteBatchBufferInfo(256, NO_RID), &atlas, &backend);
+	buffer.begin();
+	for (int i = 0; i < 1000; ++i) {
+		buffer.add(ds::vec2(i, i), ds::vec4(0, 0, 12, 12));
+	}
+	buffer.flush();
+	const SpriteBatchStats& stats = backend.getCurrentFrame();
+	if (stats.sprites != 1000 || stats.bytes != 1000 * sizeof(PackedSprite) || atlas.size() != 1) {
+		fprintf(stderr, "packed sprites: %u sprites and %u bytes uploaded, %d rects\n", stats.sprites, stats.bytes, atlas.size());
+		ok = false;
+	}
+	return ok;
+}
+
+// ---------------------------------------------------------------
+// validation: a grid sharing the cost table of a flow field must
+// treat weighted terrain as available, so APath finds a path
+// exactly when the field reaches the start
+// ---------------------------------------------------------------
+static bool validateTileCosts(uint32_t seed) {
+	bool ok = true;
+	const MapSize& size = MAP_SIZES[1];
+	int total = size.width * size.height;
+	p2i* points = new p2i[total];
+	for (int t = 0; t < MapType::NUM; ++t) {
+		MapType::Enum type = static_cast<MapType::Enum>(t);
+		Grid grid(size.width, size.height);
+		generateMap(&grid, type, seed);
+		FlowField flowField(&grid);
+		setTerrainCosts(&flowField);
+		flowField.setConnectivity(FlowFieldConnectivity::EIGHT_WAY, CornerCutting::ALLOWED);
+		grid.setTileCosts(flowField.getTileCosts());
+		int errors = 0;
+		for (int y = 0; y < size.height; ++y) {
+			for (int x = 0; x < size.width; ++x) {
+				if (grid.isAvailable(x, y) != flowField.isPassable(x, y)) {
+					++errors;
+				}
+			}
+		}
+		APath path(&grid);
+		BenchRandom rnd(seed);
+		for (int i = 0; i < 64; ++i) {
+			p2i start(rnd.next(0, size.width - 1), rnd.next(0, size.height - 1));
+			p2i end(rnd.next(0, size.width - 1), rnd.next(0, size.height - 1));
+			if (!grid.isAvailable(start) || !grid.isAvailable(end)) {
+				continue;
+			}
+			flowField.build(end);
+			bool reached = flowField.getCost(start.x, start.y) != FLOW_FIELD_UNREACHABLE;
+			if ((path.find(start, end, points, total) != 0) != reached) {
+				++errors;
+			}
+		}
+		if (errors != 0) {
+			fprintf(stderr, "tiles: %d mismatches on %s %dx%d\n", errors, getMapTypeName(type), size.width, size.height);
+			ok = false;
+		}
+	}
+	delete[] points;
+	return ok;
+}
+
+// ---------------------------------------------------------------
+// validation: the parallel BFS must give the same costs as the
+// Dijkstra integration, on the job system and on the calling
+// thread. The corpus maps are followed by an open map with the
+// end in the middle, its top-down frontiers span several chunks.
+// ---------------------------------------------------------------
+static bool compareParallelBFS(Grid* grid, const char* name, ds::JobSystem* jobs) {
+	p2i end = grid->getEnd();
+	FlowField dijkstra(grid);
+	dijkstra.build(end);
+	bool ok = true;
+	for (int j = 0; j < 2; ++j) {
+		FlowField bfs(grid);
+		bfs.setMethod(FlowFieldMethod::PARALLEL_BFS, j == 0 ? 0 : jobs);
+		bfs.build(end);
+		int errors = 0;
+		for (int y = 0; y < grid->height; ++y) {
+			for (int x = 0; x < grid->width; ++x) {
+				if (bfs.getCost(x, y) != dijkstra.getCost(x, y)) {
+					++errors;
+				}
+			}
+		}
+		if (errors != 0) {
+			fprintf(stderr, "bfs: %d wrong cells on %s %dx%d %s jobs\n", errors, name, grid->width, grid->height, j == 0 ? "without" : "with");
+			ok = false;
+		}
+	}
+	return ok;
+}
+
+static bool validateParallelBFS(uint32_t seed, ds::JobSystem* jobs) {
+	bool ok = true;
+	const MapSize& size = MAP_SIZES[2];
+	for (int t = 0; t < MapType::NUM; ++t) {
+		MapType::Enum type = static_cast<MapType::Enum>(t);
+		Grid grid(size.width, size.height);
+		generateMap(&grid, type, seed);
+		if (!compareParallelBFS(&grid, getMapTypeName(type), jobs)) {
+			ok = false;
+		}
+	}
+	Grid open(3072, 3072);
+	open.clear(0);
+	open.setEnd(1536, 1536);
+	if (!compareParallelBFS(&open, "centered", jobs)) {
+		ok = false;
+	}
+	return ok;
+}
+
+// ---------------------------------------------------------------
+// validation: the eikonal field must reach the same cells as the
+// eight way integration without corner cutting. Its costs must
+// stay between EIKONAL_MIN_RATIO and EIKONAL_MAX_RATIO percent of
+// the octile costs, give or take EIKONAL_SLACK. A diagonal step
+// from the end costs 17 instead of 14 and the sweeps interpolate
+// across terrain borders, which gives the bounds. The 1024x1024
+// maze hits the round limit.
+// ---------------------------------------------------------------
+static bool compareEikonal(Grid* grid, const char* name) {
+	p2i end = grid->getEnd();
+	FlowField octile(grid);
+	setTerrainCosts(&octile);
+	octile.setConnectivity(FlowFieldConnectivity::EIGHT_WAY, CornerCutting::NEVER);
+	octile.build(end);
+	FlowField eikonal(grid);
+	setTerrainCosts(&eikonal);
+	eikonal.setMethod(FlowFieldMethod::EIKONAL);
+	eikonal.build(end);
+	int unreached = 0;
+	int outside = 0;
+	for (int y = 0; y < grid->height; ++y) {
+		for (int x = 0; x < grid->width; ++x) {
+			int expected = octile.getCost(x, y);
+			int cost = eikonal.getCost(x, y);
+			if ((expected == FLOW_FIELD_UNREACHABLE) != (cost == FLOW_FIELD_UNREACHABLE)) {
+				++unreached;
+			}
+			else if (expected != FLOW_FIELD_UNREACHABLE) {
+				int64_t scaled = static_cast<int64_t>(cost) * 100;
+				int64_t slack = static_cast<int64_t>(EIKONAL_SLACK) * 100;
+				if (scaled < static_cast<int64_t>(expected) * EIKONAL_MIN_RATIO - slack || scaled > static_cast<int64_t>(expected) * EIKONAL_MAX_RATIO + slack) {
+					++outside;
+				}
+			}
+		}
+	}
+	if (unreached != 0 || outside != 0) {
+		fprintf(stderr, "eikonal: %d cells with a different reachability and %d out of bounds on %s %dx%d after %d rounds\n",
+			unreached, outside, name, grid->width, grid->height, eikonal.getNumRounds());
+		return false;
+	}
+	return true;
+}
+
+static bool validateEikonal(uint32_t seed) {
+	bool ok = true;
+	const MapSize& size = MAP_SIZES[2];
+	for (int t = 0; t < MapType::NUM; ++t) {
+		MapType::Enum type = static_cast<MapType::Enum>(t);
+		Grid grid(size.width, size.height);
+		generateMap(&grid, type, seed);
+		if (!compareEikonal(&grid, getMapTypeName(type))) {
+			ok = false;
+		}
+	}
+	const MapSize& large = MAP_SIZES[3];
+	Grid maze(large.width, large.height);
+	generateMap(&maze, MapType::MAZE, seed);
+	if (!compareEikonal(&maze, getMapTypeName(MapType::MAZE))) {
+		ok = false;
+	}
+	return ok;
+}
+
+// ---------------------------------------------------------------
+// validation: the blocking and lengthening cells of the analyzer
+// must match blocking a cell and rebuilding the flow field. A cell
+// can only matter if it is on a shortest path or a corner of one
+// of its steps, so every cell next to one tight path is checked
+// and all others must not be flagged. Runs on the small maps with
+// every connectivity.
+// ---------------------------------------------------------------
+static bool validateConnectivity(uint32_t seed) {
+	const FlowFieldConnectivity::Enum connectivities[] = { FlowFieldConnectivity::FOUR_WAY, FlowFieldConnectivity::EIGHT_WAY, FlowFieldConnectivity::EIGHT_WAY, FlowFieldConnectivity::EIGHT_WAY };
+	const CornerCutting::Enum rules[] = { CornerCutting::ALLOWED, CornerCutting::ALLOWED, CornerCutting::NO_SQUEEZE, CornerCutting::NEVER };
+	bool ok = true;
+	for (int s = 0; s < 2; ++s) {
+		const MapSize& size = MAP_SIZES[s];
+		int total = size.width * size.height;
+		uint8_t* near = new uint8_t[total];
+		for (int t = 0; t < MapType::NUM; ++t) {
+			MapType::Enum type = static_cast<MapType::Enum>(t);
+			Grid grid(size.width, size.height);
+			generateMap(&grid, type, seed);
+			p2i start = grid.getStart();
+			p2i end = grid.getEnd();
+			for (int c = 0; c < 4; ++c) {
+				FlowField flowField(&grid);
+				flowField.setTileCost(TERRAIN_MUD, TERRAIN_MUD_COST);
+				flowField.setTileCost(TERRAIN_SWAMP, TERRAIN_SWAMP_COST);
+				flowField.setConnectivity(connectivities[c], rules[c]);
+				flowField.build(end);
+				ConnectivityAnalyzer analyzer(&grid, &flowField);
+				analyzer.build(start, end);
+				int cost = flowField.getCost(start.x, start.y);
+				if (cost == FLOW_FIELD_UNREACHABLE) {
+					if (analyzer.isConnected()) {
+						fprintf(stderr, "connectivity: %s %dx%d is connected without a path\n", getMapTypeName(type), size.width, size.height);
+						ok = false;
+					}
+					continue;
+				}
+				//
+				// follow one tight path and mark the cells around it
+				//
+				memset(near, 0, total);
+				int neighbors[8];
+				int steps[8];
+				int current = start.x + start.y * size.width;
+				for (;;) {
+					int cx = current % size.width;
+					int cy = current / size.width;
+					for (int y = cy - 1; y <= cy + 1; ++y) {
+						for (int x = cx - 1; x <= cx + 1; ++x) {
+							if (grid.isValid(x, y)) {
+								near[x + y * size.width] = 1;
+							}
+						}
+					}
+					if (cx == end.x && cy == end.y) {
+						break;
+					}
+					int cnt = flowField.getNeighbors(cx, cy, neighbors, steps, 8);
+					int next = -1;
+					for (int i = 0; i < cnt && next == -1; ++i) {
+						int n = flowField.getCost(neighbors[i] % size.width, neighbors[i] / size.width);
+						if (n != FLOW_FIELD_UNREACHABLE && flowField.getCost(cx, cy) == n + steps[i] * flowField.getCellCost(cx, cy)) {
+							next = neighbors[i];
+						}
+					}
+					current = next;
+				}
+				int errors = 0;
+				for (int y = 0; y < size.height; ++y) {
+					for (int x = 0; x < size.width; ++x) {
+						if (!flowField.isPassable(x, y) || (x == start.x && y == start.y) || (x == end.x && y == end.y)) {
+							continue;
+						}
+						int blocked = cost;
+						if (near[x + y * size.width]) {
+							int tile = grid.get(x, y);
+							grid.set(x, y, 1);
+							flowField.build(end);
+							blocked = flowField.getCost(start.x, start.y);
+							grid.set(x, y, tile);
+						}
+						if (analyzer.isBlocking(x, y) != (blocked == FLOW_FIELD_UNREACHABLE) || analyzer.isLengthening(x, y) != (blocked != cost)) {
+							++errors;
+						}
+					}
+				}
+				if (errors != 0) {
+					fprintf(stderr, "connectivity: %d wrong cells on %s %dx%d with connectivity %d and corner cutting %d\n",
+						errors, getMapTypeName(type), size.width, size.height, connectivities[c], rules[c]);
+					ok = false;
+				}
+			}
+		}
+		delete[] near;
+	}
+	return ok;
+}
+
+// ---------------------------------------------------------------
+// validation: the async field must settle on the same costs and
+// directions as a synchronous build of the final grid. Cells are
+// toggled while builds are running, requests are coalesced and
+// published at random ticks. Every fourth round switches the
+// connectivity while a build is running.
+// ---------------------------------------------------------------
+static bool validateAsyncFlowField(uint32_t seed) {
+	const int numRounds = 16;
+	bool ok = true;
+	for (int t = 0; t < MapType::NUM; ++t) {
+		MapType::Enum type = static_cast<MapType::Enum>(t);
+		const MapSize& size = MAP_SIZES[2];
+		Grid grid(size.width, size.height);
+		generateMap(&grid, type, seed);
+		p2i end = grid.getEnd();
+		AsyncFlowField async(&grid);
+		setTerrainCosts(&async);
+		async.setConnectivity(FlowFieldConnectivity::EIGHT_WAY, CornerCutting::NEVER);
+		async.build(end);
+		FlowField flowField(&grid);
+		setTerrainCosts(&flowField);
+		flowField.setConnectivity(FlowFieldConnectivity::EIGHT_WAY, CornerCutting::NEVER);
+		BenchRandom rnd(seed);
+		for (int r = 0; r < numRounds; ++r) {
+			int numRequests = rnd.next(1, 8);
+			for (int i = 0; i < numRequests; ++i) {
+				toggleRandomCells(&grid, rnd, rnd.next(1, 16));
+				async.requestBuild(end);
+				if (rnd.next(0, 1) == 0) {
+					async.update();
+				}
+			}
+			if (r % 4 == 3) {
+				FlowFieldConnectivity::Enum connectivity = r % 8 == 3 ? FlowFieldConnectivity::FOUR_WAY : FlowFieldConnectivity::EIGHT_WAY;
+				async.setConnectivity(connectivity, CornerCutting::NEVER);
+				flowField.setConnectivity(connectivity, CornerCutting::NEVER);
+			}
+			while (async.isBusy()) {
+				async.wait();
+				async.update();
+			}
+			flowField.build(end);
+			const FlowField* front = async.get();
+			int errors = 0;
+			for (int y = 0; y < size.height; ++y) {
+				for (int x = 0; x < size.width; ++x) {
+					if (front->getCost(x, y) != flowField.getCost(x, y) || front->get(x, y) != flowField.get(x, y)) {
+						++errors;
+					}
+				}
+			}
+			if (errors != 0) {
+				fprintf(stderr, "async: %d wrong cells on %s %dx%d after round %d\n", errors, getMapTypeName(type), size.width, size.height, r);
+				ok = false;
+				break;
+			}
+		}
+	}
+	return ok;
+}
+
+// ---------------------------------------------------------------
+// validation: after random batches of blocked and opened cells the
+// incremental labels must give the same regions as a fresh flood
+// of the grid. Runs without a flow field and with a four and an
+// eight way one.
+// ---------------------------------------------------------------
+static bool validateRegionLabels(uint32_t seed) {
+	const int numRounds = 64;
+	const MapSize& size = MAP_SIZES[1];
+	int total = size.width * size.height;
+	int* flood = new int[total];
+	int* stack = new int[total];
+	int* toLabel = new int[total];
+	int* toFlood = new int[total * 2 + MAX_REGION_SEARCHES];
+	bool ok = true;
+	for (int t = 0; t < MapType::NUM; ++t) {
+		MapType::Enum type = static_cast<MapType::Enum>(t);
+		for (int m = 0; m < 3; ++m) {
+			Grid grid(size.width, size.height);
+			generateMap(&grid, type, seed);
+			FlowField flowField(&grid);
+			setTerrainCosts(&flowField);
+			flowField.setConnectivity(FlowFieldConnectivity::EIGHT_WAY, m == 1 ? CornerCutting::NEVER : CornerCutting::ALLOWED);
+			RegionLabels regions(&grid, m == 0 ? 0 : &flowField);
+			regions.update();
+			bool eightWay = m != 1;
+			BenchRandom rnd(seed);
+			for (int r = 0; r < numRounds && ok; ++r) {
+				toggleRandomCells(&grid, rnd, rnd.next(1, 32));
+				regions.update();
+				//
+				// flood the grid and map the regions both ways
+				//
+				int numFlood = 0;
+				for (int i = 0; i < total; ++i) {
+					flood[i] = -1;
+				}
+				for (int i = 0; i < total; ++i) {
+					bool passable = m == 0 ? grid.isAvailable(i % size.width, i / size.width) : flowField.isPassable(i % size.width, i / size.width);
+					if (!passable) {
+						flood[i] = -2;
+					}
+				}
+				for (int i = 0; i < total; ++i) {
+					if (flood[i] != -1) {
+						continue;
+					}
+					int sp = 0;
+					stack[sp++] = i;
+					flood[i] = numFlood;
+					while (sp > 0) {
+						int c = stack[--sp];
+						int cx = c % size.width;
+						int cy = c / size.width;
+						for (int dy = -1; dy < 2; ++dy) {
+							for (int dx = -1; dx < 2; ++dx) {
+								if ((dx != 0 && dy != 0 && !eightWay) || !grid.isValid(cx + dx, cy + dy)) {
+									continue;
+								}
+								int n = c + dx + dy * size.width;
+								if (flood[n] == -1) {
+									flood[n] = numFlood;
+									stack[sp++] = n;
+								}
+							}
+						}
+					}
+					toLabel[numFlood++] = -1;
+				}
+				for (int i = 0; i < total * 2 + MAX_REGION_SEARCHES; ++i) {
+					toFlood[i] = -1;
+				}
+				int errors = 0;
+				for (int i = 0; i < total; ++i) {
+					int label = regions.get(i % size.width, i / size.width);
+					if (flood[i] == -2 || label == -1) {
+						if (flood[i] != -2 || label != -1) {
+							++errors;
+						}
+						continue;
+					}
+					if (toLabel[flood[i]] == -1 && toFlood[label] == -1) {
+						toLabel[flood[i]] = label;
+						toFlood[label] = flood[i];
+					}
+					if (toLabel[flood[i]] != label || toFlood[label] != flood[i]) {
+						++errors;
+					}
+				}
+				if (errors != 0 || regions.num() != numFlood) {
+					fprintf(stderr, "regions: %d wrong cells and %d regions instead of %d on %s %dx%d mode %d after round %d\n",
+						errors, regions.num(), numFlood, getMapTypeName(type), size.width, size.height, m, r);
+					ok = false;
+				}
+			}
+		}
+	}
+	delete[] toFlood;
+	delete[] toLabel;
+	delete[] stack;
+	delete[] flood;
+	return ok;
+}
+
+// ---------------------------------------------------------------
+// octile cost of a path from the end back to the start or -1 if
+// it is not a walk over free cells between them
+// ---------------------------------------------------------------
+static int getPathCost(const Grid& grid, const p2i* points, int num, const p2i& start, const p2i& end) {
+	if (num == 0 || points[0].x != end.x || points[0].y != end.y || points[num - 1].x != start.x || points[num - 1].y != start.y) {
+		return -1;
+	}
+	int ret = 0;
+	for (int i = 0; i < num; ++i) {
+		if (!grid.isAvailable(points[i])) {
+			return -1;
+		}
+		if (i > 0) {
+			int dx = abs(points[i].x - points[i - 1].x);
+			int dy = abs(points[i].y - points[i - 1].y);
+			if (dx > 1 || dy > 1 || dx + dy == 0) {
+				return -1;
+			}
+			ret += (dx != 0 && dy != 0) ? 14 : 10;
+		}
+	}
+	return ret;
+}
+
+// ---------------------------------------------------------------
+// validation: RectPath must find paths of the same length as
+// APath. Random queries run on the corpus maps and again after
+// every batch of random blocked and opened cells.
+// ---------------------------------------------------------------
+static bool validateRectPath(uint32_t seed) {
+	const int numRounds = 16;
+	const int numQueries = 16;
+	bool ok = true;
+	for (int s = 1; s < 3; ++s) {
+		const MapSize& size = MAP_SIZES[s];
+		int total = size.width * size.height;
+		p2i* first = new p2i[total];
+		p2i* second = new p2i[total];
+		for (int t = 0; t < MapType::NUM; ++t) {
+			MapType::Enum type = static_cast<MapType::Enum>(t);
+			Grid grid(size.width, size.height);
+			generateMap(&grid, type, seed);
+			APath plain(&grid);
+			RectPath path(&grid);
+			path.rebuild();
+			BenchRandom rnd(seed);
+			int errors = 0;
+			for (int r = 0; r < numRounds; ++r) {
+				if (r > 0) {
+					toggleRandomCells(&grid, rnd, rnd.next(1, 32));
+					path.update();
+				}
+				for (int q = 0; q < numQueries; ++q) {
+					p2i start = q == 0 ? grid.getStart() : p2i(rnd.next(0, size.width - 1), rnd.next(0, size.height - 1));
+					p2i end = q == 0 ? grid.getEnd() : p2i(rnd.next(0, size.width - 1), rnd.next(0, size.height - 1));
+					int numFirst = plain.find(start, end, first, total);
+					int numSecond = path.find(start, end, second, total);
+					if (numFirst == 0 && numSecond == 0) {
+						continue;
+					}
+					int expected = getPathCost(grid, first, numFirst, start, end);
+					int cost = getPathCost(grid, second, numSecond, start, end);
+					if (expected == -1 || cost != expected) {
+						if (errors == 0) {
+							fprintf(stderr, "rectpath: cost %d instead of %d from %d %d to %d %d on %s %dx%d in round %d\n",
+								cost, expected, start.x, start.y, end.x, end.y, getMapTypeName(type), size.width, size.height, r);
+						}
+						++errors;
+					}
+				}
+			}
+			if (errors != 0) {
+				fprintf(stderr, "rectpath: %d wrong paths on %s %dx%d\n", errors, getMapTypeName(type), size.width, size.height);
+				ok = false;
+			}
+		}
+		delete[] second;
+		delete[] first;
+	}
+	return ok;
+}
+
+// ---------------------------------------------------------------
+// true if every cell the segment between the cell centers touches
+// is available. Coordinates are doubled so the centers are odd
+// integers, a cell is touched if its closed square is crossed by
+// the line, corners included.
+// ---------------------------------------------------------------
+static bool isSegmentClear(const Grid& grid, const p2i& from, const p2i& to) {
+	int ax = 2 * from.x + 1;
+	int ay = 2 * from.y + 1;
+	int dx = 2 * (to.x - from.x);
+	int dy = 2 * (to.y - from.y);
+	int minX = from.x < to.x ? from.x : to.x;
+	int maxX = from.x < to.x ? to.x : from.x;
+	int minY = from.y < to.y ? from.y : to.y;
+	int maxY = from.y < to.y ? to.y : from.y;
+	for (int y = minY; y <= maxY; ++y) {
+		for (int x = minX; x <= maxX; ++x) {
+			int below = 0;
+			int above = 0;
+			for (int c = 0; c < 4; ++c) {
+				int side = (2 * x + (c & 1) * 2 - ax) * dy - (2 * y + (c >> 1) * 2 - ay) * dx;
+				below += side <= 0;
+				above += side >= 0;
+			}
+			if (below > 0 && above > 0 && !grid.isAvailable(x, y)) {
+				return false;
+			}
+		}
+	}
+	return true;
+}
+
+// ---------------------------------------------------------------
+// validation: pullString on random APath paths over random grids.
+// The waypoints must be cells of the path in order, start and end
+// at the ends of the path and every pulled segment must be clear
+// by an independent supercover test. APath cuts corners so a
+// segment that is a single step of the path is not tested.
+// ---------------------------------------------------------------
+static bool validatePathSmoother(uint32_t seed) {
+	const int numGrids = 16;
+	const int numQueries = 16;
+	const int size = 64;
+	const int total = size * size;
+	bool ok = true;
+	p2i* points = new p2i[total];
+	p2i* waypoints = new p2i[total];
+	BenchRandom rnd(seed);
+	int errors = 0;
+	for (int g = 0; g < numGrids; ++g) {
+		Grid grid(size, size);
+		grid.clear(0);
+		int walls = rnd.next(10, 40);
+		for (int i = 0; i < total; ++i) {
+			if (rnd.next(0, 99) < walls) {
+				grid.items[i] = 1;
+			}
+		}
+		APath path(&grid);
+		for (int q = 0; q < numQueries; ++q) {
+			p2i start(rnd.next(0, size - 1), rnd.next(0, size - 1));
+			p2i end(rnd.next(0, size - 1), rnd.next(0, size - 1));
+			int num = path.find(start, end, points, total);
+			if (num == 0) {
+				continue;
+			}
+			int numWaypoints = pullString(&grid, 0, points, num, waypoints, total);
+			bool valid = numWaypoints > 0 && waypoints[0] == points[0] && waypoints[numWaypoints - 1] == points[num - 1];
+			int j = 0;
+			int prev = 0;
+			for (int w = 0; w < numWaypoints && valid; ++w) {
+				while (j < num && !(points[j] == waypoints[w])) {
+					++j;
+				}
+				valid = j < num;
+				if (valid && j > prev + 1) {
+					valid = isSegmentClear(grid, waypoints[w - 1], waypoints[w]);
+				}
+				prev = j;
+			}
+			if (!valid) {
+				if (errors == 0) {
+					fprintf(stderr, "smoother: %d waypoints from %d cells between %d %d and %d %d on grid %d\n", numWaypoints, num, start.x, start.y, end.x, end.y, g);
+				}
+				++errors;
+			}
+		}
+	}
+	if (errors != 0) {
+		fprintf(stderr, "smoother: %d wrong paths\n", errors);
+		ok = false;
+	}
+	delete[] waypoints;
+	delete[] points;
+	return ok;
+}
+
+// ---------------------------------------------------------------
+// validation: the PathCache must answer like a fresh APath after
+// every grid change. A fixed set of queries is repeated every
+// round so most answers come from the cache. Odd rounds block
+// cells on the cached paths which evicts them, even rounds toggle
+// random cells which also opens some and clears the cache.
+// ---------------------------------------------------------------
+static bool validatePathCache(uint32_t seed) {
+	const int numRounds = 16;
+	const int numQueries = 8;
+	bool ok = true;
+	for (int s = 1; s < 3; ++s) {
+		const MapSize& size = MAP_SIZES[s];
+		int total = size.width * size.height;
+		p2i* first = new p2i[total];
+		p2i* second = new p2i[total];
+		for (int t = 0; t < MapType::NUM; ++t) {
+			MapType::Enum type = static_cast<MapType::Enum>(t);
+			Grid grid(size.width, size.height);
+			generateMap(&grid, type, seed);
+			APath plain(&grid);
+			APath cached(&grid);
+			PathCache cache(&grid, &cached);
+			BenchRandom rnd(seed);
+			p2i starts[numQueries];
+			p2i ends[numQueries];
+			for (int q = 0; q < numQueries; ++q) {
+				starts[q] = q == 0 ? grid.getStart() : p2i(rnd.next(0, size.width - 1), rnd.next(0, size.height - 1));
+				ends[q] = q == 0 ? grid.getEnd() : p2i(rnd.next(0, size.width - 1), rnd.next(0, size.height - 1));
+			}
+			int errors = 0;
+			for (int r = 0; r < numRounds; ++r) {
+				if (r > 0 && r % 2 == 0) {
+					toggleRandomCells(&grid, rnd, rnd.next(1, 32));
+				}
+				for (int q = 0; q < numQueries; ++q) {
+					int numFirst = plain.find(starts[q], ends[q], first, total);
+					int numSecond = cache.find(starts[q], ends[q], second, total);
+					if (numFirst == 0 && numSecond == 0) {
+						continue;
+					}
+					int expected = getPathCost(grid, first, numFirst, starts[q], ends[q]);
+					int cost = getPathCost(grid, second, numSecond, starts[q], ends[q]);
+					if (expected == -1 || cost != expected) {
+						if (errors == 0) {
+							fprintf(stderr, "pathcache: cost %d instead of %d from %d %d to %d %d on %s %dx%d in round %d\n",
+								cost, expected, starts[q].x, starts[q].y, ends[q].x, ends[q].y, getMapTypeName(type), size.width, size.height, r);
+						}
+						++errors;
+					}
+					if (r % 2 == 1 && numFirst > 2) {
+						p2i p = first[rnd.next(1, numFirst - 2)];
+						if (grid.get(p) == 0) {
+							grid.set(p, 1);
+						}
+					}
+				}
+			}
+			if (cache.getNumHits() == 0 || cache.getNumEvicted() == 0) {
+				fprintf(stderr, "pathcache: %d hits and %d evictions on %s %dx%d\n", cache.getNumHits(), cache.getNumEvicted(), getMapTypeName(type), size.width, size.height);
+				ok = false;
+			}
+			if (errors != 0) {
+				fprintf(stderr, "pathcache: %d wrong paths on %s %dx%d\n", errors, getMapTypeName(type), size.width, size.height);
+				ok = false;
+			}
+		}
+		delete[] second;
+		delete[] first;
+	}
+	return ok;
+}
+
+// ---------------------------------------------------------------
+// validation: the ALT heuristic must stay admissible, APath with
+// landmarks has to find paths of the same cost as without. The
+// queries run on the corpus maps and again after every batch of
+// random cell toggles which refreshes the tables.
+// ---------------------------------------------------------------
+static bool validateLandmarks(uint32_t seed) {
+	const int numRounds = 8;
+	const int numQueries = 16;
+	bool ok = true;
+	for (int s = 1; s < 3; ++s) {
+		const MapSize& size = MAP_SIZES[s];
+		int total = size.width * size.height;
+		p2i* first = new p2i[total];
+		p2i* second = new p2i[total];
+		for (int t = 0; t < MapType::NUM; ++t) {
+			MapType::Enum type = static_cast<MapType::Enum>(t);
+			Grid grid(size.width, size.height);
+			generateMap(&grid, type, seed);
+			APath plain(&grid);
+			Landmarks landmarks(&grid);
+			APath path(&grid, &landmarks);
+			BenchRandom rnd(seed);
+			int errors = 0;
+			for (int r = 0; r < numRounds; ++r) {
+				if (r > 0) {
+					toggleRandomCells(&grid, rnd, rnd.next(1, 32));
+				}
+				for (int q = 0; q < numQueries; ++q) {
+					p2i start = q == 0 ? grid.getStart() : p2i(rnd.next(0, size.width - 1), rnd.next(0, size.height - 1));
+					p2i end = q == 0 ? grid.getEnd() : p2i(rnd.next(0, size.width - 1), rnd.next(0, size.height - 1));
+					int numFirst = plain.find(start, end, first, total);
+					int numSecond = path.find(start, end, second, total);
+					if (numFirst == 0 && numSecond == 0) {
+						continue;
+					}
+					int expected = getPathCost(grid, first, numFirst, start, end);
+					int cost = getPathCost(grid, second, numSecond, start, end);
+					if (expected == -1 || cost != expected) {
+						if (errors == 0) {
+							fprintf(stderr, "landmarks: cost %d instead of %d from %d %d to %d %d on %s %dx%d in round %d\n",
+								cost, expected, start.x, start.y, end.x, end.y, getMapTypeName(type), size.width, size.height, r);
+						}
+						++errors;
+					}
+				}
+			}
+			if (errors != 0) {
+				fprintf(stderr, "landmarks: %d wrong paths on %s %dx%d\n", errors, getMapTypeName(type), size.width, size.height);
+				ok = false;
+			}
+		}
+		delete[] second;
+		delete[] first;
+	}
+	return ok;
+}
+
+// ---------------------------------------------------------------
+// run all validation cases
+// ---------------------------------------------------------------
+static bool runValidation(uint32_t seed, ds::JobSystem* jobs) {
+	int failed = 0;
+	if (!validateSpriteSplit()) {
+		++failed;
+	}
+	if (!validatePackedSprites(seed)) {
+		++failed;
+	}
+	if (!validateTickAllocations(seed, jobs)) {
+		++failed;
+	}
+	if (!validateProfilerThreads()) {
+		++failed;
+	}
+	if (!validateTweens()) {
+		++failed;
+	}
+	if (!validateReplay(seed)) {
+		++failed;
+	}
+	if (!validateTileCosts(seed)) {
+		++failed;
+	}
+	if (!validateParallelBFS(seed, jobs)) {
+		++failed;
+	}
+	if (!validateEikonal(seed)) {
+		++failed;
+	}
+	if (!validateConnectivity(seed)) {
+		++failed;
+	}
+	if (!validateAsyncFlowField(seed)) {
+		++failed;
+	}
+	if (!validateRegionLabels(seed)) {
+		++failed;
+	}
+	if (!validatePathSmoother(seed)) {
+		++failed;
+	}
+	if (!validatePathCache(seed)) {
+		++failed;
+	}
+	if (!validateLandmarks(seed)) {
+		++failed;
+	}
+	if (!validateRectPath(seed)) {
+		++failed;
+	}
+	fprintf(stderr, "validation: %d failed\n", failed);
+	return failed == 0;
+}
+
+// ---------------------------------------------------------------
+// main
+// ---------------------------------------------------------------
+int main(int argc, char** argv) {
+	const char* outFile = 0;
+	const char* filter = 0;
+	int maxSize = 4096;
+	uint32_t seed = 12345;
+	bool validate = false;
+#ifdef BENCH_WITH_GAME
+	const char* replayFile = 0;
+#endif
+	for (int i = 1; i < argc; ++i) {
+		if (strcmp(argv[i], "--out") == 0 && i + 1 < argc) {
+			outFile = argv[++i];
+		}
+		else if (strcmp(argv[i], "--filter") == 0 && i + 1 < argc) {
+			filter = argv[++i];
+		}
+		else if (strcmp(argv[i], "--max-size") == 0 && i + 1 < argc) {
+			maxSize = atoi(argv[++i]);
+		}
+		else if (strcmp(argv[i], "--seed") == 0 && i + 1 < argc) {
+			seed = static_cast<uint32_t>(atoi(argv[++i]));
+		}
+		else if (strcmp(argv[i], "--validate") == 0) {
+			validate = true;
+		}
+#ifdef BENCH_WITH_GAME
+		else if (strcmp(argv[i], "--replay") == 0 && i + 1 < argc) {
+			replayFile = argv[++i];
+		}
+#endif
+		else {
+			fprintf(stderr, "usage: %s [--out file.json] [--filter name] [--max-size n] [--seed n] [--replay file] [--validate]\n", argv[0]);
+			return 1;
+		}
+	}
+	ds::JobSystem jobs;
+	if (validate) {
+		return runValidation(seed, &jobs) ? 0 : 1;
+	}
+	BenchRunner runner(filter, seed);
+#ifdef BENCH_WITH_GAME
+	if (replayFile != 0 && !runReplayBenchmark(runner, replayFile)) {
+		return 1;
+	}
+#endif
+	runDataArrayBenchmark(runner, seed);
+	runBulletBenchmark(runner, seed);
+	runCrowdBenchmark(runner, seed);
+	runCSVBenchmark(runner, seed);
+	runSpriteBenchmark(runner, seed);
+#ifdef BENCH_WITH_GAME
+	runRenderBenchmark(runner, seed);
+#endif
+	for (int s = 0; s < NUM_MAP_SIZES; ++s) {
+		const MapSize& size = MAP_SIZES[s];
+		if (size.width > maxSize || size.height > maxSize) {
+			continue;
+		}
+		for (int t = 0; t < MapType::NUM; ++t) {
+			runMapBenchmarks(runner, static_cast<MapType::Enum>(t), size, seed, &jobs);
+		}
+	}
+	if (outFile != 0) {
+		FILE* fp = fopen(outFile, "w");
+		if (fp == 0) {
+			fprintf(stderr, "cannot write %s\n", outFile);
+			return 1;
+		}
+		runner.writeJSON(fp);
+		fclose(fp);
+	}
+	else {
+		runner.writeJSON(stdout);
+	}
+	return 0;
+}
@@ -1,7 +1,35 @@
 #pragma once
-#include <diesel.h>
+#include <stdint.h>
+#include <string.h>
+#include <assert.h>
+#include <algorithm>
 //#define SPRITE_IMPLEMENTATION
 
+// ---------------------------------------------------------------
+// Define SPRITE_NO_DIESEL to build only the CPU side without
+// diesel and Direct3D 11. The diesel backends are not available
+// then and every buffer needs a backend like the
+// RecordingSpriteBatchBackend.
+// ---------------------------------------------------------------
+#ifndef SPRITE_NO_DIESEL
+#include <diesel.h>
+#else
+#include <ds_math.h>
+
+typedef uint32_t RID;
+
+const uint16_t NO_RID = UINT16_MAX - 1;
+
+namespace ds {
+
+	enum TextureFilters {
+		POINT,
+		LINEAR,
+		ANISOTROPIC
+	};
+}
+#endif
+
 struct SpriteBatchConstantBuffer {
 	ds::vec4 screenCenter;
 	ds::matrix wvp;
@@ -21,41 +49,309 @@ struct Sprite {
 	Sprite(const ds::vec2& p, const ds::vec4& r, const ds::vec2& s, float rot, const ds::Color& clr) : position(p), textureRect(r), scaling(s), rotation(rot), color(clr) {}
 };
 
+// ---------------------------------------------------------------
+// maximum number of upload buffers the backends rotate through
+// ---------------------------------------------------------------
+const int MAX_UPLOAD_BUFFERS = 4;
+
 struct SpriteBatchBufferInfo {
 
 	unsigned int maxSprites;
 	RID textureID;
 	ds::TextureFilters textureFilter;
 	RID blendState;
+	int numUploadBuffers;
+
+	SpriteBatchBufferInfo() : maxSprites(1024), textureID(NO_RID), textureFilter(ds::TextureFilters::LINEAR) , blendState(NO_RID), numUploadBuffers(3) {}
+	SpriteBatchBufferInfo(int max,RID tex) : maxSprites(max), textureID(tex), textureFilter(ds::TextureFilters::LINEAR), blendState(NO_RID), numUploadBuffers(3) {}
+	SpriteBatchBufferInfo(int max, RID tex, ds::TextureFilters filter) : maxSprites(max), textureID(tex), textureFilter(filter), blendState(NO_RID), numUploadBuffers(3) {}
+	SpriteBatchBufferInfo(int max, RID tex, ds::TextureFilters filter,RID blend) : maxSprites(max), textureID(tex), textureFilter(filter), blendState(blend), numUploadBuffers(3) {}
+};
+
+// ---------------------------------------------------------------
+// SpriteBatchStats
+// ---------------------------------------------------------------
+struct SpriteBatchStats {
+	unsigned int sprites;
+	unsigned int flushes;
+	unsigned int bytes;
+	unsigned int largestBatch;
+
+	SpriteBatchStats() : sprites(0), flushes(0), bytes(0), largestBatch(0) {}
+};
+
+// ---------------------------------------------------------------
+// SpriteBatchBackend
+//
+// Everything the sprite batch buffer needs from the renderer.
+// The default implementation uses diesel. A backend without any
+// GPU work makes it possible to run the CPU side headless.
+// ---------------------------------------------------------------
+class SpriteBatchBackend {
+
+public:
+	virtual ~SpriteBatchBackend() {}
+	virtual void initialize(const SpriteBatchBufferInfo& info, unsigned int elementSize) = 0;
+	virtual void beginFrame() {}
+	virtual void upload(void* data, unsigned int size) = 0;
+	virtual void draw(unsigned int numSprites) = 0;
+};
+
+#ifndef SPRITE_NO_DIESEL
+// ---------------------------------------------------------------
+// DieselSpriteBatchBackend
+// ---------------------------------------------------------------
+class DieselSpriteBatchBackend : public SpriteBatchBackend {
+
+public:
+	DieselSpriteBatchBackend() : _renderPass(NO_RID), _numUploadBuffers(0), _currentUploadBuffer(0) {}
+	virtual ~DieselSpriteBatchBackend() {}
+	void initialize(const SpriteBatchBufferInfo& info, unsigned int elementSize);
+	void upload(void* data, unsigned int size);
+	void draw(unsigned int numSprites);
+private:
+	RID _drawItems[MAX_UPLOAD_BUFFERS];
+	RID _structuredBufferIds[MAX_UPLOAD_BUFFERS];
+	RID _renderPass;
+	int _numUploadBuffers;
+	int _currentUploadBuffer;
+	SpriteBatchConstantBuffer _constantBuffer;
+};
+#endif
 
-	SpriteBatchBufferInfo() : maxSprites(1024), textureID(NO_RID), textureFilter(ds::TextureFilters::LINEAR) , blendState(NO_RID) {}
-	SpriteBatchBufferInfo(int max,RID tex) : maxSprites(max), textureID(tex), textureFilter(ds::TextureFilters::LINEAR), blendState(NO_RID) {}
-	SpriteBatchBufferInfo(int max, RID tex, ds::TextureFilters filter) : maxSprites(max), textureID(tex), textureFilter(filter), blendState(NO_RID) {}
-	SpriteBatchBufferInfo(int max, RID tex, ds::TextureFilters filter,RID blend) : maxSprites(max), textureID(tex), textureFilter(filter), blendState(blend) {}
+// ---------------------------------------------------------------
+// RecordingSpriteBatchBackend
+//
+// Does not render anything. It only counts the sprites, flushes
+// and uploaded bytes of the current and all previous frames and
+// rotates through the upload buffers like the diesel backend.
+// ---------------------------------------------------------------
+class RecordingSpriteBatchBackend : public SpriteBatchBackend {
+
+public:
+	RecordingSpriteBatchBackend() : _frames(0), _capacity(0), _numUploadBuffers(1), _currentUploadBuffer(0) {
+		for (int i = 0; i < MAX_UPLOAD_BUFFERS; ++i) {
+			_uploads[i] = 0;
+		}
+	}
+	virtual ~RecordingSpriteBatchBackend() {}
+	void initialize(const SpriteBatchBufferInfo& info, unsigned int elementSize) {
+		_capacity = info.maxSprites * elementSize;
+		_numUploadBuffers = info.numUploadBuffers;
+		if (_numUploadBuffers < 1) {
+			_numUploadBuffers = 1;
+		}
+		if (_numUploadBuffers > MAX_UPLOAD_BUFFERS) {
+			_numUploadBuffers = MAX_UPLOAD_BUFFERS;
+		}
+	}
+	void beginFrame() {
+		_last = _current;
+		_current = SpriteBatchStats();
+		++_frames;
+	}
+	void upload(void* data, unsigned int size) {
+		assert(size <= _capacity);
+		_current.bytes += size;
+		_total.bytes += size;
+		++_uploads[_currentUploadBuffer];
+	}
+	void draw(unsigned int numSprites) {
+		_current.sprites += numSprites;
+		++_current.flushes;
+		_total.sprites += numSprites;
+		++_total.flushes;
+		if (numSprites > _current.largestBatch) {
+			_current.largestBatch = numSprites;
+		}
+		if (numSprites > _total.largestBatch) {
+			_total.largestBatch = numSprites;
+		}
+		_currentUploadBuffer = (_currentUploadBuffer + 1) % _numUploadBuffers;
+	}
+	const SpriteBatchStats& getCurrentFrame() const {
+		return _current;
+	}
+	const SpriteBatchStats& getLastFrame() const {
+		return _last;
+	}
+	const SpriteBatchStats& getTotal() const {
+		return _total;
+	}
+	unsigned int getNumFrames() const {
+		return _frames;
+	}
+	int getNumUploadBuffers() const {
+		return _numUploadBuffers;
+	}
+	// upload buffer the next flush will use
+	int getCurrentUploadBuffer() const {
+		return _currentUploadBuffer;
+	}
+	// number of uploads into one buffer since the start
+	unsigned int getNumUploads(int buffer) const {
+		return _uploads[buffer];
+	}
+private:
+	SpriteBatchStats _current;
+	SpriteBatchStats _last;
+	SpriteBatchStats _total;
+	unsigned int _frames;
+	unsigned int _capacity;
+	int _numUploadBuffers;
+	int _currentUploadBuffer;
+	unsigned int _uploads[MAX_UPLOAD_BUFFERS];
 };
 
+// ---------------------------------------------------------------
+// SpriteBatchBuffer
+// ---------------------------------------------------------------
 class SpriteBatchBuffer {
 
 public:
-	SpriteBatchBuffer(const SpriteBatchBufferInfo& info);
+	SpriteBatchBuffer(const SpriteBatchBufferInfo& info, SpriteBatchBackend* backend = 0);
 	~SpriteBatchBuffer();
 	void begin();
 	void add(const ds::vec2& pos, const ds::vec4& textureRect, const ds::vec2& scaling = ds::vec2(1, 1), float rotation = 0.0f, const ds::Color& color = ds::Color(255, 255, 255, 255));
 	void add(const Sprite& sprite);
-	void add(Sprite* sprites, int count);
+	void add(const Sprite* sprites, int count);
 	void flush();
+	SpriteBatchBackend* getBackend() const {
+		return _backend;
+	}
+	// sprites drawn in the last completed frame
+	const SpriteBatchStats& getLastFrameStats() const {
+		return _lastFrame;
+	}
 private:
 	unsigned int _max;
 	unsigned int _current;
-	RID _drawItem;
-	RID _renderPass;
 	Sprite* _buffer;
-	RID _structuredBufferId;
-	SpriteBatchConstantBuffer _constantBuffer;
+	SpriteBatchBackend* _backend;
+	bool _ownsBackend;
+	SpriteBatchStats _currentFrame;
+	SpriteBatchStats _lastFrame;
+};
+
+// ---------------------------------------------------------------
+// SpriteAtlas
+//
+// Constant table of texture rects. Packed sprites only store the
+// index into this table. The table is uploaded as part of the
+// constant buffer so it is limited to MAX_ATLAS_RECTS entries.
+// ---------------------------------------------------------------
+const int MAX_ATLAS_RECTS = 256;
+
+class SpriteAtlas {
+
+public:
+	SpriteAtlas() : _num(0) {}
+	uint16_t add(const ds::vec4& rect);
+	int find(const ds::vec4& rect) const;
+	const ds::vec4& get(uint16_t index) const {
+		return _rects[index];
+	}
+	const ds::vec4* getRects() const {
+		return _rects;
+	}
+	int size() const {
+		return _num;
+	}
+private:
+	ds::vec4 _rects[MAX_ATLAS_RECTS];
+	int _num;
+};
+
+// ---------------------------------------------------------------
+// PackedSprite - 16 bytes per sprite
+//
+// position : signed 12.4 fixed point
+// rect     : index into the SpriteAtlas
+// scaling  : half float
+// rotation : half float
+// color    : RGBA8
+// ---------------------------------------------------------------
+struct PackedSprite {
+	int16_t x;
+	int16_t y;
+	uint16_t rect;
+	uint16_t scaleX;
+	uint16_t scaleY;
+	uint16_t rotation;
+	uint32_t color;
+};
+
+uint16_t packHalf(float v);
+
+float unpackHalf(uint16_t v);
+
+PackedSprite packSprite(const ds::vec2& pos, uint16_t rect, const ds::vec2& scaling, float rotation, const ds::Color& color);
+
+struct PackedSpriteBatchConstantBuffer {
+	ds::vec4 screenCenter;
+	ds::matrix wvp;
+	ds::vec4 rects[MAX_ATLAS_RECTS];
+};
+
+#ifndef SPRITE_NO_DIESEL
+// ---------------------------------------------------------------
+// DieselPackedSpriteBatchBackend
+//
+// Uses the vertex shader compiled from shaders/PackedSprites.hlsl
+// and keeps the rect table of the atlas in the constant buffer.
+// ---------------------------------------------------------------
+class DieselPackedSpriteBatchBackend : public SpriteBatchBackend {
+
+public:
+	DieselPackedSpriteBatchBackend(const SpriteAtlas* atlas) : _atlas(atlas), _numRects(0), _renderPass(NO_RID), _numUploadBuffers(0), _currentUploadBuffer(0) {}
+	virtual ~DieselPackedSpriteBatchBackend() {}
+	void initialize(const SpriteBatchBufferInfo& info, unsigned int elementSize);
+	void upload(void* data, unsigned int size);
+	void draw(unsigned int numSprites);
+private:
+	const SpriteAtlas* _atlas;
+	int _numRects;
+	RID _drawItems[MAX_UPLOAD_BUFFERS];
+	RID _structuredBufferIds[MAX_UPLOAD_BUFFERS];
+	RID _renderPass;
+	int _numUploadBuffers;
+	int _currentUploadBuffer;
+	PackedSpriteBatchConstantBuffer _constantBuffer;
+};
+#endif
+
+// ---------------------------------------------------------------
+// PackedSpriteBatchBuffer
+//
+// Same interface as the SpriteBatchBuffer but every sprite is
+// packed into 16 bytes before it is uploaded.
+// ---------------------------------------------------------------
+class PackedSpriteBatchBuffer {
+
+public:
+	PackedSpriteBatchBuffer(const SpriteBatchBufferInfo& info, SpriteAtlas* atlas, SpriteBatchBackend* backend = 0);
+	~PackedSpriteBatchBuffer();
+	void begin();
+	void add(const ds::vec2& pos, uint16_t rect, const ds::vec2& scaling = ds::vec2(1, 1), float rotation = 0.0f, const ds::Color& color = ds::Color(255, 255, 255, 255));
+	void add(const ds::vec2& pos, const ds::vec4& textureRect, const ds::vec2& scaling = ds::vec2(1, 1), float rotation = 0.0f, const ds::Color& color = ds::Color(255, 255, 255, 255));
+	void add(const PackedSprite& sprite);
+	void add(const PackedSprite* sprites, int count);
+	void flush();
+	SpriteBatchBackend* getBackend() const {
+		return _backend;
+	}
+private:
+	unsigned int _max;
+	unsigned int _current;
+	PackedSprite* _buffer;
+	SpriteAtlas* _atlas;
+	SpriteBatchBackend* _backend;
+	bool _ownsBackend;
 };
 
 #ifdef SPRITE_IMPLEMENTATION
 
+#ifndef SPRITE_NO_DIESEL
 const BYTE Sprites_VS_Main[] =
 {
 	68,  88,  66,  67, 176, 179,
@@ -345,9 +641,10 @@ const BYTE Sprites_PS_Main[] =
 };
 
 
-SpriteBatchBuffer::SpriteBatchBuffer(const SpriteBatchBufferInfo& info) : _max(info.maxSprites) , _current(0) {
-
-	_buffer = new Sprite[_max];
+// ---------------------------------------------------------------
+// DieselSpriteBatchBackend
+// ---------------------------------------------------------------
+void DieselSpriteBatchBackend::initialize(const SpriteBatchBufferInfo& info, unsigned int elementSize) {
 	ds::vec2 textureSize = ds::getTextureSize(info.textureID);
 	_constantBuffer.screenCenter = { static_cast<float>(ds::getScreenWidth()) / 2.0f, static_cast<float>(ds::getScreenHeight()) / 2.0f, textureSize.x, textureSize.y };
 
@@ -367,33 +664,44 @@ SpriteBatchBuffer::SpriteBatchBuffer(const SpriteBatchBufferInfo& info) : _max(i
 	RID ssid = ds::createSamplerState(samplerInfo);
 
 	int indices[] = { 0,1,2,1,3,2 };
-	RID idxBuffer = ds::createQuadIndexBuffer(_max, indices);
-
-	ds::StructuredBufferInfo sbInfo;
-	sbInfo.cpuWritable = true;
-	sbInfo.data = 0;
-	sbInfo.elementSize = sizeof(Sprite);
-	sbInfo.numElements = _max;
-	sbInfo.gpuWritable = false;
-	sbInfo.renderTarget = NO_RID;
-	sbInfo.textureID = NO_RID;
-	_structuredBufferId = ds::createStructuredBuffer(sbInfo);
-
-	RID basicGroup = ds::StateGroupBuilder()
-		.constantBuffer(constantBuffer, vertexShader)
-		.blendState(bs_id)
-		.structuredBuffer(_structuredBufferId, vertexShader, 1)
-		.vertexBuffer(NO_RID)
-		.vertexShader(vertexShader)
-		.indexBuffer(idxBuffer)
-		.pixelShader(pixelShader)
-		.samplerState(ssid, pixelShader)
-		.texture(info.textureID, pixelShader, 0)
-		.build();
+	RID idxBuffer = ds::createQuadIndexBuffer(info.maxSprites, indices);
 
 	ds::DrawCommand drawCmd = { 100, ds::DrawType::DT_INDEXED, ds::PrimitiveTypes::TRIANGLE_LIST };
 
-	_drawItem = ds::compile(drawCmd, basicGroup, "SpritesDrawItem");
+	// one structured buffer and draw item per upload buffer so that a flush
+	// never has to wait until the GPU is done with the previous one
+	_numUploadBuffers = info.numUploadBuffers;
+	if (_numUploadBuffers < 1) {
+		_numUploadBuffers = 1;
+	}
+	if (_numUploadBuffers > MAX_UPLOAD_BUFFERS) {
+		_numUploadBuffers = MAX_UPLOAD_BUFFERS;
+	}
+	for (int i = 0; i < _numUploadBuffers; ++i) {
+		ds::StructuredBufferInfo sbInfo;
+		sbInfo.cpuWritable = true;
+		sbInfo.data = 0;
+		sbInfo.elementSize = elementSize;
+		sbInfo.numElements = info.maxSprites;
+		sbInfo.gpuWritable = false;
+		sbInfo.renderTarget = NO_RID;
+		sbInfo.textureID = NO_RID;
+		_structuredBufferIds[i] = ds::createStructuredBuffer(sbInfo);
+
+		RID basicGroup = ds::StateGroupBuilder()
+			.constantBuffer(constantBuffer, vertexShader)
+			.blendState(bs_id)
+			.structuredBuffer(_structuredBufferIds[i], vertexShader, 1)
+			.vertexBuffer(NO_RID)
+			.vertexShader(vertexShader)
+			.indexBuffer(idxBuffer)
+			.pixelShader(pixelShader)
+			.samplerState(ssid, pixelShader)
+			.texture(info.textureID, pixelShader, 0)
+			.build();
+
+		_drawItems[i] = ds::compile(drawCmd, basicGroup, "SpritesDrawItem");
+	}
 
 	// create orthographic view
 	ds::matrix orthoView = ds::matIdentity();
@@ -417,12 +725,43 @@ SpriteBatchBuffer::SpriteBatchBuffer(const SpriteBatchBufferInfo& info) : _max(i
 	_constantBuffer.wvp = ds::matTranspose(camera.viewProjectionMatrix);
 }
 
+void DieselSpriteBatchBackend::upload(void* data, unsigned int size) {
+	ds::mapBufferData(_structuredBufferIds[_currentUploadBuffer], data, size);
+}
+
+void DieselSpriteBatchBackend::draw(unsigned int numSprites) {
+	ds::submit(_renderPass, _drawItems[_currentUploadBuffer], numSprites * 6);
+	_currentUploadBuffer = (_currentUploadBuffer + 1) % _numUploadBuffers;
+}
+#endif
+
+// ---------------------------------------------------------------
+// SpriteBatchBuffer
+// ---------------------------------------------------------------
+SpriteBatchBuffer::SpriteBatchBuffer(const SpriteBatchBufferInfo& info, SpriteBatchBackend* backend) : _max(info.maxSprites) , _current(0) , _backend(backend) , _ownsBackend(false) {
+	_buffer = new Sprite[_max];
+#ifndef SPRITE_NO_DIESEL
+	if (_backend == 0) {
+		_backend = new DieselSpriteBatchBackend;
+		_ownsBackend = true;
+	}
+#endif
+	assert(_backend != 0);
+	_backend->initialize(info, sizeof(Sprite));
+}
+
 SpriteBatchBuffer::~SpriteBatchBuffer() {
+	if (_ownsBackend) {
+		delete _backend;
+	}
 	delete[] _buffer;
 }
 
 void SpriteBatchBuffer::begin() {
 	_current = 0;
+	_lastFrame = _currentFrame;
+	_currentFrame = SpriteBatchStats();
+	_backend->beginFrame();
 }
 
 void SpriteBatchBuffer::add(const ds::vec2& position, const ds::vec4& rect, const ds::vec2& scale, float rotation, const ds::Color& clr) {
@@ -444,22 +783,303 @@ void SpriteBatchBuffer::add(const Sprite& sprite) {
 	_buffer[_current++] = sprite;
 }
 
-void SpriteBatchBuffer::add(Sprite* sprites, int count) {
-	if ((_current + count) >= _max) {
-		flush();
-	}
-	for (int i = 0; i < count; ++i) {
-		_buffer[_current++] = sprites[i];
+// ---------------------------------------------------------------
+// add any number of sprites. The sprites are copied in chunks
+// and the buffer is flushed whenever it is full.
+// ---------------------------------------------------------------
+void SpriteBatchBuffer::add(const Sprite* sprites, int count) {
+	while (count > 0) {
+		if (_current == _max) {
+			flush();
+		}
+		int num = _max - _current;
+		if (num > count) {
+			num = count;
+		}
+		std::copy(sprites, sprites + num, _buffer + _current);
+		_current += num;
+		sprites += num;
+		count -= num;
 	}
 }
 
 void SpriteBatchBuffer::flush() {
 	if (_current > 0) {
-		ds::mapBufferData(_structuredBufferId, _buffer, _current * sizeof(Sprite));
-		ds::submit(_renderPass, _drawItem, _current * 6);
+		_currentFrame.sprites += _current;
+		++_currentFrame.flushes;
+		_currentFrame.bytes += _current * sizeof(Sprite);
+		if (_current > _currentFrame.largestBatch) {
+			_currentFrame.largestBatch = _current;
+		}
+		_backend->upload(_buffer, _current * sizeof(Sprite));
+		_backend->draw(_current);
 		_current = 0;
 	}
 }
 
 
+// ---------------------------------------------------------------
+// SpriteAtlas
+// ---------------------------------------------------------------
+int SpriteAtlas::find(const ds::vec4& rect) const {
+	for (int i = 0; i < _num; ++i) {
+		const ds::vec4& r = _rects[i];
+		if (r.x == rect.x && r.y == rect.y && r.z == rect.z && r.w == rect.w) {
+			return i;
+		}
+	}
+	return -1;
+}
+
+uint16_t SpriteAtlas::add(const ds::vec4& rect) {
+	int idx = find(rect);
+	if (idx == -1) {
+		assert(_num < MAX_ATLAS_RECTS);
+		idx = _num++;
+		_rects[idx] = rect;
+	}
+	return static_cast<uint16_t>(idx);
+}
+
+// ---------------------------------------------------------------
+// float to half float (round to nearest, no NaN handling)
+// ---------------------------------------------------------------
+uint16_t packHalf(float v) {
+	uint32_t f;
+	memcpy(&f, &v, sizeof(float));
+	uint32_t sign = (f >> 16) & 0x8000;
+	int exponent = static_cast<int>((f >> 23) & 0xff) - 127 + 15;
+	uint32_t mantissa = f & 0x7fffff;
+	if (exponent <= 0) {
+		return static_cast<uint16_t>(sign);
+	}
+	if (exponent >= 31) {
+		return static_cast<uint16_t>(sign | 0x7c00);
+	}
+	uint32_t h = sign | (exponent << 10) | (mantissa >> 13);
+	// round to nearest, a carry into the exponent is still correct
+	h += (mantissa >> 12) & 1;
+	return static_cast<uint16_t>(h);
+}
+
+// ---------------------------------------------------------------
+// half float to float
+// ---------------------------------------------------------------
+float unpackHalf(uint16_t v) {
+	uint32_t sign = (v & 0x8000) << 16;
+	uint32_t exponent = (v >> 10) & 0x1f;
+	uint32_t mantissa = v & 0x3ff;
+	uint32_t f = sign;
+	if (exponent == 31) {
+		f |= 0x7f800000 | (mantissa << 13);
+	}
+	else if (exponent != 0) {
+		f |= ((exponent - 15 + 127) << 23) | (mantissa << 13);
+	}
+	float ret;
+	memcpy(&ret, &f, sizeof(float));
+	return ret;
+}
+
+static uint8_t packColorChannel(float v) {
+	if (v <= 0.0f) {
+		return 0;
+	}
+	if (v >= 1.0f) {
+		return 255;
+	}
+	return static_cast<uint8_t>(v * 255.0f + 0.5f);
+}
+
+static int16_t packFixed(float v) {
+	float f = v * 16.0f;
+	if (f < -32768.0f) {
+		f = -32768.0f;
+	}
+	if (f > 32767.0f) {
+		f = 32767.0f;
+	}
+	return static_cast<int16_t>(f);
+}
+
+PackedSprite packSprite(const ds::vec2& pos, uint16_t rect, const ds::vec2& scaling, float rotation, const ds::Color& color) {
+	PackedSprite ret;
+	ret.x = packFixed(pos.x);
+	ret.y = packFixed(pos.y);
+	ret.rect = rect;
+	ret.scaleX = packHalf(scaling.x);
+	ret.scaleY = packHalf(scaling.y);
+	ret.rotation = packHalf(rotation);
+	ret.color = packColorChannel(color.r) | (packColorChannel(color.g) << 8) | (packColorChannel(color.b) << 16) | (packColorChannel(color.a) << 24);
+	return ret;
+}
+
+#ifndef SPRITE_NO_DIESEL
+// ---------------------------------------------------------------
+// DieselPackedSpriteBatchBackend
+// ---------------------------------------------------------------
+void DieselPackedSpriteBatchBackend::initialize(const SpriteBatchBufferInfo& info, unsigned int elementSize) {
+	ds::vec2 textureSize = ds::getTextureSize(info.textureID);
+	_constantBuffer.screenCenter = { static_cast<float>(ds::getScreenWidth()) / 2.0f, static_cast<float>(ds::getScreenHeight()) / 2.0f, textureSize.x, textureSize.y };
+
+	ds::ShaderInfo vsInfo = { "PackedSprites.cso" , 0, 0, ds::ShaderType::ST_VERTEX_SHADER };
+	RID vertexShader = ds::createShader(vsInfo, "PackedSpritesVS");
+	ds::ShaderInfo psInfo = { 0 , Sprites_PS_Main, sizeof(Sprites_PS_Main), ds::ShaderType::ST_PIXEL_SHADER };
+	RID pixelShader = ds::createShader(psInfo, "PackedSpritesPS");
+
+	RID bs_id = info.blendState;
+	if (bs_id == NO_RID) {
+		ds::BlendStateInfo blendInfo = { ds::BlendStates::SRC_ALPHA, ds::BlendStates::SRC_ALPHA, ds::BlendStates::INV_SRC_ALPHA, ds::BlendStates::INV_SRC_ALPHA, true };
+		bs_id = ds::createBlendState(blendInfo);
+	}
+	RID constantBuffer = ds::createConstantBuffer(sizeof(PackedSpriteBatchConstantBuffer), &_constantBuffer);
+
+	ds::SamplerStateInfo samplerInfo = { ds::TextureAddressModes::CLAMP, info.textureFilter };
+	RID ssid = ds::createSamplerState(samplerInfo);
+
+	int indices[] = { 0,1,2,1,3,2 };
+	RID idxBuffer = ds::createQuadIndexBuffer(info.maxSprites, indices);
+
+	ds::DrawCommand drawCmd = { 100, ds::DrawType::DT_INDEXED, ds::PrimitiveTypes::TRIANGLE_LIST };
+
+	// one structured buffer and draw item per upload buffer so that a flush
+	// never has to wait until the GPU is done with the previous one
+	_numUploadBuffers = info.numUploadBuffers;
+	if (_numUploadBuffers < 1) {
+		_numUploadBuffers = 1;
+	}
+	if (_numUploadBuffers > MAX_UPLOAD_BUFFERS) {
+		_numUploadBuffers = MAX_UPLOAD_BUFFERS;
+	}
+	for (int i = 0; i < _numUploadBuffers; ++i) {
+		ds::StructuredBufferInfo sbInfo;
+		sbInfo.cpuWritable = true;
+		sbInfo.data = 0;
+		sbInfo.elementSize = elementSize;
+		sbInfo.numElements = info.maxSprites;
+		sbInfo.gpuWritable = false;
+		sbInfo.renderTarget = NO_RID;
+		sbInfo.textureID = NO_RID;
+		_structuredBufferIds[i] = ds::createStructuredBuffer(sbInfo);
+
+		RID basicGroup = ds::StateGroupBuilder()
+			.constantBuffer(constantBuffer, vertexShader)
+			.blendState(bs_id)
+			.structuredBuffer(_structuredBufferIds[i], vertexShader, 1)
+			.vertexBuffer(NO_RID)
+			.vertexShader(vertexShader)
+			.indexBuffer(idxBuffer)
+			.pixelShader(pixelShader)
+			.samplerState(ssid, pixelShader)
+			.texture(info.textureID, pixelShader, 0)
+			.build();
+
+		_drawItems[i] = ds::compile(drawCmd, basicGroup, "PackedSpritesDrawItem");
+	}
+
+	ds::matrix orthoView = ds::matIdentity();
+	ds::matrix orthoProjection = ds::matOrthoLH(ds::getScreenWidth(), ds::getScreenHeight(), 0.0f, 1.0f);
+	ds::Camera camera = {
+		orthoView,
+		orthoProjection,
+		orthoView * orthoProjection,
+		ds::vec3(0,0,0),
+		ds::vec3(0,0,1),
+		ds::vec3(0,1,0),
+		ds::vec3(1,0,0),
+		0.0f,
+		0.0f,
+		0.0f
+	};
+	ds::ViewportInfo vpInfo = { ds::getScreenWidth(), ds::getScreenHeight(), 0.0f, 1.0f };
+	RID vp = ds::createViewport(vpInfo, "PackedSpriteOrthoViewport");
+	ds::RenderPassInfo rpInfo = { &camera, vp, ds::DepthBufferState::DISABLED, 0, 0 };
+	_renderPass = ds::createRenderPass(rpInfo, "PackedSpritesOrthoPass");
+	_constantBuffer.wvp = ds::matTranspose(camera.viewProjectionMatrix);
+}
+
+void DieselPackedSpriteBatchBackend::upload(void* data, unsigned int size) {
+	// new rects might have been added to the atlas since the last upload
+	if (_numRects != _atlas->size()) {
+		_numRects = _atlas->size();
+		memcpy(_constantBuffer.rects, _atlas->getRects(), _numRects * sizeof(ds::vec4));
+	}
+	ds::mapBufferData(_structuredBufferIds[_currentUploadBuffer], data, size);
+}
+
+void DieselPackedSpriteBatchBackend::draw(unsigned int numSprites) {
+	ds::submit(_renderPass, _drawItems[_currentUploadBuffer], numSprites * 6);
+	_currentUploadBuffer = (_currentUploadBuffer + 1) % _numUploadBuffers;
+}
+#endif
+
+// ---------------------------------------------------------------
+// PackedSpriteBatchBuffer
+// ---------------------------------------------------------------
+PackedSpriteBatchBuffer::PackedSpriteBatchBuffer(const SpriteBatchBufferInfo& info, SpriteAtlas* atlas, SpriteBatchBackend* backend) : _max(info.maxSprites), _current(0), _atlas(atlas), _backend(backend), _ownsBackend(false) {
+	_buffer = new PackedSprite[_max];
+#ifndef SPRITE_NO_DIESEL
+	if (_backend == 0) {
+		_backend = new DieselPackedSpriteBatchBackend(_atlas);
+		_ownsBackend = true;
+	}
+#endif
+	assert(_backend != 0);
+	_backend->initialize(info, sizeof(PackedSprite));
+}
+
+PackedSpriteBatchBuffer::~PackedSpriteBatchBuffer() {
+	if (_ownsBackend) {
+		delete _backend;
+	}
+	delete[] _buffer;
+}
+
+void PackedSpriteBatchBuffer::begin() {
+	_current = 0;
+	_backend->beginFrame();
+}
+
+void PackedSpriteBatchBuffer::add(const ds::vec2& pos, uint16_t rect, const ds::vec2& scaling, float rotation, const ds::Color& color) {
+	if ((_current + 1) >= _max) {
+		flush();
+	}
+	_buffer[_current++] = packSprite(pos, rect, scaling, rotation, color);
+}
+
+void PackedSpriteBatchBuffer::add(const ds::vec2& pos, const ds::vec4& textureRect, const ds::vec2& scaling, float rotation, const ds::Color& color) {
+	add(pos, _atlas->add(textureRect), scaling, rotation, color);
+}
+
+void PackedSpriteBatchBuffer::add(const PackedSprite& sprite) {
+	if ((_current + 1) >= _max) {
+		flush();
+	}
+	_buffer[_current++] = sprite;
+}
+
+void PackedSpriteBatchBuffer::add(const PackedSprite* sprites, int count) {
+	while (count > 0) {
+		if (_current == _max) {
+			flush();
+		}
+		int num = _max - _current;
+		if (num > count) {
+			num = count;
+		}
+		memcpy(_buffer + _current, sprites, num * sizeof(PackedSprite));
+		_current += num;
+		sprites += num;
+		count -= num;
+	}
+}
+
+void PackedSpriteBatchBuffer::flush() {
+	if (_current > 0) {
+		_backend->upload(_buffer, _current * sizeof(PackedSprite));
+		_backend->draw(_current);
+		_current = 0;
+	}
+}
+
 #endif
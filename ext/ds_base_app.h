@@ -1,8 +1,12 @@
 #pragma once
 #include <diesel.h>
+#include <ds_event_stream.h>
 #include <Windows.h>
 #include <vector>
 #include <stdint.h>
+#include <assert.h>
+#include <atomic>
+#include <ds_profiler.h>
 
 //#define BASE_APP_IMPLEMENTATION
 
@@ -23,37 +27,6 @@ namespace ds {
 		char guiToggleKey;
 	};
 
-	// ----------------------------------------------------
-	// event stream
-	// ----------------------------------------------------
-	class EventStream {
-
-		struct EventHeader {
-			uint32_t id;
-			uint32_t type;
-			size_t size;
-		};
-
-	public:
-		EventStream();
-		virtual ~EventStream();
-		void reset();
-		void add(uint32_t type);
-		void add(uint32_t type, void* p, size_t size);
-		const bool get(uint32_t index, void* p) const;
-		const int getType(uint32_t index) const;
-		const bool containsType(uint32_t type) const;
-		const uint32_t num() const {
-			return _mappings.size();
-		}
-	private:
-		void addHeader(uint32_t type, size_t size);
-		EventStream(const EventStream& orig) {}
-		char* _data;
-		std::vector<uint32_t> _mappings;
-		uint32_t _index;
-	};
-
 	// ----------------------------------------------------
 	// Scene
 	// ----------------------------------------------------
@@ -221,8 +194,6 @@ extern ds::BaseApp* app;
 
 namespace ds {
 
-	const int EVENT_HEADER_SIZE = 12;
-
 	void debug(const LogLevel& level, const char* message) {
 #ifdef DEBUG
 		OutputDebugString(message);
@@ -338,6 +309,7 @@ namespace ds {
 	// -------------------------------------------------------
 	void BaseApp::init() {
 		SetThreadAffinityMask(GetCurrentThread(), 1);
+		perf::init();
 		//
 		// prepare application
 		//
@@ -405,6 +377,7 @@ namespace ds {
 	// tick
 	// -------------------------------------------------------
 	void BaseApp::tick(float dt) {
+		PERF_ZONE("BaseApp::tick");
 
 		if (_useTweakables) {
 #ifdef DEBUG
@@ -426,7 +399,10 @@ namespace ds {
 			_guiKeyPressed = false;
 		}
 
-		handleButtons();
+		{
+			PERF_ZONE("handleButtons");
+			handleButtons();
+		}
 
 		for (int i = 0; i < 2; ++i) {
 			if (_buttonStates[i].clicked) {
@@ -443,24 +419,37 @@ namespace ds {
 
 		_events->reset();
 
-		update(dt);
+		{
+			PERF_ZONE("BaseApp::update");
+			update(dt);
+		}
 
-		render();
+		{
+			PERF_ZONE("BaseApp::render");
+			render();
+		}
 
 		ScenesIterator it = _scenes.begin();
-		while (it != _scenes.end()) {
-			(*it)->update(dt);
-			++it;
+		{
+			PERF_ZONE("Scene::update");
+			while (it != _scenes.end()) {
+				(*it)->update(dt);
+				++it;
+			}
 		}
-		it = _scenes.begin();
-		while (it != _scenes.end()) {
-			(*it)->beforeRendering();
-			(*it)->render();
-			(*it)->afterRendering();
-			++it;
+		{
+			PERF_ZONE("Scene::render");
+			it = _scenes.begin();
+			while (it != _scenes.end()) {
+				(*it)->beforeRendering();
+				(*it)->render();
+				(*it)->afterRendering();
+				++it;
+			}
 		}
 
 		if (_settings.useIMGUI && _guiActive) {
+			PERF_ZONE("Scene::showGUI");
 			it = _scenes.begin();
 			while (it != _scenes.end()) {
 				(*it)->showGUI();
@@ -468,7 +457,10 @@ namespace ds {
 			}
 		}
 		
-		handleEvents(_events);
+		{
+			PERF_ZONE("handleEvents");
+			handleEvents(_events);
+		}
 	}
 
 	RID Scene::loadImageFromFile(const char* name) {
@@ -488,97 +480,6 @@ namespace ds {
 		_buffer->flush();
 	}
 
-	// -------------------------------------------------------
-	// EventStream
-	// -------------------------------------------------------
-	EventStream::EventStream() {
-		_data = new char[4096];
-		reset();
-	}
-
-	EventStream::~EventStream() {
-		delete[] _data;
-	}
-
-	// -------------------------------------------------------
-	// reset
-	// -------------------------------------------------------
-	void EventStream::reset() {
-		_mappings.clear();
-		_index = 0;
-	}
-
-	// -------------------------------------------------------
-	// add event
-	// -------------------------------------------------------
-	void EventStream::add(uint32_t type, void* p, size_t size) {
-		addHeader(type, size);
-		char* data = _data + _index + EVENT_HEADER_SIZE;
-		memcpy(data, p, size);
-		_mappings.push_back(_index);
-		_index += EVENT_HEADER_SIZE + size;
-	}
-
-	// -------------------------------------------------------
-	// add event
-	// -------------------------------------------------------
-	void EventStream::add(uint32_t type) {
-		addHeader(type, 0);
-		char* data = _data + _index;
-		_mappings.push_back(_index);
-		_index += EVENT_HEADER_SIZE;
-	}
-
-	// -------------------------------------------------------
-	// add header
-	// -------------------------------------------------------
-	void EventStream::addHeader(uint32_t type, size_t size) {
-		//LOG << "creating event - type: " << type << " size: " << size;
-		EventHeader header;
-		header.id = _mappings.size();;
-		header.size = size;
-		header.type = type;
-		char* data = _data + _index;
-		memcpy(data, &header, EVENT_HEADER_SIZE);
-	}
-
-	// -------------------------------------------------------
-	// get
-	// -------------------------------------------------------
-	const bool EventStream::get(uint32_t index, void* p) const {
-		//XASSERT(index < _mappings.size(), "Index out of range");
-		int lookup = _mappings[index];
-		char* data = _data + lookup;
-		EventHeader* header = (EventHeader*)data;
-		data += EVENT_HEADER_SIZE;
-		memcpy(p, data, header->size);
-		return true;
-	}
-
-	// -------------------------------------------------------
-	// get type
-	// -------------------------------------------------------
-	const int EventStream::getType(uint32_t index) const {
-		//XASSERT(index < _mappings.size(), "Index out of range");
-		int lookup = _mappings[index];
-		char* data = _data + lookup;
-		EventHeader* header = (EventHeader*)data;
-		return header->type;
-	}
-
-	// -------------------------------------------------------
-	// contains type
-	// -------------------------------------------------------
-	const bool EventStream::containsType(uint32_t type) const {
-		for (int i = 0; i < _mappings.size(); ++i) {
-			if (getType(i) == type) {
-				return true;
-			}
-		}
-		return false;
-	}
-
-
 }
 
 #endif
@@ -0,0 +1,278 @@
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+#include <atomic>
+
+//#define DS_EVENT_STREAM_IMPLEMENTATION
+// BASE_APP_IMPLEMENTATION includes the implementation as well
+
+namespace ds {
+
+	// ----------------------------------------------------
+	// event stream
+	//
+	// Events can be added from several threads at the same
+	// time without locks. Reading is only allowed once all
+	// producers are done (e.g. after the jobs of a frame
+	// have been joined). Headers and payload live in blocks
+	// that double in size and are kept across resets. Every
+	// type below MAX_EVENT_CHANNELS has its own channel and
+	// the stream keeps a bitmask of the types added since
+	// the last reset.
+	// ----------------------------------------------------
+	const int MAX_EVENT_CHANNELS = 64;
+	const int MAX_EVENT_BLOCKS = 20;
+	const uint32_t NO_EVENT = UINT32_MAX;
+
+	class EventStream {
+
+		struct EventHeader {
+			uint32_t type;
+			uint32_t size;
+			uint32_t offset;
+			uint32_t next;
+		};
+
+	public:
+		EventStream();
+		virtual ~EventStream();
+		void reset();
+		void add(uint32_t type);
+		void add(uint32_t type, void* p, size_t size);
+		const bool get(uint32_t index, void* p) const;
+		const int getType(uint32_t index) const;
+		const bool containsType(uint32_t type) const;
+		const uint32_t num() const {
+			return _numEvents.load();
+		}
+		const uint32_t numType(uint32_t type) const;
+		const uint32_t firstOfType(uint32_t type) const;
+		const uint32_t nextOfType(uint32_t index) const;
+	private:
+		EventHeader* getHeader(uint32_t index) const;
+		char* getData(uint32_t offset) const;
+		uint32_t reserveData(uint32_t size);
+		EventStream(const EventStream& orig) {}
+		mutable std::atomic<EventHeader*> _headers[MAX_EVENT_BLOCKS];
+		mutable std::atomic<char*> _data[MAX_EVENT_BLOCKS];
+		std::atomic<uint32_t> _numEvents;
+		std::atomic<uint32_t> _dataIndex;
+		std::atomic<uint64_t> _presence;
+		std::atomic<uint32_t> _channels[MAX_EVENT_CHANNELS];
+		std::atomic<uint32_t> _channelSizes[MAX_EVENT_CHANNELS];
+	};
+
+}
+
+#if defined(DS_EVENT_STREAM_IMPLEMENTATION) || defined(BASE_APP_IMPLEMENTATION)
+#include <string.h>
+#include <assert.h>
+
+namespace ds {
+
+	// -------------------------------------------------------
+	// EventStream
+	// -------------------------------------------------------
+	const uint32_t EVENT_HEADER_BLOCK_SIZE = 256;
+	const uint32_t EVENT_DATA_BLOCK_SIZE = 4096;
+
+	// -------------------------------------------------------
+	// block k holds base << k elements and starts at
+	// base * (2^k - 1)
+	// -------------------------------------------------------
+	static int findEventBlock(uint32_t pos, uint32_t base, uint32_t* offset) {
+		uint32_t v = pos / base + 1;
+		int block = 0;
+		while (v > 1) {
+			v >>= 1;
+			++block;
+		}
+		*offset = pos - base * ((1u << block) - 1);
+		return block;
+	}
+
+	// -------------------------------------------------------
+	// get block and allocate it unless another thread was
+	// faster
+	// -------------------------------------------------------
+	template<class T>
+	static T* getEventBlock(std::atomic<T*>* blocks, int block, uint32_t base) {
+		assert(block < MAX_EVENT_BLOCKS);
+		T* current = blocks[block].load();
+		if (current == 0) {
+			T* created = new T[base << block];
+			if (blocks[block].compare_exchange_strong(current, created)) {
+				current = created;
+			}
+			else {
+				delete[] created;
+			}
+		}
+		return current;
+	}
+
+	EventStream::EventStream() {
+		for (int i = 0; i < MAX_EVENT_BLOCKS; ++i) {
+			_headers[i] = 0;
+			_data[i] = 0;
+		}
+		reset();
+	}
+
+	EventStream::~EventStream() {
+		for (int i = 0; i < MAX_EVENT_BLOCKS; ++i) {
+			delete[] _headers[i].load();
+			delete[] _data[i].load();
+		}
+	}
+
+	// -------------------------------------------------------
+	// reset - the blocks are kept
+	// -------------------------------------------------------
+	void EventStream::reset() {
+		_numEvents = 0;
+		_dataIndex = 0;
+		_presence = 0;
+		for (int i = 0; i < MAX_EVENT_CHANNELS; ++i) {
+			_channels[i] = NO_EVENT;
+			_channelSizes[i] = 0;
+		}
+	}
+
+	// -------------------------------------------------------
+	// get header
+	// -------------------------------------------------------
+	EventStream::EventHeader* EventStream::getHeader(uint32_t index) const {
+		uint32_t offset = 0;
+		int block = findEventBlock(index, EVENT_HEADER_BLOCK_SIZE, &offset);
+		return getEventBlock(_headers, block, EVENT_HEADER_BLOCK_SIZE) + offset;
+	}
+
+	// -------------------------------------------------------
+	// get data
+	// -------------------------------------------------------
+	char* EventStream::getData(uint32_t offset) const {
+		uint32_t local = 0;
+		int block = findEventBlock(offset, EVENT_DATA_BLOCK_SIZE, &local);
+		return getEventBlock(_data, block, EVENT_DATA_BLOCK_SIZE) + local;
+	}
+
+	// -------------------------------------------------------
+	// reserve data. The payload of an event must not cross
+	// a block boundary, so such a range is skipped.
+	// -------------------------------------------------------
+	uint32_t EventStream::reserveData(uint32_t size) {
+		for (;;) {
+			uint32_t offset = _dataIndex.fetch_add(size);
+			uint32_t first = 0;
+			uint32_t last = 0;
+			if (findEventBlock(offset, EVENT_DATA_BLOCK_SIZE, &first) == findEventBlock(offset + size - 1, EVENT_DATA_BLOCK_SIZE, &last)) {
+				return offset;
+			}
+		}
+	}
+
+	// -------------------------------------------------------
+	// add event
+	// -------------------------------------------------------
+	void EventStream::add(uint32_t type, void* p, size_t size) {
+		uint32_t index = _numEvents.fetch_add(1);
+		EventHeader* header = getHeader(index);
+		header->type = type;
+		header->size = static_cast<uint32_t>(size);
+		header->offset = 0;
+		header->next = NO_EVENT;
+		if (size > 0) {
+			header->offset = reserveData(header->size);
+			memcpy(getData(header->offset), p, size);
+		}
+		if (type < MAX_EVENT_CHANNELS) {
+			header->next = _channels[type].exchange(index);
+			_channelSizes[type].fetch_add(1);
+		}
+		_presence.fetch_or(1ull << (type % MAX_EVENT_CHANNELS));
+	}
+
+	// -------------------------------------------------------
+	// add event
+	// -------------------------------------------------------
+	void EventStream::add(uint32_t type) {
+		add(type, 0, 0);
+	}
+
+	// -------------------------------------------------------
+	// get
+	// -------------------------------------------------------
+	const bool EventStream::get(uint32_t index, void* p) const {
+		if (index >= num()) {
+			return false;
+		}
+		const EventHeader* header = getHeader(index);
+		if (header->size > 0) {
+			memcpy(p, getData(header->offset), header->size);
+		}
+		return true;
+	}
+
+	// -------------------------------------------------------
+	// get type
+	// -------------------------------------------------------
+	const int EventStream::getType(uint32_t index) const {
+		assert(index < num());
+		return getHeader(index)->type;
+	}
+
+	// -------------------------------------------------------
+	// contains type. Types outside the channels share their
+	// presence bit so a set bit has to be confirmed.
+	// -------------------------------------------------------
+	const bool EventStream::containsType(uint32_t type) const {
+		uint64_t mask = 1ull << (type % MAX_EVENT_CHANNELS);
+		if ((_presence.load() & mask) == 0) {
+			return false;
+		}
+		if (type < MAX_EVENT_CHANNELS) {
+			return true;
+		}
+		for (uint32_t i = 0; i < num(); ++i) {
+			if (getType(i) == type) {
+				return true;
+			}
+		}
+		return false;
+	}
+
+	// -------------------------------------------------------
+	// number of events of the given type
+	// -------------------------------------------------------
+	const uint32_t EventStream::numType(uint32_t type) const {
+		if (type < MAX_EVENT_CHANNELS) {
+			return _channelSizes[type].load();
+		}
+		uint32_t cnt = 0;
+		for (uint32_t i = 0; i < num(); ++i) {
+			if (getType(i) == type) {
+				++cnt;
+			}
+		}
+		return cnt;
+	}
+
+	// -------------------------------------------------------
+	// index of the latest event of a channel or NO_EVENT
+	// -------------------------------------------------------
+	const uint32_t EventStream::firstOfType(uint32_t type) const {
+		assert(type < MAX_EVENT_CHANNELS);
+		return _channels[type].load();
+	}
+
+	// -------------------------------------------------------
+	// index of the previous event in the same channel
+	// -------------------------------------------------------
+	const uint32_t EventStream::nextOfType(uint32_t index) const {
+		return getHeader(index)->next;
+	}
+
+}
+
+#endif
@@ -3,16 +3,6 @@
 
 //#define DS_IMGUI_IMPLEMENTATION
 
-struct p2i {
-	
-	int x;
-	int y;
-
-	p2i() : x(0), y(0) {}
-	explicit p2i(int v) : x(v), y(v) {}
-	p2i(int xv, int yv) : x(xv), y(yv) {}
-};
-
 struct recti {
 
 	int left;
@@ -0,0 +1,287 @@
+#pragma once
+#include <stdint.h>
+
+// -------------------------------------------------------
+// CPU zone profiler
+//
+// Zones are recorded by RAII markers into one ring buffer
+// per thread. Only the owning thread writes into its ring,
+// so recording needs no locks. The rings can be exported
+// as Chrome trace JSON and opened in chrome://tracing.
+// A thread returns its ring when it exits and the next new
+// thread records into it, so only MAX_PROFILER_THREADS
+// threads can be recorded at the same time. Threads beyond
+// that are counted as dropped.
+//
+// Define DS_PROFILER_IMPLEMENTATION in exactly one file.
+// Define DS_NO_PROFILER to compile all zones out.
+// -------------------------------------------------------
+namespace perf {
+
+	const int MAX_PROFILER_THREADS = 16;
+	const int PROFILER_RING_SIZE = 16384;
+	const int MAX_ZONE_DEPTH = 32;
+
+	void init();
+
+	void setThreadName(const char* name);
+
+	uint64_t now();
+
+	void beginZone(const char* name);
+
+	void endZone();
+
+	bool exportChromeTrace(const char* fileName);
+
+	int getNumDroppedThreads();
+
+	struct ZoneScope {
+		ZoneScope(const char* name) {
+			beginZone(name);
+		}
+		~ZoneScope() {
+			endZone();
+		}
+	};
+
+}
+
+#define PERF_CONCAT_INNER(a, b) a##b
+#define PERF_CONCAT(a, b) PERF_CONCAT_INNER(a, b)
+
+#ifdef DS_NO_PROFILER
+#define PERF_ZONE(name)
+#else
+#define PERF_ZONE(name) perf::ZoneScope PERF_CONCAT(perfZone, __LINE__)(name)
+#endif
+
+#ifdef DS_PROFILER_IMPLEMENTATION
+
+#include <stdio.h>
+#include <string.h>
+#include <atomic>
+#include <chrono>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+namespace perf {
+
+	struct ZoneEvent {
+		const char* name;
+		uint64_t start;
+		uint64_t end;
+		int depth;
+	};
+
+	struct OpenZone {
+		const char* name;
+		uint64_t start;
+	};
+
+	// -------------------------------------------------------
+	// ring of one thread. head only grows, the slot of an
+	// event is head % PROFILER_RING_SIZE.
+	// -------------------------------------------------------
+	struct ThreadRing {
+		ZoneEvent events[PROFILER_RING_SIZE];
+		std::atomic<uint64_t> head;
+		OpenZone stack[MAX_ZONE_DEPTH];
+		int depth;
+		char name[32];
+		std::atomic<bool> used;
+	};
+
+	typedef std::chrono::steady_clock Clock;
+
+	struct ProfilerContext {
+		std::atomic<ThreadRing*> rings[MAX_PROFILER_THREADS];
+		std::atomic<int> numRings;
+		std::atomic<int> numDropped;
+		uint64_t startTicks;
+		Clock::time_point startTime;
+	};
+
+	static ProfilerContext _profilerCtx;
+
+	// -------------------------------------------------------
+	// ring of the current thread. The ring is given back when
+	// the thread exits but never freed since the export may
+	// still read it.
+	// -------------------------------------------------------
+	struct ThreadRingOwner {
+		ThreadRing* ring;
+		bool dropped;
+		~ThreadRingOwner() {
+			if (ring != 0) {
+				ring->depth = 0;
+				ring->used.store(false, std::memory_order_release);
+			}
+		}
+	};
+
+	static thread_local ThreadRingOwner _threadRing = { 0, false };
+
+	// -------------------------------------------------------
+	// timestamp - rdtsc where available
+	// -------------------------------------------------------
+	uint64_t now() {
+#ifdef _MSC_VER
+		return __rdtsc();
+#else
+		return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now().time_since_epoch()).count());
+#endif
+	}
+
+	// -------------------------------------------------------
+	// init - remembers the reference point to convert ticks
+	// -------------------------------------------------------
+	void init() {
+		_profilerCtx.startTicks = now();
+		_profilerCtx.startTime = Clock::now();
+		setThreadName("main");
+	}
+
+	// -------------------------------------------------------
+	// ring of the calling thread. A ring given back by an
+	// exited thread is taken first, its events stay in the
+	// trace. Threads beyond the limit are not recorded.
+	// -------------------------------------------------------
+	static ThreadRing* getThreadRing() {
+		if (_threadRing.ring == 0 && !_threadRing.dropped) {
+			int numRings = _profilerCtx.numRings.load();
+			for (int i = 0; i < numRings && i < MAX_PROFILER_THREADS; ++i) {
+				ThreadRing* ring = _profilerCtx.rings[i].load();
+				bool used = false;
+				if (ring != 0 && ring->used.compare_exchange_strong(used, true, std::memory_order_acquire)) {
+					sprintf(ring->name, "thread %d", i);
+					_threadRing.ring = ring;
+					return ring;
+				}
+			}
+			int index = _profilerCtx.numRings.fetch_add(1);
+			if (index >= MAX_PROFILER_THREADS) {
+				_profilerCtx.numDropped.fetch_add(1);
+				_threadRing.dropped = true;
+				return 0;
+			}
+			ThreadRing* ring = new ThreadRing;
+			ring->head = 0;
+			ring->depth = 0;
+			ring->used = true;
+			sprintf(ring->name, "thread %d", index);
+			_profilerCtx.rings[index] = ring;
+			_threadRing.ring = ring;
+		}
+		return _threadRing.ring;
+	}
+
+	// -------------------------------------------------------
+	// number of threads that found no free ring
+	// -------------------------------------------------------
+	int getNumDroppedThreads() {
+		return _profilerCtx.numDropped.load();
+	}
+
+	// -------------------------------------------------------
+	// set thread name
+	// -------------------------------------------------------
+	void setThreadName(const char* name) {
+		ThreadRing* ring = getThreadRing();
+		if (ring != 0) {
+			strncpy(ring->name, name, sizeof(ring->name) - 1);
+			ring->name[sizeof(ring->name) - 1] = '\0';
+		}
+	}
+
+	// -------------------------------------------------------
+	// begin zone
+	// -------------------------------------------------------
+	void beginZone(const char* name) {
+		ThreadRing* ring = getThreadRing();
+		if (ring != 0) {
+			if (ring->depth < MAX_ZONE_DEPTH) {
+				OpenZone& zone = ring->stack[ring->depth];
+				zone.name = name;
+				zone.start = now();
+			}
+			++ring->depth;
+		}
+	}
+
+	// -------------------------------------------------------
+	// end zone - the finished zone is published to the ring
+	// -------------------------------------------------------
+	void endZone() {
+		ThreadRing* ring = _threadRing.ring;
+		if (ring != 0 && ring->depth > 0) {
+			--ring->depth;
+			if (ring->depth < MAX_ZONE_DEPTH) {
+				const OpenZone& zone = ring->stack[ring->depth];
+				uint64_t head = ring->head.load(std::memory_order_relaxed);
+				ZoneEvent& event = ring->events[head % PROFILER_RING_SIZE];
+				event.name = zone.name;
+				event.start = zone.start;
+				event.end = now();
+				event.depth = ring->depth;
+				ring->head.store(head + 1, std::memory_order_release);
+			}
+		}
+	}
+
+	// -------------------------------------------------------
+	// export all rings as Chrome trace. Events that have been
+	// overwritten while copying are skipped.
+	// -------------------------------------------------------
+	bool exportChromeTrace(const char* fileName) {
+		FILE* fp = fopen(fileName, "w");
+		if (fp == 0) {
+			return false;
+		}
+		double elapsedUs = std::chrono::duration<double, std::micro>(Clock::now() - _profilerCtx.startTime).count();
+		uint64_t elapsedTicks = now() - _profilerCtx.startTicks;
+		double usPerTick = elapsedTicks > 0 ? elapsedUs / static_cast<double>(elapsedTicks) : 0.0;
+		ZoneEvent* copy = new ZoneEvent[PROFILER_RING_SIZE];
+		fprintf(fp, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+		bool first = true;
+		int numRings = _profilerCtx.numRings.load();
+		if (numRings > MAX_PROFILER_THREADS) {
+			numRings = MAX_PROFILER_THREADS;
+		}
+		for (int t = 0; t < numRings; ++t) {
+			ThreadRing* ring = _profilerCtx.rings[t].load();
+			if (ring == 0) {
+				continue;
+			}
+			fprintf(fp, "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":0,\"tid\":%d,\"args\":{\"name\":\"%s\"}}", first ? "" : ",\n", t, ring->name);
+			first = false;
+			uint64_t head = ring->head.load(std::memory_order_acquire);
+			uint64_t tail = head > PROFILER_RING_SIZE ? head - PROFILER_RING_SIZE : 0;
+			for (uint64_t i = tail; i < head; ++i) {
+				copy[i % PROFILER_RING_SIZE] = ring->events[i % PROFILER_RING_SIZE];
+			}
+			// the writer may have wrapped around while we were copying
+			uint64_t current = ring->head.load(std::memory_order_acquire);
+			if (current > PROFILER_RING_SIZE && current - PROFILER_RING_SIZE > tail) {
+				tail = current - PROFILER_RING_SIZE;
+			}
+			for (uint64_t i = tail; i < head; ++i) {
+				const ZoneEvent& e = copy[i % PROFILER_RING_SIZE];
+				if (e.start < _profilerCtx.startTicks) {
+					continue;
+				}
+				double ts = (e.start - _profilerCtx.startTicks) * usPerTick;
+				double dur = (e.end - e.start) * usPerTick;
+				fprintf(fp, ",\n{\"name\":\"%s\",\"ph\":\"X\",\"pid\":0,\"tid\":%d,\"ts\":%.3f,\"dur\":%.3f}", e.name, t, ts, dur);
+			}
+		}
+		fprintf(fp, "\n]}\n");
+		fclose(fp);
+		delete[] copy;
+		return true;
+	}
+
+}
+
+#endif
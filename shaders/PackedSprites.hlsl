@@ -0,0 +1,59 @@
+// ---------------------------------------------------------------
+// Vertex shader for the PackedSpriteBatchBuffer. Every sprite is
+// stored as one uint4:
+//   x : position x / y as signed 12.4 fixed point
+//   y : atlas rect index / scale x as half float
+//   z : scale y as half float / rotation as half float
+//   w : color as RGBA8
+// The pixel shader is the one of the SpriteBatchBuffer.
+// ---------------------------------------------------------------
+cbuffer cbChangesPerFrame : register(b0) {
+	float4 screenDimension;
+	float4x4 wvp;
+	float4 rects[256];
+};
+
+StructuredBuffer<uint4> SpriteData : register(t1);
+
+struct PS_Input {
+	float4 pos : SV_POSITION;
+	float2 tex : TEXCOORD0;
+	float4 color : COLOR0;
+};
+
+static const float2 CORNERS[4] = {
+	float2(-0.5f,  0.5f),
+	float2( 0.5f,  0.5f),
+	float2(-0.5f, -0.5f),
+	float2( 0.5f, -0.5f)
+};
+
+static const float2 UVS[4] = {
+	float2(0.0f, 0.0f),
+	float2(1.0f, 0.0f),
+	float2(0.0f, 1.0f),
+	float2(1.0f, 1.0f)
+};
+
+PS_Input VS_Main(uint id : SV_VERTEXID) {
+	PS_Input vsOut = (PS_Input)0;
+	uint4 data = SpriteData[id / 4];
+	uint vertexIndex = id % 4;
+
+	float2 position = float2((int)(data.x << 16) >> 16, (int)data.x >> 16) / 16.0f;
+	float4 rect = rects[data.y & 0xffff];
+	float2 scaling = float2(f16tof32(data.y >> 16), f16tof32(data.z));
+	float rotation = f16tof32(data.z >> 16);
+	float4 color = float4(data.w & 0xff, (data.w >> 8) & 0xff, (data.w >> 16) & 0xff, data.w >> 24) / 255.0f;
+
+	float2 p = CORNERS[vertexIndex] * rect.zw * scaling;
+	float s = sin(rotation);
+	float c = cos(rotation);
+	float2 rp = float2(p.x * c - p.y * s, p.x * s + p.y * c);
+	rp += position - screenDimension.xy;
+	vsOut.pos = mul(float4(rp, 0.0f, 1.0f), wvp);
+	vsOut.pos.z = 1.0f;
+	vsOut.tex = (rect.xy + UVS[vertexIndex] * rect.zw) / screenDimension.zw;
+	vsOut.color = color;
+	return vsOut;
+}
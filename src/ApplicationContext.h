@@ -1,13 +1,12 @@
 #pragma once
-#include <diesel.h>
-#include "lib\DataArray.h"
+#include <ds_math.h>
+#include "lib/DataArray.h"
 
 // ---------------------------------------------------------------
 // tower rotation animation
 // ---------------------------------------------------------------
 struct RotationAnimation {
-	float angle;
-	int direction;
+	ID tween;
 	float timer;
 	float ttl;
 };
@@ -74,7 +73,11 @@ struct PendingWalkers {
 };
 
 // ---------------------------------------------------------------
-// walker
+// walker - with a path id the walker follows that path of the
+// PathTable and pos is evaluated from the distance plus the
+// offset the crowd separation has pushed it away from the path.
+// Otherwise it steers along the flow field from gridPos. The
+// distance is counted in both cases.
 // ---------------------------------------------------------------
 struct Walker {
 	ID id;
@@ -85,6 +88,9 @@ struct Walker {
 	WalkerType::Enum type;
 	int definitionIndex;
 	int energy;
+	int pathID;
+	float distance;
+	ds::vec2 offset;
 };
 
 // ---------------------------------------------------------------
@@ -1,24 +1,40 @@
 #include "Battleground.h"
-#include "..\FlowField.h"
+#include "../FlowField.h"
+#include "../AsyncFlowField.h"
+#include "../PathSmoother.h"
+#include "../ConnectivityAnalyzer.h"
+#include "../RegionLabels.h"
+#include "TileLayer.h"
+#include "SpriteRecorder.h"
+#include "PathTable.h"
+#include "CrowdSeparation.h"
+#include "lib/JobSystem.h"
+#include "lib/TweenEngine.h"
+#include "lib/LinearArena.h"
+#include "lib/AllocationCounter.h"
+#include "lib/Metrics.h"
 #include <SpriteBatchBuffer.h>
 #include <ds_imgui.h>
+#include <ds_profiler.h>
 #include "EventTypes.h"
-#include "utils\CSVFile.h"
+#include "Simulation.h"
+#include "utils/CSVFile.h"
+#include <time.h>
+
+// number of entities recorded as one job while rendering
+const int SPRITE_CHUNK_SIZE = 1024;
+
+const char* REPLAY_FILE_NAME = "replay.bin";
+
+// the arrow of the first direction texture starts at the center
+// and points to the right
+const ds::vec4 PATH_ARROW_TEXTURE = ds::vec4(0, 138, 46, 46);
+const float PATH_ARROW_LENGTH = 18.0f;
 
 ds::vec2 convert_to_screen(int gx, int gy) {
 	return{ START_X + gx * 46, START_Y + gy * 46 };
 }
 
-// ---------------------------------------------------------------
-// get angle between two ds::vec2 vectors
-// ---------------------------------------------------------------
-float getAngle(const ds::vec2& u, const ds::vec2& v) {
-	double x = v.x - u.x;
-	double y = v.y - u.y;
-	double ang = atan2(y, x);
-	return (float)ang;
-}
-
 // ---------------------------------------------------------------
 // ctor
 // ---------------------------------------------------------------
@@ -30,17 +46,55 @@ Battleground::Battleground(SpriteBatchBuffer* buffer) : ds::SpriteScene(buffer)
 	_startPoint = _grid->getStart();
 	_endPoint = _grid->getEnd();
 	_selectedTower = -1;
-	_flowField = new FlowField(_grid);
-	_flowField->build(_endPoint);
+	_random.setSeed(static_cast<uint32_t>(time(0)));
+	_replay = new ds::ReplayLog;
+	_replayMode = ReplayMode::NONE;
+	_commands.reserve(ds::MAX_REPLAY_COMMANDS);
+	_flowFields = new AsyncFlowField(_grid);
+	_flowFields->setConnectivity(FlowFieldConnectivity::EIGHT_WAY, CornerCutting::NEVER);
+	readTileCosts();
+	// placement, spawning and the path finders see the same costs
+	_grid->setTileCosts(_flowFields->getTileCosts());
+	_flowFields->build(_endPoint);
+	_flowField = _flowFields->get();
+	_tileLayer = new TileLayer(_grid, _flowField);
+	_jobs = new ds::JobSystem;
+	_spriteRecorder = new SpriteRecorder(_jobs->getNumThreads());
+	_tweens = new ds::TweenEngine(GRID_SIZE_X * GRID_SIZE_Y, EventType::TWEEN_FINISHED);
+	// the tweens write directly into the towers so they must never move
+	_towers.reserve(GRID_SIZE_X * GRID_SIZE_Y);
+	_path.reserve(GRID_SIZE_X * GRID_SIZE_Y);
+	_waypoints.reserve(GRID_SIZE_X * GRID_SIZE_Y + 1);
+	_paths = new PathTable;
+	_crowd = new CrowdSeparation(static_cast<int>(sizeof(_walkers.objects) / sizeof(Walker)));
+	_connectivity = new ConnectivityAnalyzer(_grid, _flowField);
+	_regions = new RegionLabels(_grid, _flowField);
+	_pathID = -1;
 	buildPath();
 	_pendingWalkers = { WalkerType::SIMPLE_CELL, 0, 0.0f, 0.0f };
 	_dbgTTL = 0.4f;
 	_dbgShowOverlay = false;
 	_dbgShowPath = true;
+	_dbgFollowPath = true;
+	_dbgSeparation = true;
+	_dbgShowPlacement = false;
+	_dbgAsyncBuild = false;
 	_dbgWalkerIndex = 0;
 	_dbgTowerType = 0;
+	_dbgAllocations = ds::getNumAllocations();
+	_dbgPerfState = 0;
+	_dbgReplayState = 0;
+	_metrics = new ds::Metrics;
+	_metricIDs.flowFieldBuild = _metrics->add("flowfield_ms", ds::MetricType::TIMER);
+	_metricIDs.nodesExpanded = _metrics->add("nodes_expanded", ds::MetricType::COUNTER);
+	_metricIDs.collisionTests = _metrics->add("collision_tests", ds::MetricType::COUNTER);
+	_metricIDs.sprites = _metrics->add("sprites", ds::MetricType::GAUGE);
+	_metricIDs.allocations = _metrics->add("allocations", ds::MetricType::GAUGE);
+	_metricIDs.walkersHighWater = _metrics->add("walkers_max", ds::MetricType::GAUGE);
+	_metricIDs.bulletsHighWater = _metrics->add("bullets_max", ds::MetricType::GAUGE);
 
-	CSVFile csvFile;
+	ds::ArenaScope scope(ds::getThreadArena());
+	CSVFile csvFile(ds::getThreadArena());
 	if (csvFile.load("walker_definitions.csv", "resources")) {
 		size_t num = csvFile.size();
 		for (size_t i = 0; i < num; ++i) {
@@ -67,12 +121,38 @@ Battleground::Battleground(SpriteBatchBuffer* buffer) : ds::SpriteScene(buffer)
 // dtor
 // ---------------------------------------------------------------
 Battleground::~Battleground() {
-	delete _flowField;
+	delete _replay;
+	delete _metrics;
+	delete _tweens;
+	delete _spriteRecorder;
+	delete _jobs;
+	delete _tileLayer;
+	delete _paths;
+	delete _crowd;
+	delete _connectivity;
+	delete _regions;
+	delete _flowFields;
 	delete _grid;
 }
 
+// ---------------------------------------------------------------
+// read the traversal costs per tile type
+// ---------------------------------------------------------------
+void Battleground::readTileCosts() {
+	ds::ArenaScope scope(ds::getThreadArena());
+	CSVFile csvFile(ds::getThreadArena());
+	if (csvFile.load("tile_costs.csv", "resources")) {
+		size_t num = csvFile.size();
+		for (size_t i = 0; i < num; ++i) {
+			const TextLine& tl = csvFile.get(i);
+			_flowFields->setTileCost(tl.get_int(0), tl.get_int(1));
+		}
+	}
+}
+
 void Battleground::readTowerDefinitions() {
-	CSVFile csvFile;
+	ds::ArenaScope scope(ds::getThreadArena());
+	CSVFile csvFile(ds::getThreadArena());
 	if (csvFile.load("tower_definitions.csv", "resources")) {
 		size_t num = csvFile.size();
 		for (size_t i = 0; i < num; ++i) {
@@ -92,56 +172,66 @@ void Battleground::readTowerDefinitions() {
 // render
 // ---------------------------------------------------------------
 void Battleground::render() {
+	PERF_ZONE("Battleground::render");
+	//
+	// draw grid and optional direction overlay
 	//
-	// draw grid
+	_tileLayer->render(_buffer, _dbgShowOverlay);
+
+	_spriteRecorder->reset();
+	SpriteCommandList& commands = _spriteRecorder->get(0);
 	//
-	for (int y = 0; y < _grid->height; ++y) {
-		for (int x = 0; x < _grid->width; ++x) {
-			ds::vec2 p = ds::vec2(START_X + x * 46, START_Y + 46 * y);
-			int type = _grid->get(x,y);
-			_buffer->add(p, GRID_TEXTURES[type]);
-			if (_dbgShowOverlay) {
-				// draw direction
-				int d = _flowField->get(x, y);
-				if (d >= 0 && d < 9) {
-					_buffer->add(p, ds::vec4(d * 46, 138, 46, 46));
+	// one stretched arrow per segment of the pulled path
+	//
+	for (size_t i = 1; i < _waypoints.size(); ++i) {
+		ds::vec2 from = convert_to_screen(_waypoints[i - 1].x, _waypoints[i - 1].y);
+		ds::vec2 to = convert_to_screen(_waypoints[i].x, _waypoints[i].y);
+		float length = ds::length(to - from);
+		ds::vec2 scaling = ds::vec2(length / PATH_ARROW_LENGTH, 1.0f);
+		commands.add(SpriteLayer::PATH, i, Sprite(from, PATH_ARROW_TEXTURE, scaling, getAngle(from, to)));
+	}
+	//
+	// placement preview - red cells would block the path, yellow
+	// ones make it longer
+	//
+	if (_dbgShowPlacement) {
+		for (int y = 0; y < _grid->height; ++y) {
+			for (int x = 0; x < _grid->width; ++x) {
+				uint8_t flags = _connectivity->get(x, y);
+				if (_grid->isBuildable(p2i(x, y)) && flags != 0) {
+					ds::Color clr = (flags & CELL_BLOCKING) != 0 ? ds::Color(255, 0, 0, 128) : ds::Color(255, 255, 0, 128);
+					commands.add(SpriteLayer::PREVIEW, x + y * _grid->width, Sprite(convert_to_screen(x, y), GRID_TEXTURES[0], ds::vec2(1.0f), 0.0f, clr));
 				}
 			}
 		}
 	}
-
-	for (size_t i = 0; i < _path.size(); ++i) {
-		p2i p = _path[i];
-		int d = _flowField->get(p.x, p.y);
-		if (d >= 0 && d < 9) {
-			ds::vec2 gp = ds::vec2(START_X + p.x * 46, START_Y + 46 * p.y);
-			_buffer->add(gp, ds::vec4(d * 46, 138, 46, 46));
-		}
-	}
 	//
 	// draw towers
 	//
 	for (size_t i = 0; i < _towers.size(); ++i) {
 		const Tower& t = _towers[i];
-		_buffer->add(t.position, ds::vec4(138 + t.level * 46, 46, 46, 46));
-		_buffer->add(t.position, t.texture, ds::vec2(1.0f), t.direction);
-	}
-	//
-	// draw walkers
-	//
-	for (uint32_t i = 0; i < _walkers.numObjects;++i) {	
-		const Walker& w = _walkers.objects[i];
-		const WalkerDefinition& def = _definitions[w.definitionIndex];
-		_buffer->add(w.pos, def.texture, ds::vec2(1, 1), w.rotation, def.color);
-		
+		commands.add(SpriteLayer::TOWERS, i * 2, Sprite(t.position, ds::vec4(138 + t.level * 46, 46, 46, 46)));
+		commands.add(SpriteLayer::TOWERS, i * 2 + 1, Sprite(t.position, t.texture, ds::vec2(1.0f), t.direction));
 	}
 	//
-	// draw bullets
+	// draw walkers and bullets. Both are recorded in parallel chunks.
 	//
-	for (size_t i = 0; i < _bullets.numObjects; ++i) {
-		const Bullet& b = _bullets.objects[i];
-		_buffer->add(b.pos, ds::vec4(0, 60, 12, 12));
-	}	
+	_jobs->parallelFor(_walkers.numObjects, SPRITE_CHUNK_SIZE, [this](int begin, int end, int worker) {
+		SpriteCommandList& list = _spriteRecorder->get(worker);
+		for (int i = begin; i < end; ++i) {
+			const Walker& w = _walkers.objects[i];
+			const WalkerDefinition& def = _definitions[w.definitionIndex];
+			list.add(SpriteLayer::WALKERS, i, Sprite(w.pos, def.texture, ds::vec2(1, 1), w.rotation, def.color));
+		}
+	});
+	_jobs->parallelFor(_bullets.numObjects, SPRITE_CHUNK_SIZE, [this](int begin, int end, int worker) {
+		SpriteCommandList& list = _spriteRecorder->get(worker);
+		for (int i = begin; i < end; ++i) {
+			const Bullet& b = _bullets.objects[i];
+			list.add(SpriteLayer::BULLETS, i, Sprite(b.pos, ds::vec4(0, 60, 12, 12)));
+		}
+	});
+	_spriteRecorder->merge(_buffer);
 }
 
 // ---------------------------------------------------------------
@@ -157,6 +247,9 @@ void Battleground::startWalker(int definitionIndex) {
 	w.velocity = def.velocity;
 	w.definitionIndex = definitionIndex;
 	w.energy = def.energy;
+	w.pathID = _dbgFollowPath ? _pathID : -1;
+	w.distance = 0.0f;
+	w.offset = ds::vec2(0.0f, 0.0f);
 }
 
 // ---------------------------------------------------------------
@@ -173,6 +266,7 @@ void Battleground::startWalkers(int definitionIndex, int count, float ttl) {
 // emitt walker
 // ---------------------------------------------------------------
 void Battleground::emittWalker(float dt) {
+	PERF_ZONE("emittWalker");
 	if (_pendingWalkers.count > 0) {
 		_pendingWalkers.timer += dt;
 		if (_pendingWalkers.timer >= _pendingWalkers.ttl) {
@@ -195,6 +289,19 @@ bool Battleground::isClose(const Tower& tower, const Walker& walker) const {
 // tick
 // ---------------------------------------------------------------
 void Battleground::update(float dt) {
+	PERF_ZONE("Battleground::update");
+	//
+	// close the metrics of the last frame
+	//
+	uint64_t allocations = ds::getNumAllocations();
+	_metrics->set(_metricIDs.allocations, static_cast<float>(allocations - _dbgAllocations));
+	_dbgAllocations = allocations;
+	if (_buffer != 0) {
+		_metrics->set(_metricIDs.sprites, static_cast<float>(_buffer->getLastFrameStats().sprites));
+	}
+	_metrics->set(_metricIDs.walkersHighWater, static_cast<float>(_walkers.highWater));
+	_metrics->set(_metricIDs.bulletsHighWater, static_cast<float>(_bullets.highWater));
+	_metrics->endFrame(dt);
 
 	if (_events->containsType(EventType::RIGHT_BUTTON_CLICKED)) {
 		ds::vec2 mp = ds::getMousePosition();
@@ -203,36 +310,86 @@ void Battleground::update(float dt) {
 	if (_events->containsType(EventType::LEFT_BUTTON_CLICKED)) {
 		ds::vec2 mp = ds::getMousePosition();
 		p2i gridPos;
-		_selectedTower = -1;
 		if (convert(mp.x, mp.y, &gridPos)) {
-			for (size_t i = 0; i < _towers.size(); ++i) {
-				const Tower& t = _towers[i];
-				if (gridPos.x == t.gx && gridPos.y == t.gy) {
-					_selectedTower = i;
-				}
-			}
+			pushCommand(CommandType::SELECT_TOWER, 0, gridPos.x, gridPos.y, 0.0f);
+		}
+		else {
+			pushCommand(CommandType::SELECT_TOWER, 0, -1, -1, 0.0f);
 		}
 	}
 
+	if (_replayMode == ReplayMode::PLAYING) {
+		//
+		// the log replaces the live input and the frame time
+		//
+		ds::ReplayCommand replayed[ds::MAX_REPLAY_COMMANDS];
+		int num = 0;
+		float replayDt = 0.0f;
+		if (_replay->nextTick(&replayDt, replayed, &num)) {
+			tick(replayDt, replayed, num);
+			return;
+		}
+		_replayMode = ReplayMode::NONE;
+	}
+	const ds::ReplayCommand* commands = _commands.empty() ? 0 : &_commands[0];
+	int num = static_cast<int>(_commands.size());
+	if (_replayMode == ReplayMode::RECORDING) {
+		_replay->recordTick(dt, commands, num);
+	}
+	tick(dt, commands, num);
+	_commands.clear();
+}
+
+// ---------------------------------------------------------------
+// tick - applies the commands and advances the simulation. This
+// is all the game state a replay has to reproduce.
+// ---------------------------------------------------------------
+void Battleground::tick(float dt, const ds::ReplayCommand* commands, int num) {
+	PERF_ZONE("Battleground::tick");
+	//
+	// a finished async build is published at the tick boundary
+	//
+	if (_flowFields->update()) {
+		publishFlowField();
+	}
+	for (int i = 0; i < num; ++i) {
+		executeCommand(commands[i]);
+	}
+
 	emittWalker(dt);
 
-	moveWalkers(dt);
+	moveWalkers(_walkers, _flowField, _events, dt, _paths);
+
+	if (_dbgSeparation) {
+		_crowd->apply(_walkers, dt);
+	}
 
 	rotateTowers();
 
-	for (size_t i = 0; i < _towers.size(); ++i) {
-		Tower& t = _towers[i];
-		if (t.target == INVALID_ID) {
-			t.animation.timer += dt;
-			if (t.animationState == 0) {
-				t.direction += t.animation.angle * dt * static_cast<float>(t.animation.direction);
-				if (t.animation.timer >= t.animation.ttl) {
-					t.animationState = 1;
-					t.animation.timer = 0.0f;
-					t.animation.ttl = ds::random(0.5f, 1.5f);
-				}
+	{
+		PERF_ZONE("animateTowers");
+		_tweens->tick(dt, _events);
+		//
+		// a finished rotation is followed by a short pause
+		//
+		uint32_t idx = _events->firstOfType(EventType::TWEEN_FINISHED);
+		while (idx != ds::NO_EVENT) {
+			ds::TweenEvent event;
+			_events->get(idx, &event);
+			Tower& t = _towers[event.userData];
+			if (t.animation.tween == event.id) {
+				t.animationState = 1;
+				t.animation.tween = INVALID_ID;
+				t.animation.timer = 0.0f;
+				t.animation.ttl = _random.next(0.5f, 1.5f);
 			}
-			else {
+			idx = _events->nextOfType(idx);
+		}
+
+		for (size_t i = 0; i < _towers.size(); ++i) {
+			Tower& t = _towers[i];
+			if (t.target == INVALID_ID && t.animationState == 1) {
+				t.animation.timer += dt;
 				if (t.animation.timer >= t.animation.ttl) {
 					startAnimation(i);
 				}
@@ -240,7 +397,8 @@ void Battleground::update(float dt) {
 		}
 	}
 
-	moveBullets(dt);
+	int numTests = moveBullets(_bullets, _walkers, _events, dt);
+	_metrics->increment(_metricIDs.collisionTests, static_cast<float>(numTests));
 
 	fireBullets(dt);
 }
@@ -251,23 +409,22 @@ void Battleground::update(float dt) {
 void Battleground::startAnimation(int index) {
 	Tower& t = _towers[index];
 	float min = ds::PI * 0.25f;
-	float angle = ds::random(min, min + ds::PI * 0.5f);
-	t.animation.angle = angle;
-	float dir = ds::random(-5.0f, 5.0f);
-	t.animation.direction = 1;
+	float angle = _random.next(min, min + ds::PI * 0.5f);
+	float dir = _random.next(-5.0f, 5.0f);
 	if (dir < 0.0f) {
-		t.animation.direction = -1;
+		angle = -angle;
 	}
-	t.animation.timer = 0.0f;
-	t.animation.ttl = angle / min * 2.0f;
+	float ttl = fabs(angle) / min * 2.0f;
+	// the tower turns with angle per second for ttl seconds
+	t.animation.tween = _tweens->start(&t.direction, t.direction, t.direction + angle * ttl, ttl, ds::TweenEasing::LINEAR, index);
 	t.animationState = 0;
-	//DBG_LOG("angle %3.2f ttl %2.4f direction %d", (angle*360.0f / ds::TWO_PI), t.animation.ttl,t.animation.direction);
 }
 	
 // ---------------------------------------------------------------
 // fire bullets
 // ---------------------------------------------------------------
 void Battleground::fireBullets(float dt) {
+	PERF_ZONE("fireBullets");
 	for (size_t i = 0; i < _towers.size(); ++i) {
 		Tower& t = _towers[i];
 		t.timer += dt;
@@ -297,52 +454,11 @@ void Battleground::startBullet(int towerIndex, int energy) {
 	b.velocity = 400.0f * ds::vec2(cos(direction), sin(direction));
 }
 
-// ---------------------------------------------------------------
-// check walker collision
-// ---------------------------------------------------------------
-bool Battleground::checkWalkerCollision(const ds::vec2& pos, float radius, int energy) {
-	float sumRadius = radius + 12.0f;
-	for (uint32_t i = 0; i < _walkers.numObjects; ++i) {
-		Walker& w = _walkers.objects[i];
-		float diff = sqr_length(pos - w.pos);
-		if (diff < sumRadius * sumRadius) {
-			if (_walkers.contains(w.id)) {
-				w.energy -= energy;
-				if (w.energy <= 0) {
-					_walkers.remove(w.id);
-				}
-			}
-			return true;
-		}
-	}
-	return false;
-}
-
-// ---------------------------------------------------------------
-// move bullets
-// ---------------------------------------------------------------
-void Battleground::moveBullets(float dt) {
-	for (int i = 0; i < _bullets.numObjects; ++i) {
-		Bullet& b = _bullets.objects[i];
-		b.pos += b.velocity * dt;
-		if (checkWalkerCollision(b.pos, 6.0f, b.energy)) {
-			if (_bullets.contains(b.id)) {
-				_bullets.remove(b.id);
-			}
-		}
-		else if (b.pos.x < 0.0f || b.pos.x > 1020.0f || b.pos.y < 0.0f || b.pos.y > 760.0f) {
-			if (_bullets.contains(b.id)) {
-				_bullets.remove(b.id);
-			}
-		}		
-	}
-	
-}
-
 // ---------------------------------------------------------------
 // rotate towers
 // ---------------------------------------------------------------
 void Battleground::rotateTowers() {
+	PERF_ZONE("rotateTowers");
 	for (size_t i = 0; i < _towers.size(); ++i) {
 		Tower& t = _towers[i];
 		if (t.target != INVALID_ID) {
@@ -361,20 +477,43 @@ void Battleground::rotateTowers() {
 			}
 		}
 		if (t.target == INVALID_ID) {
-			for (uint32_t i = 0; i < _walkers.numObjects; ++i) {
-				const Walker& w = _walkers.objects[i];
+			//
+			// aim at the walker in reach that is furthest along. That
+			// is the one with the lowest flow field cost at its cell.
+			// Walkers on a path do not update gridPos so the cell is
+			// taken from the position.
+			//
+			int remaining = FLOW_FIELD_UNREACHABLE;
+			for (uint32_t n = 0; n < _walkers.numObjects; ++n) {
+				const Walker& w = _walkers.objects[n];
 				float diff = sqr_length(t.position - w.pos);
-				if (diff < t.radius * t.radius) {
+				p2i cell;
+				if (diff >= t.radius * t.radius || !convert(static_cast<int>(w.pos.x), static_cast<int>(w.pos.y), &cell)) {
+					continue;
+				}
+				int cost = _flowField->getCost(cell.x, cell.y);
+				if (t.target == INVALID_ID || cost < remaining) {
+					remaining = cost;
 					ds::vec2 dd = w.pos - t.position;
 					t.direction = getAngle(ds::vec2(1, 0),normalize(dd));
 					t.target = w.id;
-
 				}
 			}
+			if (t.target != INVALID_ID && t.animationState == 0) {
+				_tweens->stop(t.animation.tween);
+				t.animation.tween = INVALID_ID;
+				t.animationState = 1;
+				t.animation.timer = 0.0f;
+			}
 		}
 	}
 }
 
+// ---------------------------------------------------------------
+// build path - traces the flow field from the start. The
+// waypoints are the pulled path including the end point. The
+// placement flags are refreshed as well.
+// ---------------------------------------------------------------
 void Battleground::buildPath() {
 	_path.clear();
 	p2i current = _startPoint;
@@ -382,29 +521,37 @@ void Battleground::buildPath() {
 		_path.push_back(current);
 		current = _flowField->next(current);
 	}
-}
-
-// ---------------------------------------------------------------
-// move walkers
-// ---------------------------------------------------------------
-void Battleground::moveWalkers(float dt) {
+	_waypoints.assign(_path.begin(), _path.end());
+	_waypoints.push_back(_endPoint);
+	int num = pullString(_grid, _flowField, _waypoints.data(), static_cast<int>(_waypoints.size()), _waypoints.data(), static_cast<int>(_waypoints.size()));
+	_waypoints.resize(num);
+	//
+	// walkers on the old path continue on the flow field from
+	// the cell they are in
+	//
 	for (uint32_t i = 0; i < _walkers.numObjects; ++i) {
 		Walker& w = _walkers.objects[i];
-		if (_flowField->hasNext(w.gridPos)) {
-			p2i n = _flowField->next(w.gridPos);
-			p2i nextPos = p2i(START_X + n.x * 46, START_Y + n.y * 46);
-			ds::vec2 diff = w.pos - ds::vec2(nextPos.x, nextPos.y);
-			if (sqr_length(diff) < 4.0f) {
-				convert(w.pos.x, w.pos.y, START_X, START_Y, &w.gridPos);
-			}
-			ds::vec2 v = normalize(ds::vec2(nextPos.x, nextPos.y) - w.pos) * w.velocity;
-			w.pos += v * dt;
-			w.rotation = getAngle(w.pos, ds::vec2(nextPos.x, nextPos.y));
-		}
-		else {
-			_walkers.remove(w.id);
+		if (w.pathID != -1) {
+			convert(w.pos.x, w.pos.y, START_X, START_Y, &w.gridPos);
+			w.pathID = -1;
+			w.offset = ds::vec2(0.0f, 0.0f);
 		}
 	}
+	_paths->clear();
+	_pathID = _paths->add(_waypoints.data(), num);
+	_connectivity->build(_startPoint, _endPoint);
+}
+
+// ---------------------------------------------------------------
+// publish flow field - switches everything to the front field of
+// the flow fields and rebuilds the path
+// ---------------------------------------------------------------
+void Battleground::publishFlowField() {
+	_flowField = _flowFields->get();
+	_metrics->increment(_metricIDs.nodesExpanded, static_cast<float>(_flowField->getNumExpanded()));
+	_tileLayer->setFlowField(_flowField);
+	_connectivity->setFlowField(_flowField);
+	buildPath();
 }
 
 // ---------------------------------------------------------------
@@ -413,11 +560,47 @@ void Battleground::moveWalkers(float dt) {
 void Battleground::addTower(ds::vec2& screenPos, int defIndex) {
 	p2i gridPos;
 	if (convert(screenPos.x, screenPos.y, &gridPos)) {
-		if (_grid->get(gridPos) == 0) {
-			const TowerDefinition& def = _towerDefinitions[defIndex];
+		pushCommand(CommandType::PLACE_TOWER, defIndex, gridPos.x, gridPos.y, 0.0f);
+	}
+}
+
+// ---------------------------------------------------------------
+// place tower
+// ---------------------------------------------------------------
+void Battleground::placeTower(const p2i& gridPos, int defIndex) {
+	PERF_ZONE("placeTower");
+	if (gridPos.x >= 0 && gridPos.x < _grid->width && gridPos.y >= 0 && gridPos.y < _grid->height) {
+		//
+		// a tower must never cut the walkers from the end. The
+		// analyzer only knows the published field, so towers placed
+		// while an async build is running are also checked on the
+		// regions of the live grid.
+		//
+		if (_grid->isBuildable(gridPos) && !_connectivity->isBlocking(gridPos.x, gridPos.y)) {
+			_regions->update();
+			bool connected = _regions->isConnected(_startPoint, _endPoint);
+			int tile = _grid->get(gridPos);
 			_grid->set(gridPos.x, gridPos.y, 1);
-			_flowField->build(_endPoint);
-			buildPath();
+			_regions->update();
+			if (connected && !_regions->isConnected(_startPoint, _endPoint)) {
+				_grid->set(gridPos.x, gridPos.y, tile);
+				return;
+			}
+			const TowerDefinition& def = _towerDefinitions[defIndex];
+			//
+			// replays need the new field in the same tick so they
+			// always build synchronously
+			//
+			if (_dbgAsyncBuild && _replayMode == ReplayMode::NONE) {
+				_flowFields->requestBuild(_endPoint);
+			}
+			else {
+				{
+					ds::MetricTimer timer(_metrics, _metricIDs.flowFieldBuild);
+					_flowFields->build(_endPoint);
+				}
+				publishFlowField();
+			}
 			Tower t;
 			t.type = 0;
 			t.gx = gridPos.x;
@@ -432,8 +615,9 @@ void Battleground::addTower(ds::vec2& screenPos, int defIndex) {
 			t.target = INVALID_ID;
 			t.level = 1;
 			t.animationState = 1;
+			t.animation.tween = INVALID_ID;
 			t.animation.timer = 0.0f;
-			t.animation.ttl = ds::random(0.5f, 1.5f);
+			t.animation.ttl = _random.next(0.5f, 1.5f);
 			_towers.push_back(t);
 		}
 	}
@@ -450,19 +634,74 @@ void Battleground::showGUI() {
 	gui::begin("Walkers", 0);
 	gui::Checkbox("Show overlay", &_dbgShowOverlay);
 	gui::Checkbox("Show path", &_dbgShowPath);
+	bool followPath = _dbgFollowPath;
+	if (gui::Checkbox("Follow path", &followPath)) {
+		pushCommand(CommandType::SET_OPTION, SimulationOption::FOLLOW_PATH, followPath ? 1 : 0, 0, 0.0f);
+	}
+	bool separation = _dbgSeparation;
+	if (gui::Checkbox("Separation", &separation)) {
+		pushCommand(CommandType::SET_OPTION, SimulationOption::SEPARATION, separation ? 1 : 0, 0, 0.0f);
+	}
+	gui::Checkbox("Show placement", &_dbgShowPlacement);
+	gui::Checkbox("Async rebuild", &_dbgAsyncBuild);
 	gui::Input("TTL", &_dbgTTL);
 	gui::StepInput("Walker", &_dbgWalkerIndex,0,8,1);
 	gui::StepInput("Tower", &_dbgTowerType, 0, 2, 1);
 	gui::Value("Bullets", _bullets.numObjects);
 	if (gui::Button("Start")) {
-		startWalkers(_dbgWalkerIndex , 8, _dbgTTL);
+		pushCommand(CommandType::START_WALKERS, _dbgWalkerIndex, 8, 0, _dbgTTL);
 	}
+	showPerformanceGUI();
+	showReplayGUI();
 	if (_selectedTower != -1) {
 		gui::begin("Tower", 0);
 		Tower& t = _towers[_selectedTower];
 		gui::Value("Index", _selectedTower);
 		gui::Value("Level", t.level);
 		if (gui::Button("Upgrade")) {
+			pushCommand(CommandType::UPGRADE_TOWER, 0, _selectedTower, 0, 0.0f);
+		}
+	}
+	gui::end();
+}
+
+// ---------------------------------------------------------------
+// push command - it will be executed by the next tick
+// ---------------------------------------------------------------
+void Battleground::pushCommand(CommandType::Enum type, int index, int x, int y, float value) {
+	if (_replayMode != ReplayMode::PLAYING && _commands.size() < ds::MAX_REPLAY_COMMANDS) {
+		ds::ReplayCommand cmd;
+		cmd.type = static_cast<uint8_t>(type);
+		cmd.index = static_cast<uint8_t>(index);
+		cmd.x = static_cast<int16_t>(x);
+		cmd.y = static_cast<int16_t>(y);
+		cmd.value = value;
+		_commands.push_back(cmd);
+	}
+}
+
+// ---------------------------------------------------------------
+// execute command
+// ---------------------------------------------------------------
+void Battleground::executeCommand(const ds::ReplayCommand& cmd) {
+	if (cmd.type == CommandType::PLACE_TOWER) {
+		placeTower(p2i(cmd.x, cmd.y), cmd.index);
+	}
+	else if (cmd.type == CommandType::SELECT_TOWER) {
+		_selectedTower = -1;
+		for (size_t i = 0; i < _towers.size(); ++i) {
+			const Tower& t = _towers[i];
+			if (cmd.x == t.gx && cmd.y == t.gy) {
+				_selectedTower = i;
+			}
+		}
+	}
+	else if (cmd.type == CommandType::START_WALKERS) {
+		startWalkers(cmd.index, cmd.x, cmd.value);
+	}
+	else if (cmd.type == CommandType::UPGRADE_TOWER) {
+		if (cmd.x >= 0 && cmd.x < static_cast<int>(_towers.size())) {
+			Tower& t = _towers[cmd.x];
 			++t.level;
 			t.energy += 10;
 			if (t.level > 3) {
@@ -471,7 +710,142 @@ void Battleground::showGUI() {
 			}
 		}
 	}
-	gui::end();
+	else if (cmd.type == CommandType::SET_OPTION) {
+		if (cmd.index == SimulationOption::FOLLOW_PATH) {
+			_dbgFollowPath = cmd.x != 0;
+		}
+		else if (cmd.index == SimulationOption::SEPARATION) {
+			_dbgSeparation = cmd.x != 0;
+		}
+	}
+}
+
+// ---------------------------------------------------------------
+// reset - back to the loaded level with a new seed
+// ---------------------------------------------------------------
+void Battleground::reset(uint32_t seed) {
+	_walkers.clear();
+	_bullets.clear();
+	_tweens->clear();
+	_towers.clear();
+	_commands.clear();
+	_selectedTower = -1;
+	_grid->load("TestLevel");
+	_startPoint = _grid->getStart();
+	_endPoint = _grid->getEnd();
+	_flowFields->build(_endPoint);
+	publishFlowField();
+	_pendingWalkers = { WalkerType::SIMPLE_CELL, 0, 0.0f, 0.0f };
+	_random.setSeed(seed);
+}
+
+// ---------------------------------------------------------------
+// start recording - the level is reset so the log starts from a
+// known state
+// ---------------------------------------------------------------
+void Battleground::startRecording(uint32_t seed) {
+	reset(seed);
+	_replay->start(seed);
+	_replayMode = ReplayMode::RECORDING;
+	// the first tick of the log sets the options
+	pushCommand(CommandType::SET_OPTION, SimulationOption::FOLLOW_PATH, _dbgFollowPath ? 1 : 0, 0, 0.0f);
+	pushCommand(CommandType::SET_OPTION, SimulationOption::SEPARATION, _dbgSeparation ? 1 : 0, 0, 0.0f);
+}
+
+// ---------------------------------------------------------------
+// stop recording
+// ---------------------------------------------------------------
+void Battleground::stopRecording(const char* fileName) {
+	if (_replayMode == ReplayMode::RECORDING) {
+		_replay->save(fileName);
+		_replayMode = ReplayMode::NONE;
+	}
+}
+
+// ---------------------------------------------------------------
+// start replay
+// ---------------------------------------------------------------
+bool Battleground::startReplay(const char* fileName) {
+	if (!_replay->load(fileName)) {
+		return false;
+	}
+	reset(_replay->getSeed());
+	_replay->rewind();
+	_replayMode = ReplayMode::PLAYING;
+	return true;
+}
+
+// ---------------------------------------------------------------
+// replay GUI
+// ---------------------------------------------------------------
+void Battleground::showReplayGUI() {
+	if (gui::begin("Replay", &_dbgReplayState)) {
+		if (_replayMode == ReplayMode::RECORDING) {
+			gui::Value("Ticks", static_cast<int>(_replay->getNumTicks()));
+			gui::Value("Bytes", _replay->size());
+			if (gui::Button("Stop")) {
+				stopRecording(REPLAY_FILE_NAME);
+			}
+		}
+		else if (_replayMode == ReplayMode::PLAYING) {
+			gui::Value("Tick", static_cast<int>(_replay->getCurrentTick()));
+			gui::Value("Ticks", static_cast<int>(_replay->getNumTicks()));
+			if (gui::Button("Stop")) {
+				_replayMode = ReplayMode::NONE;
+			}
+		}
+		else {
+			if (gui::Button("Record")) {
+				startRecording(static_cast<uint32_t>(time(0)));
+			}
+			if (gui::Button("Play")) {
+				startReplay(REPLAY_FILE_NAME);
+			}
+		}
+	}
+}
+
+// ---------------------------------------------------------------
+// performance HUD
+// ---------------------------------------------------------------
+void Battleground::showPerformanceGUI() {
+	if (gui::begin("Performance", &_dbgPerfState)) {
+		int frameID = ds::FRAME_TIME_METRIC;
+		gui::Value("Frame ms", _metrics->getLast(frameID), "%.2f");
+		gui::Value("p50", _metrics->getPercentile(frameID, 50.0f), "%.2f");
+		gui::Value("p95", _metrics->getPercentile(frameID, 95.0f), "%.2f");
+		gui::Value("p99", _metrics->getPercentile(frameID, 99.0f), "%.2f");
+		float values[ds::METRICS_HISTORY_SIZE];
+		int num = _metrics->getHistory(frameID, values, 64);
+		if (num > 1) {
+			gui::Diagram(values, num, 0.0f, 50.0f, 10.0f);
+			//
+			// distribution of the frame times in 2ms buckets
+			//
+			float buckets[16] = { 0.0f };
+			num = _metrics->getHistory(frameID, values, ds::METRICS_HISTORY_SIZE);
+			for (int i = 0; i < num; ++i) {
+				int b = static_cast<int>(values[i] / 2.0f);
+				buckets[b < 15 ? b : 15] += 1.0f;
+			}
+			gui::Histogram(buckets, 16, 0.0f, static_cast<float>(num), static_cast<float>(num) / 4.0f);
+		}
+		for (int i = 1; i < _metrics->num(); ++i) {
+			if (_metrics->getType(i) == ds::MetricType::TIMER) {
+				gui::Value(_metrics->getName(i), _metrics->getMax(i), "%.3f");
+			}
+			else {
+				gui::Value(_metrics->getName(i), _metrics->getLast(i), "%.0f");
+			}
+		}
+		if (gui::Button("Save metrics")) {
+			_metrics->saveCSV("metrics.csv");
+		}
+		gui::Value("Unprofiled threads", perf::getNumDroppedThreads());
+		if (gui::Button("Save trace")) {
+			perf::exportChromeTrace("trace.json");
+		}
+	}
 }
 
 // ---------------------------------------------------------------
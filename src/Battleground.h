@@ -3,11 +3,69 @@
 #include <vector>
 #include <ds_base_app.h>
 #include "Grid.h"
-#include "lib\DataArray.h"
+#include "lib/DataArray.h"
+#include "lib/Random.h"
+#include "lib/ReplayLog.h"
 #include "ApplicationContext.h"
 
 class FlowField;
 class SpriteBatchBuffer;
+class TileLayer;
+class SpriteRecorder;
+class PathTable;
+class CrowdSeparation;
+class ConnectivityAnalyzer;
+class AsyncFlowField;
+class RegionLabels;
+
+namespace ds {
+	class JobSystem;
+	class TweenEngine;
+	class Metrics;
+}
+
+// ---------------------------------------------------------------
+// Every input that changes the simulation is turned into a
+// command. Commands are applied at the start of the next tick
+// and can be recorded and replayed.
+//
+// PLACE_TOWER   : x, y = grid position, index = tower definition
+// SELECT_TOWER  : x, y = grid position or -1 to clear the selection
+// START_WALKERS : index = walker definition, x = count, value = ttl
+// UPGRADE_TOWER : x = tower index
+// SET_OPTION    : index = simulation option, x = 0 or 1
+// ---------------------------------------------------------------
+struct CommandType {
+
+	enum Enum {
+		PLACE_TOWER,
+		SELECT_TOWER,
+		START_WALKERS,
+		UPGRADE_TOWER,
+		SET_OPTION
+	};
+};
+
+// ---------------------------------------------------------------
+// debug options that change the simulation. They are only set
+// by commands so a replay sees the same values.
+// ---------------------------------------------------------------
+struct SimulationOption {
+
+	enum Enum {
+		FOLLOW_PATH,
+		SEPARATION
+	};
+};
+
+struct ReplayMode {
+
+	enum Enum {
+		NONE,
+		RECORDING,
+		PLAYING
+	};
+};
 
 struct Level {
 	const char* name;
@@ -18,6 +76,19 @@ struct Level {
 
 typedef std::vector<Tower> Towers;
 
+// ---------------------------------------------------------------
+// ids of the metrics fed by the battleground
+// ---------------------------------------------------------------
+struct BattlegroundMetrics {
+	int flowFieldBuild;
+	int nodesExpanded;
+	int collisionTests;
+	int sprites;
+	int allocations;
+	int walkersHighWater;
+	int bulletsHighWater;
+};
+
 class Battleground : public ds::SpriteScene {
 
 public:
@@ -28,23 +99,40 @@ public:
 	void startWalkers(int definitionIndex, int count, float ttl);
 	void addTower(ds::vec2& screenPos,int defIndex);
 	void update(float dt);
+	void tick(float dt, const ds::ReplayCommand* commands, int num);
+	void reset(uint32_t seed);
+	void startRecording(uint32_t seed);
+	void stopRecording(const char* fileName);
+	bool startReplay(const char* fileName);
 	void showGUI();
 private:
+	void pushCommand(CommandType::Enum type, int index, int x, int y, float value);
+	void executeCommand(const ds::ReplayCommand& cmd);
+	void placeTower(const p2i& gridPos, int defIndex);
+	void showReplayGUI();
 	void startAnimation(int index);
+	void showPerformanceGUI();
 	void readTowerDefinitions();
+	void readTileCosts();
 	void buildPath();
+	void publishFlowField();
 	void emittWalker(float dt);
-	void moveWalkers(float dt);
 	bool isClose(const Tower& tower, const Walker& walker) const;
 	void rotateTowers();
 	void startBullet(int towerIndex, int energy);
-	void moveBullets(float dt);
-	bool checkWalkerCollision(const ds::vec2& pos, float radius, int energy);
 	void fireBullets(float dt);
 	ds::DataArray<Walker> _walkers;
 	ds::DataArray<Bullet> _bullets;
 	Grid* _grid;
+	AsyncFlowField* _flowFields;
+	// the published field of _flowFields
 	FlowField* _flowField;
+	TileLayer* _tileLayer;
+	SpriteRecorder* _spriteRecorder;
+	ds::JobSystem* _jobs;
+	ds::TweenEngine* _tweens;
+	ds::Metrics* _metrics;
+	BattlegroundMetrics _metricIDs;
 	p2i _startPoint;
 	p2i _endPoint;
 	Towers _towers;
@@ -53,10 +141,27 @@ private:
 	WalkerDefinition _definitions[20];
 	TowerDefinition _towerDefinitions[10];
 	std::vector<p2i> _path;
+	std::vector<p2i> _waypoints;
+	PathTable* _paths;
+	CrowdSeparation* _crowd;
+	ConnectivityAnalyzer* _connectivity;
+	RegionLabels* _regions;
+	int _pathID;
+	ds::Random _random;
+	std::vector<ds::ReplayCommand> _commands;
+	ds::ReplayLog* _replay;
+	ReplayMode::Enum _replayMode;
 	// debug
 	float _dbgTTL;
 	bool _dbgShowOverlay;
 	int _dbgWalkerIndex;
 	bool _dbgShowPath;
+	bool _dbgFollowPath;
+	bool _dbgSeparation;
+	bool _dbgShowPlacement;
+	bool _dbgAsyncBuild;
 	int _dbgTowerType;
+	uint64_t _dbgAllocations;
+	int _dbgPerfState;
+	int _dbgReplayState;
 };
\ No newline at end of file
@@ -0,0 +1,255 @@
+#include "CrowdSeparation.h"
+#include <ds_profiler.h>
+#include <string.h>
+#include <math.h>
+#if defined(_M_X64) || defined(_M_IX86) || defined(__SSE2__)
+#include <emmintrin.h>
+#define DS_CROWD_SSE2
+#endif
+
+// ---------------------------------------------------------------
+// two walkers on the same spot are pushed apart along x. The one
+// with the lower index goes left.
+// ---------------------------------------------------------------
+const static float COINCIDENT_DISTANCE = 0.01f;
+
+// ---------------------------------------------------------------
+// add the push of one neighbour - the same operations in the same
+// order as one lane of the SSE2 kernel
+// ---------------------------------------------------------------
+static inline void addSeparation(float dx, float dy, int self, int other, float r, float r2, float invR, float* fx, float* fy) {
+	float d2 = dx * dx + dy * dy;
+	if (other != self && d2 < r2) {
+		float coincident2 = COINCIDENT_DISTANCE * COINCIDENT_DISTANCE;
+		if (d2 < coincident2) {
+			dx = self < other ? -COINCIDENT_DISTANCE : COINCIDENT_DISTANCE;
+			dy = 0.0f;
+			d2 = coincident2;
+		}
+		float d = sqrtf(d2);
+		float w = (r - d) * invR / d;
+		*fx += dx * w;
+		*fy += dy * w;
+	}
+}
+
+// ---------------------------------------------------------------
+// ctor
+// ---------------------------------------------------------------
+CrowdSeparation::CrowdSeparation(int capacity, float radius) : _radius(radius), _invCellSize(1.0f / radius), _capacity(capacity), _numTests(0) {
+	_x = new float[_capacity];
+	_y = new float[_capacity];
+	_forceX = new float[_capacity];
+	_forceY = new float[_capacity];
+	_sortedX = new float[_capacity];
+	_sortedY = new float[_capacity];
+	_sortedIndex = new int[_capacity];
+	_buckets = new int[_capacity];
+	_numBuckets = 16;
+	while (_numBuckets < _capacity * 2) {
+		_numBuckets *= 2;
+	}
+	_cellStart = new int[_numBuckets + 1];
+}
+
+// ---------------------------------------------------------------
+// dtor
+// ---------------------------------------------------------------
+CrowdSeparation::~CrowdSeparation() {
+	delete[] _cellStart;
+	delete[] _buckets;
+	delete[] _sortedIndex;
+	delete[] _sortedY;
+	delete[] _sortedX;
+	delete[] _forceY;
+	delete[] _forceX;
+	delete[] _y;
+	delete[] _x;
+}
+
+// ---------------------------------------------------------------
+// get bucket of a cell
+// ---------------------------------------------------------------
+int CrowdSeparation::getBucket(int cx, int cy) const {
+	uint32_t h = static_cast<uint32_t>(cx) * 0x8DA6B343u ^ static_cast<uint32_t>(cy) * 0xD8163841u;
+	return static_cast<int>((h ^ (h >> 15)) & static_cast<uint32_t>(_numBuckets - 1));
+}
+
+// ---------------------------------------------------------------
+// sort - counting sort by bucket. Walkers in the same bucket keep
+// their order.
+// ---------------------------------------------------------------
+void CrowdSeparation::sort(const float* x, const float* y, int num) {
+	memset(_cellStart, 0, (_numBuckets + 1) * sizeof(int));
+	for (int i = 0; i < num; ++i) {
+		int cx = static_cast<int>(floorf(x[i] * _invCellSize));
+		int cy = static_cast<int>(floorf(y[i] * _invCellSize));
+		_buckets[i] = getBucket(cx, cy);
+		++_cellStart[_buckets[i] + 1];
+	}
+	for (int i = 0; i < _numBuckets; ++i) {
+		_cellStart[i + 1] += _cellStart[i];
+	}
+	//
+	// the start of every bucket is used as write cursor and moves
+	// to its end, afterwards the buckets are shifted back
+	//
+	for (int i = 0; i < num; ++i) {
+		int pos = _cellStart[_buckets[i]]++;
+		_sortedX[pos] = x[i];
+		_sortedY[pos] = y[i];
+		_sortedIndex[pos] = i;
+	}
+	for (int i = _numBuckets; i > 0; --i) {
+		_cellStart[i] = _cellStart[i - 1];
+	}
+	_cellStart[0] = 0;
+}
+
+// ---------------------------------------------------------------
+// compute - the force is the sum of the unit directions away from
+// all neighbours weighted by (radius - distance) / radius
+// ---------------------------------------------------------------
+void CrowdSeparation::compute(const float* x, const float* y, int num, float* forceX, float* forceY) {
+	PERF_ZONE("CrowdSeparation::compute");
+	_numTests = 0;
+	if (num > _capacity) {
+		num = _capacity;
+	}
+	sort(x, y, num);
+	float r = _radius;
+	float r2 = r * r;
+	float invR = 1.0f / r;
+	for (int k = 0; k < num; ++k) {
+		float px = _sortedX[k];
+		float py = _sortedY[k];
+		int self = _sortedIndex[k];
+		int cx = static_cast<int>(floorf(px * _invCellSize));
+		int cy = static_cast<int>(floorf(py * _invCellSize));
+		//
+		// neighbouring cells can share a bucket, every bucket is
+		// only visited once
+		//
+		int buckets[9];
+		int numBuckets = 0;
+		for (int dy = -1; dy < 2; ++dy) {
+			for (int dx = -1; dx < 2; ++dx) {
+				int b = getBucket(cx + dx, cy + dy);
+				bool found = false;
+				for (int i = 0; i < numBuckets; ++i) {
+					found |= buckets[i] == b;
+				}
+				if (!found) {
+					buckets[numBuckets++] = b;
+				}
+			}
+		}
+		float fx = 0.0f;
+		float fy = 0.0f;
+		//
+		// groups of four walkers are summed into four lanes and the
+		// rest directly, without SSE2 the lanes are summed by hand
+		// so both builds give the same bits
+		//
+		float laneX[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+		float laneY[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+#ifdef DS_CROWD_SSE2
+		__m128 vpx = _mm_set1_ps(px);
+		__m128 vpy = _mm_set1_ps(py);
+		__m128 vr = _mm_set1_ps(r);
+		__m128 vr2 = _mm_set1_ps(r2);
+		__m128 vinvR = _mm_set1_ps(invR);
+		__m128 vc2 = _mm_set1_ps(COINCIDENT_DISTANCE * COINCIDENT_DISTANCE);
+		__m128 vpush = _mm_set1_ps(COINCIDENT_DISTANCE);
+		__m128 vzero = _mm_setzero_ps();
+		__m128i vself = _mm_set1_epi32(self);
+		__m128 accX = _mm_setzero_ps();
+		__m128 accY = _mm_setzero_ps();
+#endif
+		for (int b = 0; b < numBuckets; ++b) {
+			int j = _cellStart[buckets[b]];
+			int end = _cellStart[buckets[b] + 1];
+			_numTests += end - j;
+#ifdef DS_CROWD_SSE2
+			for (; j + 4 <= end; j += 4) {
+				__m128 dx = _mm_sub_ps(vpx, _mm_loadu_ps(_sortedX + j));
+				__m128 dy = _mm_sub_ps(vpy, _mm_loadu_ps(_sortedY + j));
+				__m128i other = _mm_loadu_si128(reinterpret_cast<const __m128i*>(_sortedIndex + j));
+				__m128 d2 = _mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy));
+				__m128 notSelf = _mm_castsi128_ps(_mm_xor_si128(_mm_cmpeq_epi32(other, vself), _mm_set1_epi32(-1)));
+				__m128 mask = _mm_and_ps(_mm_cmplt_ps(d2, vr2), notSelf);
+				//
+				// coincident walkers get a fixed direction
+				//
+				__m128 same = _mm_cmplt_ps(d2, vc2);
+				__m128 sign = _mm_castsi128_ps(_mm_cmplt_epi32(vself, other));
+				__m128 push = _mm_or_ps(_mm_and_ps(sign, _mm_sub_ps(vzero, vpush)), _mm_andnot_ps(sign, vpush));
+				dx = _mm_or_ps(_mm_and_ps(same, push), _mm_andnot_ps(same, dx));
+				dy = _mm_andnot_ps(same, dy);
+				d2 = _mm_max_ps(d2, vc2);
+				__m128 d = _mm_sqrt_ps(d2);
+				__m128 w = _mm_div_ps(_mm_mul_ps(_mm_sub_ps(vr, d), vinvR), d);
+				w = _mm_and_ps(mask, w);
+				accX = _mm_add_ps(accX, _mm_mul_ps(dx, w));
+				accY = _mm_add_ps(accY, _mm_mul_ps(dy, w));
+			}
+#else
+			for (; j + 4 <= end; j += 4) {
+				for (int l = 0; l < 4; ++l) {
+					addSeparation(px - _sortedX[j + l], py - _sortedY[j + l], self, _sortedIndex[j + l], r, r2, invR, &laneX[l], &laneY[l]);
+				}
+			}
+#endif
+			for (; j < end; ++j) {
+				addSeparation(px - _sortedX[j], py - _sortedY[j], self, _sortedIndex[j], r, r2, invR, &fx, &fy);
+			}
+		}
+#ifdef DS_CROWD_SSE2
+		_mm_storeu_ps(laneX, accX);
+		_mm_storeu_ps(laneY, accY);
+#endif
+		fx += (laneX[0] + laneX[1]) + (laneX[2] + laneX[3]);
+		fy += (laneY[0] + laneY[1]) + (laneY[2] + laneY[3]);
+		forceX[self] = fx;
+		forceY[self] = fy;
+	}
+}
+
+// ---------------------------------------------------------------
+// apply - the force is clamped to unit length so a walker in a
+// dense crowd moves at most SEPARATION_STRENGTH per second
+// ---------------------------------------------------------------
+void CrowdSeparation::apply(Walkers& walkers, float dt) {
+	PERF_ZONE("CrowdSeparation::apply");
+	int num = static_cast<int>(walkers.numObjects);
+	if (num > _capacity) {
+		num = _capacity;
+	}
+	for (int i = 0; i < num; ++i) {
+		_x[i] = walkers.objects[i].pos.x;
+		_y[i] = walkers.objects[i].pos.y;
+	}
+	compute(_x, _y, num, _forceX, _forceY);
+	for (int i = 0; i < num; ++i) {
+		Walker& w = walkers.objects[i];
+		ds::vec2 f(_forceX[i], _forceY[i]);
+		float l = sqr_length(f);
+		if (l == 0.0f) {
+			continue;
+		}
+		if (l > 1.0f) {
+			f = f / sqrtf(l);
+		}
+		ds::vec2 step = f * (SEPARATION_STRENGTH * dt);
+		if (w.pathID != -1) {
+			w.offset += step;
+			float o = sqr_length(w.offset);
+			if (o > MAX_PATH_OFFSET * MAX_PATH_OFFSET) {
+				w.offset = w.offset * (MAX_PATH_OFFSET / sqrtf(o));
+			}
+		}
+		else {
+			w.pos += step;
+		}
+	}
+}
@@ -0,0 +1,58 @@
+#pragma once
+#include "Simulation.h"
+
+// distance in pixels walkers try to keep from each other
+const static float SEPARATION_RADIUS = 24.0f;
+// speed in pixels per second a fully overlapped walker is pushed
+const static float SEPARATION_STRENGTH = 60.0f;
+// walkers on a path never move further away from it
+const static float MAX_PATH_OFFSET = 16.0f;
+
+// ---------------------------------------------------------------
+// CrowdSeparation
+//
+// Pushes walkers apart that are closer than the separation
+// radius. Every tick the positions are copied into SoA arrays and
+// sorted into cells of the radius size by a counting sort so every
+// walker only tests the walkers of the 3x3 cells around it. The
+// cells are hashed into a table of twice the walker count which
+// keeps the work linear no matter how large the map is. Cells
+// sharing a bucket only add candidates that fail the distance
+// test. The kernel runs over the sorted arrays four walkers at a
+// time into four lane sums, builds without SSE2 keep the same
+// lanes. Only IEEE exact operations are used and the walkers are
+// visited in a fixed order so the result is the same on every
+// machine and replays stay deterministic.
+// Walkers steering on the flow field are moved directly, walkers
+// on a path get an offset from the path.
+// ---------------------------------------------------------------
+class CrowdSeparation {
+
+public:
+	CrowdSeparation(int capacity, float radius = SEPARATION_RADIUS);
+	~CrowdSeparation();
+	void apply(Walkers& walkers, float dt);
+	void compute(const float* x, const float* y, int num, float* forceX, float* forceY);
+	// number of walker pairs tested by the last compute
+	int getNumTests() const {
+		return _numTests;
+	}
+private:
+	CrowdSeparation(const CrowdSeparation& orig) {}
+	void sort(const float* x, const float* y, int num);
+	int getBucket(int cx, int cy) const;
+	float _radius;
+	float _invCellSize;
+	int _capacity;
+	float* _x;
+	float* _y;
+	float* _forceX;
+	float* _forceY;
+	float* _sortedX;
+	float* _sortedY;
+	int* _sortedIndex;
+	int* _buckets;
+	int* _cellStart;
+	int _numBuckets;
+	int _numTests;
+};
@@ -1,6 +1,8 @@
 #include "Editor.h"
 #include <SpriteBatchBuffer.h>
+#include <ds_imgui.h>
 #include "EventTypes.h"
+#include "TileLayer.h"
 
 Editor::Editor(SpriteBatchBuffer* buffer) : ds::SpriteScene(buffer) {
 	_grid = new Grid(GRID_SIZE_X, GRID_SIZE_Y);
@@ -10,9 +12,11 @@ Editor::Editor(SpriteBatchBuffer* buffer) : ds::SpriteScene(buffer) {
 	_grid->setEnd(_endPoint.x, _endPoint.y);
 	_selectedType = 0;
 	sprintf_s(_name, "Testlevel");
+	_tileLayer = new TileLayer(_grid);
 }
 
 Editor::~Editor() {
+	delete _tileLayer;
 	delete _grid;
 }
 
@@ -33,13 +37,7 @@ void Editor::buttonClicked(int index) {
 }
 
 void Editor::render() {
-	for (int y = 0; y < _grid->height; ++y) {
-		for (int x = 0; x < _grid->width; ++x) {
-			int type = _grid->get(x, y);
-			ds::vec2 p = ds::vec2(START_X + x * 46, START_Y + 46 * y);
-			_buffer->add(p, GRID_TEXTURES[type]);
-		}
-	}
+	_tileLayer->render(_buffer);
 
 	_buffer->add(ds::vec2(640,650), GRID_TEXTURES[_selectedType]);
 }
@@ -3,6 +3,7 @@
 #include <ds_base_app.h>
 
 class SpriteBatchBuffer;
+class TileLayer;
 
 class Editor : public ds::SpriteScene {
 
@@ -16,6 +17,7 @@ public:
 private:
 	p2i _gridPos;
 	Grid* _grid;
+	TileLayer* _tileLayer;
 	p2i _startPoint;
 	p2i _endPoint;
 	int _selectedType;
@@ -1,10 +1,24 @@
 #pragma once
+#include <ds_math.h>
 
 struct EventType {
 
 	enum Enum {
 		LEFT_BUTTON_CLICKED,
 		RIGHT_BUTTON_CLICKED,
+		WALKER_KILLED,
+		WALKER_ESCAPED,
+		BULLET_HIT,
+		TWEEN_FINISHED,
 		DUMMY
 	};
-};
\ No newline at end of file
+};
+
+// ---------------------------------------------------------------
+// payload of WALKER_KILLED, WALKER_ESCAPED and BULLET_HIT
+// ---------------------------------------------------------------
+struct WalkerEvent {
+	uint32_t walkerID;
+	int definitionIndex;
+	ds::vec2 pos;
+};
@@ -1,11 +1,16 @@
 #pragma once
-#include <ds_imgui.h>
+#include <ds_math.h>
+#include <stdint.h>
+#include <stdio.h>
 
 const static int START_X = 200;
 const static int START_Y = 62;
 const static int GRID_SIZE_X = 20;
 const static int GRID_SIZE_Y = 12;
 
+// number of tile types of a traversal cost table
+const static int MAX_TILE_TYPES = 32;
+
 inline bool operator ==(const p2i& first, const p2i& other) {
 	return first.x == other.x && first.y == other.y;
 }
@@ -50,8 +55,8 @@ const static ds::vec4 GRID_TEXTURES[] = {
 	ds::vec4(  0,   0, 46, 46),
 	ds::vec4(138,   0, 46, 46),
 	ds::vec4(184,   0, 46, 46),
-	ds::vec4(  0,   0, 46, 46),
-	ds::vec4( 46,   0, 46, 46),
+	ds::vec4(230,  46, 46, 46),
+	ds::vec4(184,  46, 46, 46),
 	ds::vec4(  0, 184, 46, 46),
 	ds::vec4( 46, 184, 46, 46),
 	ds::vec4( 92, 184, 46, 46),
@@ -71,6 +76,11 @@ const static ds::vec4 GRID_TEXTURES[] = {
 
 const p2i INVALID_POINT = p2i(1, 1);
 
+// ---------------------------------------------------------------
+// number of cell changes the grid remembers
+// ---------------------------------------------------------------
+const static int GRID_CHANGE_LOG_SIZE = 256;
+
 struct Grid {
 	
 	int* items;
@@ -78,10 +88,15 @@ struct Grid {
 	int height;
 	p2i start;
 	p2i end;
+	uint32_t version;
+	int changes[GRID_CHANGE_LOG_SIZE];
+	
+	// traversal costs per tile type, see FlowField::getTileCosts
+	const int* tileCosts;
 	
-	Grid() : items(0), width(0), height(0), start(-1, -1), end(-1, -1) {}
+	Grid() : items(0), width(0), height(0), start(-1, -1), end(-1, -1), version(0), tileCosts(0) {}
 	
-	Grid(int w, int h) : width(w), height(h) {
+	Grid(int w, int h) : width(w), height(h), version(0), tileCosts(0) {
 		int total = width * height;
 		items = new int[total];
 		for (int i = 0; i < total; ++i) {
@@ -149,10 +164,30 @@ struct Grid {
 	void set(int x, int y, int v) {
 		if (isValid(x, y)) {
 			int idx = x + y * width;
-			items[idx] = v;
+			if (items[idx] != v) {
+				items[idx] = v;
+				changes[version % GRID_CHANGE_LOG_SIZE] = idx;
+				++version;
+			}
 		}
 	}
 
+	// -------------------------------------------------------------
+	// collect the indices of all cells changed since the given
+	// version. Returns -1 if the change log does not reach back
+	// that far and the caller needs to rebuild everything.
+	// -------------------------------------------------------------
+	int getChanges(uint32_t since, int* ret, int max) const {
+		uint32_t num = version - since;
+		if (num > GRID_CHANGE_LOG_SIZE || num > (uint32_t)max) {
+			return -1;
+		}
+		for (uint32_t i = 0; i < num; ++i) {
+			ret[i] = changes[(since + i) % GRID_CHANGE_LOG_SIZE];
+		}
+		return num;
+	}
+
 	int get(p2i p) const {
 		return items[p.x + p.y * width];
 	}
@@ -173,14 +208,30 @@ struct Grid {
 		
 	}
 	
+	// -------------------------------------------------------------
+	// a cell is available if its tile has a traversal cost. Without
+	// a cost table only empty, start and end tiles are.
+	// -------------------------------------------------------------
 	bool isAvailable(int x, int y) const {
 		if (isValid(x, y)) {
 			int idx = x + y * width;
+			if (tileCosts != 0) {
+				return items[idx] >= 0 && items[idx] < MAX_TILE_TYPES && tileCosts[items[idx]] > 0;
+			}
 			return items[idx] != 1 && items[idx] < 4;
 		}
 		return false;
 		
 	}
+
+	// a tower can be built on every available cell but start and end
+	bool isBuildable(const p2i& p) const {
+		return isAvailable(p.x, p.y) && get(p.x, p.y) != 2 && get(p.x, p.y) != 3;
+	}
+
+	void setTileCosts(const int* costs) {
+		tileCosts = costs;
+	}
 	
 	int getIndex(p2i p) const {
 		return getIndex(p.x, p.y);
@@ -192,12 +243,12 @@ struct Grid {
 
 	bool load(const char* name) {
 		char fileName[128];
-		sprintf_s(fileName, "%s.lvl", name);
+		snprintf(fileName, sizeof(fileName), "%s.lvl", name);
 		int current = 0;
 		FILE* fp = fopen(fileName, "rb");
 		if (fp) {
-			for (int y = 0; y < GRID_SIZE_Y; ++y) {
-				for (int x = 0; x < GRID_SIZE_X; ++x) {
+			for (int y = 0; y < height; ++y) {
+				for (int x = 0; x < width; ++x) {
 					fread(&current, sizeof(int), 1, fp);
 					set(x, y, current);
 					if (current == 2) {
@@ -216,11 +267,11 @@ struct Grid {
 
 	bool save(const char* name) {
 		char fileName[128];
-		sprintf_s(fileName, "%s.lvl", name);
+		snprintf(fileName, sizeof(fileName), "%s.lvl", name);
 		FILE* fp = fopen(fileName, "wb");
 		if (fp) {
-			for (int y = 0; y < GRID_SIZE_Y; ++y) {
-				for (int x = 0; x < GRID_SIZE_X; ++x) {
+			for (int y = 0; y < height; ++y) {
+				for (int x = 0; x < width; ++x) {
 					int current = get(x, y);
 					fwrite(&current, sizeof(int), 1, fp);
 				}
@@ -0,0 +1,100 @@
+#include "PathTable.h"
+#include <math.h>
+
+// ---------------------------------------------------------------
+// ctor
+// ---------------------------------------------------------------
+PathTable::PathTable(int capacity) : _capacity(capacity), _numPoints(0), _numPaths(0) {
+	_points = new ds::vec2[_capacity];
+	_directions = new ds::vec2[_capacity];
+	_lengths = new float[_capacity];
+	_rotations = new float[_capacity];
+}
+
+// ---------------------------------------------------------------
+// dtor
+// ---------------------------------------------------------------
+PathTable::~PathTable() {
+	delete[] _rotations;
+	delete[] _lengths;
+	delete[] _directions;
+	delete[] _points;
+}
+
+// ---------------------------------------------------------------
+// clear - all ids become invalid
+// ---------------------------------------------------------------
+void PathTable::clear() {
+	_numPoints = 0;
+	_numPaths = 0;
+}
+
+// ---------------------------------------------------------------
+// add - converts the cells to screen positions. Returns the id
+// of the path or -1 if the table is full.
+// ---------------------------------------------------------------
+int PathTable::add(const p2i* cells, int num) {
+	if (num <= 0 || _numPaths >= MAX_WALKER_PATHS || _numPoints + num > _capacity) {
+		return -1;
+	}
+	int offset = _numPoints;
+	float total = 0.0f;
+	float rotation = 0.0f;
+	for (int i = 0; i < num; ++i) {
+		int idx = offset + i;
+		_points[idx] = ds::vec2(START_X + cells[i].x * 46, START_Y + cells[i].y * 46);
+		_directions[idx] = ds::vec2(0.0f, 0.0f);
+		if (i > 0) {
+			ds::vec2 d = _points[idx] - _points[idx - 1];
+			float l = length(d);
+			if (l > 0.0f) {
+				_directions[idx - 1] = d / l;
+				rotation = atan2f(d.y, d.x);
+				_rotations[idx - 1] = rotation;
+			}
+			total += l;
+		}
+		_lengths[idx] = total;
+		// the last point keeps the rotation of the last segment
+		_rotations[idx] = rotation;
+	}
+	_offsets[_numPaths] = offset;
+	_counts[_numPaths] = num;
+	_totalLengths[_numPaths] = total;
+	_numPoints += num;
+	return _numPaths++;
+}
+
+// ---------------------------------------------------------------
+// evaluate - binary search for the segment containing the
+// distance. Distances beyond the path are clamped to its ends.
+// ---------------------------------------------------------------
+void PathTable::evaluate(int id, float distance, ds::vec2* pos, float* rotation) const {
+	const ds::vec2* points = _points + _offsets[id];
+	const float* lengths = _lengths + _offsets[id];
+	int num = _counts[id];
+	if (distance <= 0.0f) {
+		*pos = points[0];
+		*rotation = _rotations[_offsets[id]];
+		return;
+	}
+	if (distance >= _totalLengths[id]) {
+		*pos = points[num - 1];
+		*rotation = _rotations[_offsets[id] + num - 1];
+		return;
+	}
+	int low = 0;
+	int high = num - 1;
+	while (high - low > 1) {
+		int mid = (low + high) / 2;
+		if (lengths[mid] <= distance) {
+			low = mid;
+		}
+		else {
+			high = mid;
+		}
+	}
+	int idx = _offsets[id] + low;
+	*pos = _points[idx] + _directions[idx] * (distance - _lengths[idx]);
+	*rotation = _rotations[idx];
+}
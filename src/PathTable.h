@@ -0,0 +1,46 @@
+#pragma once
+#include <ds_math.h>
+#include "Grid.h"
+
+const static int MAX_WALKER_PATHS = 16;
+
+// ---------------------------------------------------------------
+// PathTable
+//
+// Polylines in screen coordinates that walkers can follow. Every
+// point stores the distance along the path where it is reached
+// and the direction and rotation of the segment that starts there.
+// A walker only keeps the path id and the distance travelled, the
+// position is evaluated from the segment containing the distance.
+// All paths share one pool of points.
+// ---------------------------------------------------------------
+class PathTable {
+
+public:
+	PathTable(int capacity = 4096);
+	~PathTable();
+	int add(const p2i* cells, int num);
+	void clear();
+	bool contains(int id) const {
+		return id >= 0 && id < _numPaths;
+	}
+	float getLength(int id) const {
+		return _totalLengths[id];
+	}
+	void evaluate(int id, float distance, ds::vec2* pos, float* rotation) const;
+	int num() const {
+		return _numPaths;
+	}
+private:
+	PathTable(const PathTable& orig) {}
+	ds::vec2* _points;
+	ds::vec2* _directions;
+	float* _lengths;
+	float* _rotations;
+	int _capacity;
+	int _numPoints;
+	int _offsets[MAX_WALKER_PATHS];
+	int _counts[MAX_WALKER_PATHS];
+	float _totalLengths[MAX_WALKER_PATHS];
+	int _numPaths;
+};
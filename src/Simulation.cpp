@@ -0,0 +1,135 @@
+#include "Simulation.h"
+#include "../FlowField.h"
+#include "PathTable.h"
+#include "EventTypes.h"
+#include <ds_event_stream.h>
+#include <ds_profiler.h>
+#include <math.h>
+
+// ---------------------------------------------------------------
+// get angle between two ds::vec2 vectors
+// ---------------------------------------------------------------
+float getAngle(const ds::vec2& u, const ds::vec2& v) {
+	double x = v.x - u.x;
+	double y = v.y - u.y;
+	double ang = atan2(y, x);
+	return (float)ang;
+}
+
+// ---------------------------------------------------------------
+// follow the continuous flow of an eikonal field. Returns false if
+// there is no flow or the step would enter a blocked cell. Then
+// the walker moves to the center of the next cell instead.
+// ---------------------------------------------------------------
+static bool followFlow(Walker& w, FlowField* flowField, float dt) {
+	ds::vec2 v = flowField->getFlow(w.gridPos.x, w.gridPos.y) * w.velocity;
+	if (v.x == 0.0f && v.y == 0.0f) {
+		return false;
+	}
+	ds::vec2 pos = w.pos + v * dt;
+	p2i cell;
+	if (!convert(pos.x, pos.y, START_X, START_Y, &cell) || !flowField->isPassable(cell.x, cell.y)) {
+		return false;
+	}
+	w.pos = pos;
+	w.gridPos = cell;
+	w.rotation = getAngle(ds::vec2(0.0f, 0.0f), v);
+	return true;
+}
+
+// ---------------------------------------------------------------
+// move walkers along their path or the flow field
+// ---------------------------------------------------------------
+void moveWalkers(Walkers& walkers, FlowField* flowField, ds::EventStream* events, float dt, const PathTable* paths) {
+	PERF_ZONE("moveWalkers");
+	bool useFlow = flowField->getMethod() == FlowFieldMethod::EIKONAL;
+	for (uint32_t i = 0; i < walkers.numObjects; ++i) {
+		Walker& w = walkers.objects[i];
+		w.distance += w.velocity * dt;
+		if (w.pathID != -1) {
+			//
+			// the position only depends on the distance so any time
+			// step is safe
+			//
+			if (w.distance < paths->getLength(w.pathID)) {
+				paths->evaluate(w.pathID, w.distance, &w.pos, &w.rotation);
+				w.pos += w.offset;
+				continue;
+			}
+		}
+		else if (flowField->hasNext(w.gridPos)) {
+			if (useFlow && followFlow(w, flowField, dt)) {
+				continue;
+			}
+			p2i n = flowField->next(w.gridPos);
+			p2i nextPos = p2i(START_X + n.x * 46, START_Y + n.y * 46);
+			ds::vec2 diff = w.pos - ds::vec2(nextPos.x, nextPos.y);
+			if (sqr_length(diff) < 4.0f) {
+				convert(w.pos.x, w.pos.y, START_X, START_Y, &w.gridPos);
+			}
+			ds::vec2 v = normalize(ds::vec2(nextPos.x, nextPos.y) - w.pos) * w.velocity;
+			w.pos += v * dt;
+			w.rotation = getAngle(w.pos, ds::vec2(nextPos.x, nextPos.y));
+			continue;
+		}
+		if (events != 0) {
+			WalkerEvent event = { w.id, w.definitionIndex, w.pos };
+			events->add(EventType::WALKER_ESCAPED, &event, sizeof(WalkerEvent));
+		}
+		walkers.remove(w.id);
+	}
+}
+
+// ---------------------------------------------------------------
+// check walker collision
+// ---------------------------------------------------------------
+bool checkWalkerCollision(Walkers& walkers, const ds::vec2& pos, float radius, int energy, ds::EventStream* events, int* numTests) {
+	float sumRadius = radius + 12.0f;
+	for (uint32_t i = 0; i < walkers.numObjects; ++i) {
+		if (numTests != 0) {
+			++*numTests;
+		}
+		Walker& w = walkers.objects[i];
+		float diff = sqr_length(pos - w.pos);
+		if (diff < sumRadius * sumRadius) {
+			if (walkers.contains(w.id)) {
+				WalkerEvent event = { w.id, w.definitionIndex, w.pos };
+				if (events != 0) {
+					events->add(EventType::BULLET_HIT, &event, sizeof(WalkerEvent));
+				}
+				w.energy -= energy;
+				if (w.energy <= 0) {
+					if (events != 0) {
+						events->add(EventType::WALKER_KILLED, &event, sizeof(WalkerEvent));
+					}
+					walkers.remove(w.id);
+				}
+			}
+			return true;
+		}
+	}
+	return false;
+}
+
+// ---------------------------------------------------------------
+// move bullets
+// ---------------------------------------------------------------
+int moveBullets(Bullets& bullets, Walkers& walkers, ds::EventStream* events, float dt) {
+	PERF_ZONE("moveBullets");
+	int numTests = 0;
+	for (uint32_t i = 0; i < bullets.numObjects; ++i) {
+		Bullet& b = bullets.objects[i];
+		b.pos += b.velocity * dt;
+		if (checkWalkerCollision(walkers, b.pos, 6.0f, b.energy, events, &numTests)) {
+			if (bullets.contains(b.id)) {
+				bullets.remove(b.id);
+			}
+		}
+		else if (b.pos.x < 0.0f || b.pos.x > 1020.0f || b.pos.y < 0.0f || b.pos.y > 760.0f) {
+			if (bullets.contains(b.id)) {
+				bullets.remove(b.id);
+			}
+		}
+	}
+	return numTests;
+}
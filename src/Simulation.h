@@ -0,0 +1,30 @@
+#pragma once
+#include <ds_math.h>
+#include "Grid.h"
+#include "lib/DataArray.h"
+#include "ApplicationContext.h"
+
+class FlowField;
+class PathTable;
+
+namespace ds {
+	class EventStream;
+}
+
+typedef ds::DataArray<Walker> Walkers;
+typedef ds::DataArray<Bullet> Bullets;
+
+// ---------------------------------------------------------------
+// The update loops of walkers and bullets. They only depend on
+// the data they work on so they can be used by the game as well
+// as by the benchmarks. The event stream is optional.
+// moveBullets returns the number of bullet/walker pairs tested.
+// Walkers with a path id need the path table.
+// ---------------------------------------------------------------
+float getAngle(const ds::vec2& u, const ds::vec2& v);
+
+void moveWalkers(Walkers& walkers, FlowField* flowField, ds::EventStream* events, float dt, const PathTable* paths = 0);
+
+bool checkWalkerCollision(Walkers& walkers, const ds::vec2& pos, float radius, int energy, ds::EventStream* events, int* numTests = 0);
+
+int moveBullets(Bullets& bullets, Walkers& walkers, ds::EventStream* events, float dt);
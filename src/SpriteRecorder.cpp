@@ -0,0 +1,161 @@
+#include "SpriteRecorder.h"
+#include <string.h>
+#include <assert.h>
+#include <algorithm>
+
+// the sequence number uses the lower 24 bits of the key
+const uint32_t SEQUENCE_MASK = 0xffffff;
+
+// ---------------------------------------------------------------
+// SpriteCommandList
+// ---------------------------------------------------------------
+SpriteCommandList::SpriteCommandList() : _keys(0), _sprites(0), _num(0), _capacity(0) {
+}
+
+SpriteCommandList::~SpriteCommandList() {
+	delete[] _sprites;
+	delete[] _keys;
+}
+
+// ---------------------------------------------------------------
+// double the capacity
+// ---------------------------------------------------------------
+void SpriteCommandList::grow() {
+	int capacity = _capacity == 0 ? 256 : _capacity * 2;
+	uint32_t* keys = new uint32_t[capacity];
+	Sprite* sprites = new Sprite[capacity];
+	if (_num > 0) {
+		memcpy(keys, _keys, _num * sizeof(uint32_t));
+		std::copy(_sprites, _sprites + _num, sprites);
+	}
+	delete[] _sprites;
+	delete[] _keys;
+	_keys = keys;
+	_sprites = sprites;
+	_capacity = capacity;
+}
+
+// ---------------------------------------------------------------
+// add
+// ---------------------------------------------------------------
+void SpriteCommandList::add(SpriteLayer::Enum layer, uint32_t sequence, const Sprite& sprite) {
+	assert(sequence <= SEQUENCE_MASK);
+	if (_num == _capacity) {
+		grow();
+	}
+	_keys[_num] = (static_cast<uint32_t>(layer) << 24) | sequence;
+	_sprites[_num] = sprite;
+	++_num;
+}
+
+// ---------------------------------------------------------------
+// SpriteRecorder
+// ---------------------------------------------------------------
+SpriteRecorder::SpriteRecorder(int numLists) : _numLists(numLists), _keys(0), _indices(0), _tmpKeys(0), _tmpIndices(0), _sources(0), _sorted(0), _capacity(0) {
+	_lists = new SpriteCommandList[_numLists];
+}
+
+SpriteRecorder::~SpriteRecorder() {
+	delete[] _sorted;
+	delete[] _sources;
+	delete[] _tmpIndices;
+	delete[] _tmpKeys;
+	delete[] _indices;
+	delete[] _keys;
+	delete[] _lists;
+}
+
+// ---------------------------------------------------------------
+// reset all lists
+// ---------------------------------------------------------------
+void SpriteRecorder::reset() {
+	for (int i = 0; i < _numLists; ++i) {
+		_lists[i].reset();
+	}
+}
+
+// ---------------------------------------------------------------
+// make sure the sort buffers can hold num entries
+// ---------------------------------------------------------------
+void SpriteRecorder::ensureCapacity(int num) {
+	if (num <= _capacity) {
+		return;
+	}
+	int capacity = _capacity == 0 ? 1024 : _capacity;
+	while (capacity < num) {
+		capacity *= 2;
+	}
+	delete[] _sorted;
+	delete[] _sources;
+	delete[] _tmpIndices;
+	delete[] _tmpKeys;
+	delete[] _indices;
+	delete[] _keys;
+	_keys = new uint32_t[capacity];
+	_indices = new uint32_t[capacity];
+	_tmpKeys = new uint32_t[capacity];
+	_tmpIndices = new uint32_t[capacity];
+	_sources = new const Sprite*[capacity];
+	_sorted = new Sprite[capacity];
+	_capacity = capacity;
+}
+
+// ---------------------------------------------------------------
+// merge all lists in key order and add them to the buffer
+// ---------------------------------------------------------------
+void SpriteRecorder::merge(SpriteBatchBuffer* buffer) {
+	int total = 0;
+	for (int i = 0; i < _numLists; ++i) {
+		total += _lists[i].size();
+	}
+	if (total == 0) {
+		return;
+	}
+	ensureCapacity(total);
+	int cnt = 0;
+	for (int i = 0; i < _numLists; ++i) {
+		const SpriteCommandList& list = _lists[i];
+		for (int j = 0; j < list.size(); ++j) {
+			_keys[cnt] = list.getKey(j);
+			_indices[cnt] = cnt;
+			_sources[cnt] = &list.get(j);
+			++cnt;
+		}
+	}
+	// LSD radix sort with 8 bits per pass. Every pass is stable.
+	uint32_t* keys = _keys;
+	uint32_t* indices = _indices;
+	uint32_t* tmpKeys = _tmpKeys;
+	uint32_t* tmpIndices = _tmpIndices;
+	for (int shift = 0; shift < 32; shift += 8) {
+		int offsets[256] = { 0 };
+		for (int i = 0; i < total; ++i) {
+			++offsets[(keys[i] >> shift) & 0xff];
+		}
+		// all keys share this byte so there is nothing to do
+		if (offsets[(keys[0] >> shift) & 0xff] == total) {
+			continue;
+		}
+		int sum = 0;
+		for (int i = 0; i < 256; ++i) {
+			int c = offsets[i];
+			offsets[i] = sum;
+			sum += c;
+		}
+		for (int i = 0; i < total; ++i) {
+			int pos = offsets[(keys[i] >> shift) & 0xff]++;
+			tmpKeys[pos] = keys[i];
+			tmpIndices[pos] = indices[i];
+		}
+		uint32_t* t = keys;
+		keys = tmpKeys;
+		tmpKeys = t;
+		t = indices;
+		indices = tmpIndices;
+		tmpIndices = t;
+	}
+	for (int i = 0; i < total; ++i) {
+		_sorted[i] = *_sources[indices[i]];
+	}
+	buffer->add(_sorted, total);
+}
@@ -0,0 +1,85 @@
+#pragma once
+#include <stdint.h>
+#include <SpriteBatchBuffer.h>
+
+// ---------------------------------------------------------------
+// sprite layers in drawing order
+// ---------------------------------------------------------------
+struct SpriteLayer {
+
+	enum Enum {
+		PATH,
+		PREVIEW,
+		TOWERS,
+		WALKERS,
+		BULLETS
+	};
+};
+
+// ---------------------------------------------------------------
+// SpriteCommandList
+//
+// Sprites recorded by one worker. Every sprite carries a sort
+// key built from the layer and a sequence number inside the
+// layer.
+// ---------------------------------------------------------------
+class SpriteCommandList {
+
+public:
+	SpriteCommandList();
+	~SpriteCommandList();
+	void reset() {
+		_num = 0;
+	}
+	void add(SpriteLayer::Enum layer, uint32_t sequence, const Sprite& sprite);
+	int size() const {
+		return _num;
+	}
+	uint32_t getKey(int index) const {
+		return _keys[index];
+	}
+	const Sprite& get(int index) const {
+		return _sprites[index];
+	}
+private:
+	void grow();
+	SpriteCommandList(const SpriteCommandList& orig) {}
+	uint32_t* _keys;
+	Sprite* _sprites;
+	int _num;
+	int _capacity;
+};
+
+// ---------------------------------------------------------------
+// SpriteRecorder
+//
+// One command list per worker. merge sorts all recorded sprites
+// by their keys with a stable radix sort, so the result does not
+// depend on which worker recorded which sprite.
+// ---------------------------------------------------------------
+class SpriteRecorder {
+
+public:
+	SpriteRecorder(int numLists);
+	~SpriteRecorder();
+	void reset();
+	SpriteCommandList& get(int worker) {
+		return _lists[worker];
+	}
+	int getNumLists() const {
+		return _numLists;
+	}
+	void merge(SpriteBatchBuffer* buffer);
+private:
+	void ensureCapacity(int num);
+	SpriteRecorder(const SpriteRecorder& orig) {}
+	SpriteCommandList* _lists;
+	int _numLists;
+	uint32_t* _keys;
+	uint32_t* _indices;
+	uint32_t* _tmpKeys;
+	uint32_t* _tmpIndices;
+	const Sprite** _sources;
+	Sprite* _sorted;
+	int _capacity;
+};
@@ -0,0 +1,152 @@
+#include "TileLayer.h"
+#include "../FlowField.h"
+#include <SpriteBatchBuffer.h>
+
+// ---------------------------------------------------------------
+// ctor
+// ---------------------------------------------------------------
+TileLayer::TileLayer(Grid* grid, FlowField* flowField) : _grid(grid), _flowField(flowField), _numVisibleOverlay(0), _overlayDirty(false) {
+	int total = _grid->width * _grid->height;
+	_tiles = new Sprite[total];
+	_overlay = new Sprite[total];
+	_hasOverlay = new bool[total];
+	_visibleOverlay = new Sprite[total];
+	_changes = new int[GRID_CHANGE_LOG_SIZE];
+	for (int i = 0; i < total; ++i) {
+		buildTile(i);
+		_hasOverlay[i] = false;
+	}
+	_gridVersion = _grid->version;
+	if (_flowField != 0) {
+		for (int i = 0; i < total; ++i) {
+			buildOverlay(i);
+		}
+		_flowFieldVersion = _flowField->getVersion();
+		_overlayDirty = true;
+	}
+}
+
+// ---------------------------------------------------------------
+// dtor
+// ---------------------------------------------------------------
+TileLayer::~TileLayer() {
+	delete[] _changes;
+	delete[] _visibleOverlay;
+	delete[] _hasOverlay;
+	delete[] _overlay;
+	delete[] _tiles;
+}
+
+// ---------------------------------------------------------------
+// build the tile sprite of one cell
+// ---------------------------------------------------------------
+void TileLayer::buildTile(int index) {
+	int x = index % _grid->width;
+	int y = index / _grid->width;
+	ds::vec2 p = ds::vec2(START_X + x * 46, START_Y + 46 * y);
+	_tiles[index] = Sprite(p, GRID_TEXTURES[_grid->items[index]]);
+}
+
+// ---------------------------------------------------------------
+// build the direction sprite of one cell
+// ---------------------------------------------------------------
+void TileLayer::buildOverlay(int index) {
+	int x = index % _grid->width;
+	int y = index / _grid->width;
+	int d = _flowField->get(x, y);
+	bool visible = d >= 0 && d < 9;
+	if (visible) {
+		ds::vec2 p = ds::vec2(START_X + x * 46, START_Y + 46 * y);
+		_overlay[index] = Sprite(p, ds::vec4(d * 46, 138, 46, 46));
+	}
+	_hasOverlay[index] = visible;
+}
+
+// ---------------------------------------------------------------
+// regenerate the tiles of all cells changed in the grid
+// ---------------------------------------------------------------
+void TileLayer::updateTiles() {
+	if (_gridVersion == _grid->version) {
+		return;
+	}
+	int num = _grid->getChanges(_gridVersion, _changes, GRID_CHANGE_LOG_SIZE);
+	if (num == -1) {
+		int total = _grid->width * _grid->height;
+		for (int i = 0; i < total; ++i) {
+			buildTile(i);
+		}
+	}
+	else {
+		for (int i = 0; i < num; ++i) {
+			buildTile(_changes[i]);
+		}
+	}
+	_gridVersion = _grid->version;
+}
+
+// ---------------------------------------------------------------
+// regenerate the directions changed by the last flow field build
+// ---------------------------------------------------------------
+void TileLayer::updateOverlay() {
+	uint32_t version = _flowField->getVersion();
+	if (_flowFieldVersion != version) {
+		if (version - _flowFieldVersion == 1) {
+			const int* changed = 0;
+			int num = _flowField->getChanged(&changed);
+			for (int i = 0; i < num; ++i) {
+				buildOverlay(changed[i]);
+			}
+		}
+		else {
+			int total = _grid->width * _grid->height;
+			for (int i = 0; i < total; ++i) {
+				buildOverlay(i);
+			}
+		}
+		_flowFieldVersion = version;
+		_overlayDirty = true;
+	}
+	if (_overlayDirty) {
+		int total = _grid->width * _grid->height;
+		_numVisibleOverlay = 0;
+		for (int i = 0; i < total; ++i) {
+			if (_hasOverlay[i]) {
+				_visibleOverlay[_numVisibleOverlay++] = _overlay[i];
+			}
+		}
+		_overlayDirty = false;
+	}
+}
+
+// ---------------------------------------------------------------
+// set flow field - the change list of another field does not
+// relate to the overlay so everything is rebuilt
+// ---------------------------------------------------------------
+void TileLayer::setFlowField(FlowField* flowField) {
+	if (flowField == _flowField) {
+		return;
+	}
+	_flowField = flowField;
+	if (_flowField != 0) {
+		int total = _grid->width * _grid->height;
+		for (int i = 0; i < total; ++i) {
+			buildOverlay(i);
+		}
+		_flowFieldVersion = _flowField->getVersion();
+		_overlayDirty = true;
+	}
+}
+
+// ---------------------------------------------------------------
+// render
+// ---------------------------------------------------------------
+void TileLayer::render(SpriteBatchBuffer* buffer, bool showOverlay) {
+	updateTiles();
+	buffer->add(_tiles, _grid->width * _grid->height);
+	if (showOverlay && _flowField != 0) {
+		updateOverlay();
+		if (_numVisibleOverlay > 0) {
+			buffer->add(_visibleOverlay, _numVisibleOverlay);
+		}
+	}
+}
@@ -0,0 +1,39 @@
+#pragma once
+#include "Grid.h"
+
+class FlowField;
+class SpriteBatchBuffer;
+struct Sprite;
+
+// ---------------------------------------------------------------
+// TileLayer
+//
+// Keeps prebuilt sprites for the static grid tiles and the
+// flow field overlay. Only the cells reported as changed by the
+// grid or the flow field are regenerated. Rendering is a bulk
+// copy into the sprite batch buffer.
+// ---------------------------------------------------------------
+class TileLayer {
+
+public:
+	TileLayer(Grid* grid, FlowField* flowField = 0);
+	~TileLayer();
+	void render(SpriteBatchBuffer* buffer, bool showOverlay = false);
+	void setFlowField(FlowField* flowField);
+private:
+	void updateTiles();
+	void updateOverlay();
+	void buildTile(int index);
+	void buildOverlay(int index);
+	Grid* _grid;
+	FlowField* _flowField;
+	Sprite* _tiles;
+	Sprite* _overlay;
+	bool* _hasOverlay;
+	Sprite* _visibleOverlay;
+	int _numVisibleOverlay;
+	bool _overlayDirty;
+	int* _changes;
+	uint32_t _gridVersion;
+	uint32_t _flowFieldVersion;
+};
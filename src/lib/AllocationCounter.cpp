@@ -0,0 +1,74 @@
+#include "AllocationCounter.h"
+#include <stdlib.h>
+#include <atomic>
+#include <new>
+
+static std::atomic<uint64_t> g_NumAllocations(0);
+static std::atomic<uint64_t> g_NumAllocatedBytes(0);
+
+// ---------------------------------------------------------------
+// count and forward to malloc
+// ---------------------------------------------------------------
+static void* countedAlloc(size_t size) {
+	g_NumAllocations.fetch_add(1, std::memory_order_relaxed);
+	g_NumAllocatedBytes.fetch_add(size, std::memory_order_relaxed);
+	void* p = malloc(size > 0 ? size : 1);
+	if (p == 0) {
+		throw std::bad_alloc();
+	}
+	return p;
+}
+
+void* operator new(size_t size) {
+	return countedAlloc(size);
+}
+
+void* operator new[](size_t size) {
+	return countedAlloc(size);
+}
+
+void* operator new(size_t size, const std::nothrow_t&) noexcept {
+	g_NumAllocations.fetch_add(1, std::memory_order_relaxed);
+	g_NumAllocatedBytes.fetch_add(size, std::memory_order_relaxed);
+	return malloc(size > 0 ? size : 1);
+}
+
+void* operator new[](size_t size, const std::nothrow_t&) noexcept {
+	return operator new(size, std::nothrow);
+}
+
+void operator delete(void* p) noexcept {
+	free(p);
+}
+
+void operator delete[](void* p) noexcept {
+	free(p);
+}
+
+void operator delete(void* p, size_t size) noexcept {
+	free(p);
+}
+
+void operator delete[](void* p, size_t size) noexcept {
+	free(p);
+}
+
+void operator delete(void* p, const std::nothrow_t&) noexcept {
+	free(p);
+}
+
+void operator delete[](void* p, const std::nothrow_t&) noexcept {
+	free(p);
+}
+
+namespace ds {
+
+	uint64_t getNumAllocations() {
+		return g_NumAllocations.load(std::memory_order_relaxed);
+	}
+
+	uint64_t getNumAllocatedBytes() {
+		return g_NumAllocatedBytes.load(std::memory_order_relaxed);
+	}
+
+}
@@ -0,0 +1,17 @@
+#pragma once
+#include <stdint.h>
+
+namespace ds {
+
+	// ---------------------------------------------------------------
+	// number of heap allocations since the start of the program.
+	// Counts every call of the global operator new.
+	// ---------------------------------------------------------------
+	uint64_t getNumAllocations();
+
+	// ---------------------------------------------------------------
+	// number of bytes requested by operator new
+	// ---------------------------------------------------------------
+	uint64_t getNumAllocatedBytes();
+
+}
@@ -20,6 +20,7 @@ namespace ds {
 	struct DataArray {
 
 		unsigned int numObjects;
+		unsigned int highWater;
 		Index indices[MAX_FLOW_OBJECTS];
 		U objects[MAX_FLOW_OBJECTS];
 		unsigned short free_enqueue;
@@ -31,6 +32,7 @@ namespace ds {
 
 		void clear() {
 			numObjects = 0;
+			highWater = 0;
 			for (unsigned short i = 0; i < MAX_FLOW_OBJECTS; ++i) {
 				indices[i].id = i;
 				indices[i].next = i + 1;
@@ -63,6 +65,9 @@ namespace ds {
 			Index &in = indices[free_dequeue];
 			free_dequeue = in.next;
 			in.index = numObjects++;
+			if (numObjects > highWater) {
+				highWater = numObjects;
+			}
 			U& o = objects[in.index];
 			o.id = in.id;
 			return o.id;
@@ -71,7 +76,6 @@ namespace ds {
 		void remove(ID id) {
 			Index &in = indices[id & INDEX_MASK];
 			assert(in.index != USHRT_MAX);
-			int current = in.index;
 			U& o = objects[in.index];
 			o = objects[--numObjects];
 			indices[o.id & INDEX_MASK].index = in.index;
@@ -0,0 +1,119 @@
+#include "JobSystem.h"
+#include <ds_profiler.h>
+#include <stdio.h>
+
+namespace ds {
+
+	// ---------------------------------------------------------------
+	// ctor - a negative number of workers uses all cores
+	// ---------------------------------------------------------------
+	JobSystem::JobSystem(int numWorkers) : _function(0), _count(0), _chunkSize(0), _numChunks(0), _nextChunk(0), _finishedChunks(0), _generation(0), _activeWorkers(0), _running(true) {
+		if (numWorkers < 0) {
+			numWorkers = static_cast<int>(std::thread::hardware_concurrency()) - 1;
+			if (numWorkers < 0) {
+				numWorkers = 0;
+			}
+		}
+		for (int i = 0; i < numWorkers; ++i) {
+			_threads.push_back(std::thread(&JobSystem::run, this, i + 1));
+		}
+	}
+
+	// ---------------------------------------------------------------
+	// dtor
+	// ---------------------------------------------------------------
+	JobSystem::~JobSystem() {
+		{
+			std::lock_guard<std::mutex> lock(_mutex);
+			_running = false;
+		}
+		_wakeUp.notify_all();
+		for (size_t i = 0; i < _threads.size(); ++i) {
+			_threads[i].join();
+		}
+	}
+
+	// ---------------------------------------------------------------
+	// execute chunks until there are none left
+	// ---------------------------------------------------------------
+	void JobSystem::execute(int worker) {
+		int chunk = _nextChunk.fetch_add(1);
+		while (chunk < _numChunks) {
+			int begin = chunk * _chunkSize;
+			int end = begin + _chunkSize;
+			if (end > _count) {
+				end = _count;
+			}
+			{
+				PERF_ZONE("JobSystem::chunk");
+				(*_function)(begin, end, worker);
+			}
+			_finishedChunks.fetch_add(1);
+			chunk = _nextChunk.fetch_add(1);
+		}
+	}
+
+	// ---------------------------------------------------------------
+	// worker thread
+	// ---------------------------------------------------------------
+	void JobSystem::run(int worker) {
+		char name[32];
+		sprintf(name, "worker %d", worker);
+		perf::setThreadName(name);
+		uint32_t generation = 0;
+		for (;;) {
+			{
+				std::unique_lock<std::mutex> lock(_mutex);
+				_wakeUp.wait(lock, [&] { return !_running || _generation != generation; });
+				if (!_running) {
+					return;
+				}
+				generation = _generation;
+				++_activeWorkers;
+			}
+			execute(worker);
+			{
+				std::lock_guard<std::mutex> lock(_mutex);
+				--_activeWorkers;
+			}
+			_done.notify_all();
+		}
+	}
+
+	// ---------------------------------------------------------------
+	// run fn(begin, end, worker) for all chunks of [0, count)
+	// ---------------------------------------------------------------
+	void JobSystem::parallelFor(int count, int chunkSize, const RangeFunction& fn) {
+		if (count <= 0) {
+			return;
+		}
+		if (chunkSize < 1) {
+			chunkSize = 1;
+		}
+		if (_threads.empty() || count <= chunkSize) {
+			for (int begin = 0; begin < count; begin += chunkSize) {
+				int end = begin + chunkSize;
+				fn(begin, end < count ? end : count, 0);
+			}
+			return;
+		}
+		{
+			// a worker might still be leaving the previous run
+			std::unique_lock<std::mutex> lock(_mutex);
+			_done.wait(lock, [&] { return _activeWorkers == 0; });
+			_function = &fn;
+			_count = count;
+			_chunkSize = chunkSize;
+			_numChunks = (count + chunkSize - 1) / chunkSize;
+			_nextChunk = 0;
+			_finishedChunks = 0;
+			++_generation;
+		}
+		_wakeUp.notify_all();
+		execute(0);
+		std::unique_lock<std::mutex> lock(_mutex);
+		_done.wait(lock, [&] { return _finishedChunks.load() == _numChunks && _activeWorkers == 0; });
+		_function = 0;
+	}
+
+}
@@ -0,0 +1,49 @@
+#pragma once
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <functional>
+#include <vector>
+#include <stdint.h>
+
+namespace ds {
+
+	// ---------------------------------------------------------------
+	// JobSystem
+	//
+	// Small fixed thread pool. parallelFor splits a range into chunks
+	// and blocks until every chunk is done. The calling thread works
+	// on chunks as well and always has the worker index 0.
+	// ---------------------------------------------------------------
+	class JobSystem {
+
+		typedef std::function<void(int, int, int)> RangeFunction;
+
+	public:
+		JobSystem(int numWorkers = -1);
+		~JobSystem();
+		int getNumThreads() const {
+			return static_cast<int>(_threads.size()) + 1;
+		}
+		void parallelFor(int count, int chunkSize, const RangeFunction& fn);
+	private:
+		void run(int worker);
+		void execute(int worker);
+		JobSystem(const JobSystem& orig) {}
+		std::vector<std::thread> _threads;
+		std::mutex _mutex;
+		std::condition_variable _wakeUp;
+		std::condition_variable _done;
+		const RangeFunction* _function;
+		int _count;
+		int _chunkSize;
+		int _numChunks;
+		std::atomic<int> _nextChunk;
+		std::atomic<int> _finishedChunks;
+		uint32_t _generation;
+		int _activeWorkers;
+		bool _running;
+	};
+
+}
@@ -0,0 +1,84 @@
+#include "LinearArena.h"
+#include <assert.h>
+
+namespace ds {
+
+	// ---------------------------------------------------------------
+	// ctor
+	// ---------------------------------------------------------------
+	LinearArena::LinearArena(size_t size) : _current(0), _offset(0), _highWater(0) {
+		for (int i = 0; i < MAX_ARENA_BLOCKS; ++i) {
+			_blocks[i] = 0;
+			_sizes[i] = 0;
+		}
+		_blocks[0] = new char[size];
+		_sizes[0] = size;
+	}
+
+	// ---------------------------------------------------------------
+	// dtor
+	// ---------------------------------------------------------------
+	LinearArena::~LinearArena() {
+		for (int i = 0; i < MAX_ARENA_BLOCKS; ++i) {
+			delete[] _blocks[i];
+		}
+	}
+
+	// ---------------------------------------------------------------
+	// alloc - moves on to the next block if the current one is full
+	// ---------------------------------------------------------------
+	void* LinearArena::alloc(size_t size, size_t alignment) {
+		for (;;) {
+			uintptr_t base = reinterpret_cast<uintptr_t>(_blocks[_current]);
+			uintptr_t aligned = (base + _offset + alignment - 1) & ~(static_cast<uintptr_t>(alignment) - 1);
+			size_t end = aligned - base + size;
+			if (end <= _sizes[_current]) {
+				_offset = end;
+				size_t used = _offset;
+				for (int i = 0; i < _current; ++i) {
+					used += _sizes[i];
+				}
+				if (used > _highWater) {
+					_highWater = used;
+				}
+				return reinterpret_cast<void*>(aligned);
+			}
+			assert(_current + 1 < MAX_ARENA_BLOCKS);
+			++_current;
+			_offset = 0;
+			if (_blocks[_current] != 0 && _sizes[_current] < size + alignment) {
+				// a block that is too small is replaced so it only happens once
+				delete[] _blocks[_current];
+				_blocks[_current] = 0;
+			}
+			if (_blocks[_current] == 0) {
+				size_t blockSize = _sizes[_current - 1] * 2;
+				if (blockSize < size + alignment) {
+					blockSize = size + alignment;
+				}
+				_blocks[_current] = new char[blockSize];
+				_sizes[_current] = blockSize;
+			}
+		}
+	}
+
+	// ---------------------------------------------------------------
+	// capacity of all blocks
+	// ---------------------------------------------------------------
+	size_t LinearArena::getCapacity() const {
+		size_t ret = 0;
+		for (int i = 0; i < MAX_ARENA_BLOCKS; ++i) {
+			ret += _sizes[i];
+		}
+		return ret;
+	}
+
+	// ---------------------------------------------------------------
+	// thread arena
+	// ---------------------------------------------------------------
+	LinearArena* getThreadArena() {
+		static thread_local LinearArena arena(256 * 1024);
+		return &arena;
+	}
+
+}
@@ -0,0 +1,84 @@
+#pragma once
+#include <stddef.h>
+#include <stdint.h>
+
+namespace ds {
+
+	const int MAX_ARENA_BLOCKS = 24;
+
+	// ---------------------------------------------------------------
+	// position inside an arena that can be rewound to
+	// ---------------------------------------------------------------
+	struct ArenaMarker {
+		int block;
+		size_t offset;
+	};
+
+	// ---------------------------------------------------------------
+	// LinearArena
+	//
+	// Bump allocator for transient data. Memory is handed out from a
+	// chain of blocks where every new block is twice as large as the
+	// previous one. Rewinding or resetting keeps the blocks, so once
+	// the arena has seen the largest request no more heap allocations
+	// are made.
+	// ---------------------------------------------------------------
+	class LinearArena {
+
+	public:
+		LinearArena(size_t size = 64 * 1024);
+		~LinearArena();
+		void* alloc(size_t size, size_t alignment = 16);
+		template<class T>
+		T* allocArray(int num) {
+			return static_cast<T*>(alloc(num * sizeof(T), alignof(T)));
+		}
+		ArenaMarker getMarker() const {
+			ArenaMarker m = { _current, _offset };
+			return m;
+		}
+		void rewind(const ArenaMarker& marker) {
+			_current = marker.block;
+			_offset = marker.offset;
+		}
+		void reset() {
+			_current = 0;
+			_offset = 0;
+		}
+		size_t getHighWater() const {
+			return _highWater;
+		}
+		size_t getCapacity() const;
+	private:
+		LinearArena(const LinearArena& orig) {}
+		char* _blocks[MAX_ARENA_BLOCKS];
+		size_t _sizes[MAX_ARENA_BLOCKS];
+		int _current;
+		size_t _offset;
+		size_t _highWater;
+	};
+
+	// ---------------------------------------------------------------
+	// ArenaScope - everything allocated inside the scope is released
+	// when it is destroyed
+	// ---------------------------------------------------------------
+	class ArenaScope {
+
+	public:
+		ArenaScope(LinearArena* arena) : _arena(arena), _marker(arena->getMarker()) {}
+		~ArenaScope() {
+			_arena->rewind(_marker);
+		}
+	private:
+		ArenaScope(const ArenaScope& orig) {}
+		LinearArena* _arena;
+		ArenaMarker _marker;
+	};
+
+	// ---------------------------------------------------------------
+	// arena of the calling thread. It is created on first use so
+	// every worker gets its own one.
+	// ---------------------------------------------------------------
+	LinearArena* getThreadArena();
+
+}
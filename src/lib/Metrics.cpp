@@ -0,0 +1,173 @@
+#include "Metrics.h"
+#include <stdio.h>
+#include <string.h>
+#include <assert.h>
+#include <algorithm>
+
+namespace ds {
+
+	// ---------------------------------------------------------------
+	// ctor
+	// ---------------------------------------------------------------
+	Metrics::Metrics() : _num(0), _frame(0) {
+		add("frame_ms", MetricType::TIMER);
+	}
+
+	// ---------------------------------------------------------------
+	// add - returns the existing id if the name is already known
+	// ---------------------------------------------------------------
+	int Metrics::add(const char* name, MetricType::Enum type) {
+		int idx = find(name);
+		if (idx != -1) {
+			return idx;
+		}
+		assert(_num < MAX_METRICS);
+		Metric& m = _metrics[_num];
+		strncpy(m.name, name, sizeof(m.name) - 1);
+		m.name[sizeof(m.name) - 1] = '\0';
+		m.type = type;
+		m.current = 0.0f;
+		for (int i = 0; i < METRICS_HISTORY_SIZE; ++i) {
+			m.history[i] = 0.0f;
+		}
+		return _num++;
+	}
+
+	// ---------------------------------------------------------------
+	// find by name
+	// ---------------------------------------------------------------
+	int Metrics::find(const char* name) const {
+		for (int i = 0; i < _num; ++i) {
+			if (strcmp(_metrics[i].name, name) == 0) {
+				return i;
+			}
+		}
+		return -1;
+	}
+
+	// ---------------------------------------------------------------
+	// end frame - store the current values and reset counters
+	// and timers
+	// ---------------------------------------------------------------
+	void Metrics::endFrame(float dt) {
+		_metrics[FRAME_TIME_METRIC].current = dt * 1000.0f;
+		int slot = _frame % METRICS_HISTORY_SIZE;
+		for (int i = 0; i < _num; ++i) {
+			Metric& m = _metrics[i];
+			m.history[slot] = m.current;
+			if (m.type != MetricType::GAUGE) {
+				m.current = 0.0f;
+			}
+		}
+		++_frame;
+	}
+
+	// ---------------------------------------------------------------
+	// number of frames in the history
+	// ---------------------------------------------------------------
+	int Metrics::getNumFrames() const {
+		return _frame < METRICS_HISTORY_SIZE ? static_cast<int>(_frame) : METRICS_HISTORY_SIZE;
+	}
+
+	// ---------------------------------------------------------------
+	// value of the last finished frame
+	// ---------------------------------------------------------------
+	float Metrics::getLast(int id) const {
+		if (_frame == 0) {
+			return 0.0f;
+		}
+		return _metrics[id].history[(_frame - 1) % METRICS_HISTORY_SIZE];
+	}
+
+	// ---------------------------------------------------------------
+	// history - oldest value first
+	// ---------------------------------------------------------------
+	int Metrics::getHistory(int id, float* values, int max) const {
+		int num = getNumFrames();
+		if (num > max) {
+			num = max;
+		}
+		const Metric& m = _metrics[id];
+		for (int i = 0; i < num; ++i) {
+			values[i] = m.history[(_frame - num + i) % METRICS_HISTORY_SIZE];
+		}
+		return num;
+	}
+
+	// ---------------------------------------------------------------
+	// average over the history
+	// ---------------------------------------------------------------
+	float Metrics::getAverage(int id) const {
+		int num = getNumFrames();
+		if (num == 0) {
+			return 0.0f;
+		}
+		float sum = 0.0f;
+		for (int i = 0; i < num; ++i) {
+			sum += _metrics[id].history[i];
+		}
+		return sum / num;
+	}
+
+	// ---------------------------------------------------------------
+	// max over the history
+	// ---------------------------------------------------------------
+	float Metrics::getMax(int id) const {
+		int num = getNumFrames();
+		float ret = 0.0f;
+		for (int i = 0; i < num; ++i) {
+			if (i == 0 || _metrics[id].history[i] > ret) {
+				ret = _metrics[id].history[i];
+			}
+		}
+		return ret;
+	}
+
+	// ---------------------------------------------------------------
+	// percentile (0 - 100) over the history
+	// ---------------------------------------------------------------
+	float Metrics::getPercentile(int id, float percent) const {
+		int num = getNumFrames();
+		if (num == 0) {
+			return 0.0f;
+		}
+		float values[METRICS_HISTORY_SIZE];
+		memcpy(values, _metrics[id].history, num * sizeof(float));
+		int k = static_cast<int>(percent / 100.0f * (num - 1) + 0.5f);
+		if (k < 0) {
+			k = 0;
+		}
+		if (k >= num) {
+			k = num - 1;
+		}
+		std::nth_element(values, values + k, values + num);
+		return values[k];
+	}
+
+	// ---------------------------------------------------------------
+	// save the history as CSV - one row per frame
+	// ---------------------------------------------------------------
+	bool Metrics::saveCSV(const char* fileName) const {
+		FILE* fp = fopen(fileName, "w");
+		if (fp == 0) {
+			return false;
+		}
+		fprintf(fp, "frame");
+		for (int i = 0; i < _num; ++i) {
+			fprintf(fp, ",%s", _metrics[i].name);
+		}
+		fprintf(fp, "\n");
+		int num = getNumFrames();
+		for (int f = 0; f < num; ++f) {
+			uint32_t frame = _frame - num + f;
+			fprintf(fp, "%u", frame);
+			for (int i = 0; i < _num; ++i) {
+				fprintf(fp, ",%g", _metrics[i].history[frame % METRICS_HISTORY_SIZE]);
+			}
+			fprintf(fp, "\n");
+		}
+		fclose(fp);
+		return true;
+	}
+
+}
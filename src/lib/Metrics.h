@@ -0,0 +1,99 @@
+#pragma once
+#include <stdint.h>
+#include <chrono>
+
+namespace ds {
+
+	// ---------------------------------------------------------------
+	// Counters are summed up and reset every frame, gauges keep
+	// the last value that was set and timers sum up milliseconds
+	// per frame.
+	// ---------------------------------------------------------------
+	struct MetricType {
+
+		enum Enum {
+			COUNTER,
+			GAUGE,
+			TIMER
+		};
+	};
+
+	const int MAX_METRICS = 32;
+	const int METRICS_HISTORY_SIZE = 256;
+
+	// the frame time is always registered as the first metric
+	const int FRAME_TIME_METRIC = 0;
+
+	// ---------------------------------------------------------------
+	// Metrics
+	//
+	// Registry of named values. endFrame pushes the values of the
+	// current frame into a history of the last METRICS_HISTORY_SIZE
+	// frames. Averages and percentiles are calculated from this
+	// history. All calls are expected from the main thread.
+	// ---------------------------------------------------------------
+	class Metrics {
+
+		struct Metric {
+			char name[32];
+			MetricType::Enum type;
+			float current;
+			float history[METRICS_HISTORY_SIZE];
+		};
+
+	public:
+		Metrics();
+		int add(const char* name, MetricType::Enum type);
+		int find(const char* name) const;
+		void increment(int id, float v = 1.0f) {
+			_metrics[id].current += v;
+		}
+		void set(int id, float v) {
+			_metrics[id].current = v;
+		}
+		void addTime(int id, float ms) {
+			_metrics[id].current += ms;
+		}
+		void endFrame(float dt);
+		int num() const {
+			return _num;
+		}
+		const char* getName(int id) const {
+			return _metrics[id].name;
+		}
+		MetricType::Enum getType(int id) const {
+			return _metrics[id].type;
+		}
+		int getNumFrames() const;
+		float getLast(int id) const;
+		float getAverage(int id) const;
+		float getMax(int id) const;
+		float getPercentile(int id, float percent) const;
+		int getHistory(int id, float* values, int max) const;
+		bool saveCSV(const char* fileName) const;
+	private:
+		Metrics(const Metrics& orig) {}
+		Metric _metrics[MAX_METRICS];
+		int _num;
+		uint32_t _frame;
+	};
+
+	// ---------------------------------------------------------------
+	// adds the time between construction and destruction to a timer
+	// ---------------------------------------------------------------
+	class MetricTimer {
+
+		typedef std::chrono::steady_clock Clock;
+
+	public:
+		MetricTimer(Metrics* metrics, int id) : _metrics(metrics), _id(id), _start(Clock::now()) {}
+		~MetricTimer() {
+			_metrics->addTime(_id, std::chrono::duration<float, std::milli>(Clock::now() - _start).count());
+		}
+	private:
+		Metrics* _metrics;
+		int _id;
+		Clock::time_point _start;
+	};
+
+}
@@ -0,0 +1,36 @@
+#pragma once
+#include <stdint.h>
+
+namespace ds {
+
+	// ---------------------------------------------------------------
+	// Random
+	//
+	// Small xorshift generator. Unlike ds::random the sequence only
+	// depends on the seed so it can be reproduced by a replay.
+	// ---------------------------------------------------------------
+	class Random {
+
+	public:
+		Random(uint32_t seed = 0x9E3779B9) {
+			setSeed(seed);
+		}
+		void setSeed(uint32_t seed) {
+			_state = seed != 0 ? seed : 0x9E3779B9;
+		}
+		uint32_t next() {
+			_state ^= _state << 13;
+			_state ^= _state >> 17;
+			_state ^= _state << 5;
+			return _state;
+		}
+		// returns a value in [min, max)
+		float next(float min, float max) {
+			float r = static_cast<float>(next() >> 8) * (1.0f / 16777216.0f);
+			return min + (max - min) * r;
+		}
+	private:
+		uint32_t _state;
+	};
+
+}
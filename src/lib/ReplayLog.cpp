@@ -0,0 +1,169 @@
+#include "ReplayLog.h"
+#include <stdio.h>
+#include <string.h>
+
+namespace ds {
+
+	// ---------------------------------------------------------------
+	// ctor
+	// ---------------------------------------------------------------
+	ReplayLog::ReplayLog() : _data(0), _size(0), _capacity(0), _readPos(0), _seed(0), _numTicks(0), _currentTick(0) {
+	}
+
+	// ---------------------------------------------------------------
+	// dtor
+	// ---------------------------------------------------------------
+	ReplayLog::~ReplayLog() {
+		delete[] _data;
+	}
+
+	// ---------------------------------------------------------------
+	// start - drops all ticks and starts a new log
+	// ---------------------------------------------------------------
+	void ReplayLog::start(uint32_t seed) {
+		_seed = seed;
+		_size = 0;
+		_numTicks = 0;
+		rewind();
+	}
+
+	// ---------------------------------------------------------------
+	// write - the buffer grows by doubling
+	// ---------------------------------------------------------------
+	void ReplayLog::write(const void* data, int size) {
+		if (_size + size > _capacity) {
+			int capacity = _capacity == 0 ? 4096 : _capacity * 2;
+			while (capacity < _size + size) {
+				capacity *= 2;
+			}
+			uint8_t* tmp = new uint8_t[capacity];
+			if (_data != 0) {
+				memcpy(tmp, _data, _size);
+				delete[] _data;
+			}
+			_data = tmp;
+			_capacity = capacity;
+		}
+		memcpy(_data + _size, data, size);
+		_size += size;
+	}
+
+	// ---------------------------------------------------------------
+	// read
+	// ---------------------------------------------------------------
+	bool ReplayLog::read(void* data, int size) {
+		if (_readPos + size > _size) {
+			return false;
+		}
+		memcpy(data, _data + _readPos, size);
+		_readPos += size;
+		return true;
+	}
+
+	// ---------------------------------------------------------------
+	// record tick - only the first MAX_REPLAY_COMMANDS commands
+	// are stored
+	// ---------------------------------------------------------------
+	void ReplayLog::recordTick(float dt, const ReplayCommand* commands, int num) {
+		// the count is stored in one byte and must match the payload
+		if (num > MAX_REPLAY_COMMANDS) {
+			num = MAX_REPLAY_COMMANDS;
+		}
+		uint8_t n = static_cast<uint8_t>(num);
+		write(&dt, sizeof(float));
+		write(&n, sizeof(uint8_t));
+		for (int i = 0; i < num; ++i) {
+			const ReplayCommand& cmd = commands[i];
+			write(&cmd.type, sizeof(uint8_t));
+			write(&cmd.index, sizeof(uint8_t));
+			write(&cmd.x, sizeof(int16_t));
+			write(&cmd.y, sizeof(int16_t));
+			write(&cmd.value, sizeof(float));
+		}
+		++_numTicks;
+	}
+
+	// ---------------------------------------------------------------
+	// rewind
+	// ---------------------------------------------------------------
+	void ReplayLog::rewind() {
+		_readPos = 0;
+		_currentTick = 0;
+	}
+
+	// ---------------------------------------------------------------
+	// next tick - commands must hold MAX_REPLAY_COMMANDS entries.
+	// Returns false at the end of the log.
+	// ---------------------------------------------------------------
+	bool ReplayLog::nextTick(float* dt, ReplayCommand* commands, int* num) {
+		uint8_t n = 0;
+		if (!read(dt, sizeof(float)) || !read(&n, sizeof(uint8_t))) {
+			return false;
+		}
+		for (int i = 0; i < n; ++i) {
+			ReplayCommand& cmd = commands[i];
+			if (!read(&cmd.type, sizeof(uint8_t)) || !read(&cmd.index, sizeof(uint8_t)) || !read(&cmd.x, sizeof(int16_t)) || !read(&cmd.y, sizeof(int16_t)) || !read(&cmd.value, sizeof(float))) {
+				return false;
+			}
+		}
+		*num = n;
+		++_currentTick;
+		return true;
+	}
+
+	// ---------------------------------------------------------------
+	// save
+	// ---------------------------------------------------------------
+	bool ReplayLog::save(const char* fileName) const {
+		FILE* fp = fopen(fileName, "wb");
+		if (fp == 0) {
+			return false;
+		}
+		uint16_t version = REPLAY_VERSION;
+		uint16_t reserved = 0;
+		fwrite(&REPLAY_MAGIC, sizeof(uint32_t), 1, fp);
+		fwrite(&version, sizeof(uint16_t), 1, fp);
+		fwrite(&reserved, sizeof(uint16_t), 1, fp);
+		fwrite(&_seed, sizeof(uint32_t), 1, fp);
+		fwrite(&_numTicks, sizeof(uint32_t), 1, fp);
+		if (_size > 0) {
+			fwrite(_data, 1, _size, fp);
+		}
+		fclose(fp);
+		return true;
+	}
+
+	// ---------------------------------------------------------------
+	// load
+	// ---------------------------------------------------------------
+	bool ReplayLog::load(const char* fileName) {
+		FILE* fp = fopen(fileName, "rb");
+		if (fp == 0) {
+			return false;
+		}
+		uint32_t magic = 0;
+		uint16_t version = 0;
+		uint16_t reserved = 0;
+		uint32_t seed = 0;
+		uint32_t numTicks = 0;
+		fread(&magic, sizeof(uint32_t), 1, fp);
+		fread(&version, sizeof(uint16_t), 1, fp);
+		fread(&reserved, sizeof(uint16_t), 1, fp);
+		fread(&seed, sizeof(uint32_t), 1, fp);
+		if (fread(&numTicks, sizeof(uint32_t), 1, fp) != 1 || magic != REPLAY_MAGIC || version != REPLAY_VERSION) {
+			fclose(fp);
+			return false;
+		}
+		start(seed);
+		uint8_t buffer[4096];
+		size_t read = fread(buffer, 1, sizeof(buffer), fp);
+		while (read > 0) {
+			write(buffer, static_cast<int>(read));
+			read = fread(buffer, 1, sizeof(buffer), fp);
+		}
+		fclose(fp);
+		_numTicks = numTicks;
+		return true;
+	}
+
+}
@@ -0,0 +1,71 @@
+#pragma once
+#include <stdint.h>
+
+namespace ds {
+
+	// ---------------------------------------------------------------
+	// One input command. The meaning of the fields is up to the
+	// game, the log only stores them.
+	// ---------------------------------------------------------------
+	struct ReplayCommand {
+		uint8_t type;
+		uint8_t index;
+		int16_t x;
+		int16_t y;
+		float value;
+	};
+
+	const uint32_t REPLAY_MAGIC = 0x50525344; // DSRP
+	// version 2: the battleground records its simulation options
+	const uint16_t REPLAY_VERSION = 2;
+	const int MAX_REPLAY_COMMANDS = 255;
+
+	// ---------------------------------------------------------------
+	// ReplayLog
+	//
+	// Binary log of the RNG seed and all commands per tick. Every
+	// tick is stored as the delta time followed by the number of
+	// commands and the commands itself. A tick without input costs
+	// 5 bytes.
+	//
+	// file layout:
+	// magic (4) version (2) reserved (2) seed (4) ticks (4)
+	// per tick: dt (4) num (1) num * [type (1) index (1) x (2) y (2) value (4)]
+	// ---------------------------------------------------------------
+	class ReplayLog {
+
+	public:
+		ReplayLog();
+		~ReplayLog();
+		void start(uint32_t seed);
+		void recordTick(float dt, const ReplayCommand* commands, int num);
+		void rewind();
+		bool nextTick(float* dt, ReplayCommand* commands, int* num);
+		bool save(const char* fileName) const;
+		bool load(const char* fileName);
+		uint32_t getSeed() const {
+			return _seed;
+		}
+		uint32_t getNumTicks() const {
+			return _numTicks;
+		}
+		uint32_t getCurrentTick() const {
+			return _currentTick;
+		}
+		int size() const {
+			return _size;
+		}
+	private:
+		ReplayLog(const ReplayLog& orig) {}
+		void write(const void* data, int size);
+		bool read(void* data, int size);
+		uint8_t* _data;
+		int _size;
+		int _capacity;
+		int _readPos;
+		uint32_t _seed;
+		uint32_t _numTicks;
+		uint32_t _currentTick;
+	};
+
+}
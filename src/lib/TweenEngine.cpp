@@ -0,0 +1,298 @@
+#include "TweenEngine.h"
+#include <ds_math.h>
+#include <ds_event_stream.h>
+#include <string.h>
+#include <math.h>
+#include <assert.h>
+#include <limits.h>
+
+namespace ds {
+
+	// ---------------------------------------------------------------
+	// The easing functions work on the normalized time n = [0,1].
+	// The simple ones can be vectorized by the compiler in advance.
+	// Bounce and elastic are the ds_tweening versions for start 0,
+	// end 1 and duration 1 written here so the engine does not
+	// depend on the renderer.
+	// ---------------------------------------------------------------
+	struct EaseLinear {
+		static float ease(float n) { return n; }
+	};
+
+	struct EaseSinus {
+		static float ease(float n) { return sinf(n * ds::PI); }
+	};
+
+	struct EaseInQuad {
+		static float ease(float n) { return n * n; }
+	};
+
+	struct EaseOutQuad {
+		static float ease(float n) { return -n * (n - 2.0f); }
+	};
+
+	struct EaseInOutQuad {
+		static float ease(float n) { return n < 0.5f ? 2.0f * n * n : -1.0f + (4.0f - 2.0f * n) * n; }
+	};
+
+	struct EaseInCubic {
+		static float ease(float n) { return n * n * n; }
+	};
+
+	struct EaseOutCubic {
+		static float ease(float n) { float m = n - 1.0f; return m * m * m + 1.0f; }
+	};
+
+	struct EaseInOutCubic {
+		static float ease(float n) { float m = 2.0f * n - 2.0f; return n < 0.5f ? 4.0f * n * n * n : 0.5f * m * m * m + 1.0f; }
+	};
+
+	struct EaseInBack {
+		static float ease(float n) { return n * n * (2.70158f * n - 1.70158f); }
+	};
+
+	struct EaseOutBack {
+		static float ease(float n) { float m = n - 1.0f; return m * m * (2.70158f * m + 1.70158f) + 1.0f; }
+	};
+
+	struct EaseOutBounce {
+		static float ease(float n) {
+			if (n < 1.0f / 2.75f) {
+				return 7.5625f * n * n;
+			}
+			if (n < 2.0f / 2.75f) {
+				n -= 1.5f / 2.75f;
+				return 7.5625f * n * n + 0.75f;
+			}
+			if (n < 2.5f / 2.75f) {
+				n -= 2.25f / 2.75f;
+				return 7.5625f * n * n + 0.9375f;
+			}
+			n -= 2.625f / 2.75f;
+			return 7.5625f * n * n + 0.984375f;
+		}
+	};
+
+	struct EaseOutElastic {
+		static float ease(float n) {
+			if (n == 0.0f || n == 1.0f) {
+				return n;
+			}
+			return powf(2.0f, -10.0f * n) * sinf((n - 0.075f) * (2.0f * ds::PI) / 0.3f) + 1.0f;
+		}
+	};
+
+	// ---------------------------------------------------------------
+	// ctor
+	// ---------------------------------------------------------------
+	TweenEngine::TweenEngine(int capacity, uint32_t eventType) : _capacity(capacity), _eventType(eventType) {
+		assert(capacity > 0 && capacity < USHRT_MAX);
+		memset(_groups, 0, sizeof(_groups));
+		_slots = new Slot[_capacity];
+		for (int i = 0; i < _capacity; ++i) {
+			_slots[i].id = i;
+			_slots[i].index = -1;
+		}
+		clear();
+	}
+
+	// ---------------------------------------------------------------
+	// dtor
+	// ---------------------------------------------------------------
+	TweenEngine::~TweenEngine() {
+		for (int i = 0; i < TweenEasing::NUM; ++i) {
+			Group& g = _groups[i];
+			delete[] g.start;
+			delete[] g.delta;
+			delete[] g.timer;
+			delete[] g.duration;
+			delete[] g.values;
+			delete[] g.targets;
+			delete[] g.ids;
+			delete[] g.userData;
+		}
+		delete[] _slots;
+	}
+
+	// ---------------------------------------------------------------
+	// clear - removes all tweens without sending events
+	// ---------------------------------------------------------------
+	void TweenEngine::clear() {
+		for (int i = 0; i < TweenEasing::NUM; ++i) {
+			_groups[i].num = 0;
+		}
+		for (int i = 0; i < _capacity; ++i) {
+			_slots[i].index = -1;
+			_slots[i].next = static_cast<uint16_t>(i + 1);
+		}
+		_freeList = 0;
+	}
+
+	// ---------------------------------------------------------------
+	// number of active tweens
+	// ---------------------------------------------------------------
+	int TweenEngine::num() const {
+		int ret = 0;
+		for (int i = 0; i < TweenEasing::NUM; ++i) {
+			ret += _groups[i].num;
+		}
+		return ret;
+	}
+
+	// ---------------------------------------------------------------
+	// grow the arrays of a group
+	// ---------------------------------------------------------------
+	template<class T>
+	static void resizeArray(T*& data, int num, int capacity) {
+		T* tmp = new T[capacity];
+		if (num > 0) {
+			memcpy(tmp, data, num * sizeof(T));
+		}
+		delete[] data;
+		data = tmp;
+	}
+
+	void TweenEngine::grow(Group& group) {
+		int capacity = group.capacity == 0 ? 64 : group.capacity * 2;
+		resizeArray(group.start, group.num, capacity);
+		resizeArray(group.delta, group.num, capacity);
+		resizeArray(group.timer, group.num, capacity);
+		resizeArray(group.duration, group.num, capacity);
+		resizeArray(group.values, group.num, capacity);
+		resizeArray(group.targets, group.num, capacity);
+		resizeArray(group.ids, group.num, capacity);
+		resizeArray(group.userData, group.num, capacity);
+		group.capacity = capacity;
+	}
+
+	// ---------------------------------------------------------------
+	// start a new tween
+	// ---------------------------------------------------------------
+	ID TweenEngine::start(float* target, float from, float to, float duration, TweenEasing::Enum easing, int userData) {
+		assert(_freeList < _capacity);
+		Slot& slot = _slots[_freeList];
+		_freeList = slot.next;
+		slot.id += NEW_OBJECT_ID_ADD;
+		Group& g = _groups[easing];
+		if (g.num == g.capacity) {
+			grow(g);
+		}
+		int idx = g.num++;
+		g.start[idx] = from;
+		g.delta[idx] = to - from;
+		g.timer[idx] = 0.0f;
+		g.duration[idx] = duration > 0.0f ? duration : 0.0001f;
+		g.targets[idx] = target;
+		g.ids[idx] = slot.id;
+		g.userData[idx] = userData;
+		slot.group = static_cast<uint16_t>(easing);
+		slot.index = idx;
+		*target = from;
+		return slot.id;
+	}
+
+	// ---------------------------------------------------------------
+	// is active
+	// ---------------------------------------------------------------
+	bool TweenEngine::isActive(ID id) const {
+		if (id == INVALID_ID) {
+			return false;
+		}
+		const Slot& slot = _slots[id & INDEX_MASK];
+		return slot.id == id && slot.index != -1;
+	}
+
+	// ---------------------------------------------------------------
+	// remove the tween at index by moving the last one into its place
+	// ---------------------------------------------------------------
+	void TweenEngine::remove(Group& group, int index) {
+		Slot& slot = _slots[group.ids[index] & INDEX_MASK];
+		slot.index = -1;
+		slot.next = _freeList;
+		_freeList = static_cast<uint16_t>(group.ids[index] & INDEX_MASK);
+		int last = --group.num;
+		if (index != last) {
+			group.start[index] = group.start[last];
+			group.delta[index] = group.delta[last];
+			group.timer[index] = group.timer[last];
+			group.duration[index] = group.duration[last];
+			group.values[index] = group.values[last];
+			group.targets[index] = group.targets[last];
+			group.ids[index] = group.ids[last];
+			group.userData[index] = group.userData[last];
+			_slots[group.ids[index] & INDEX_MASK].index = index;
+		}
+	}
+
+	// ---------------------------------------------------------------
+	// stop a tween without sending an event
+	// ---------------------------------------------------------------
+	void TweenEngine::stop(ID id) {
+		if (isActive(id)) {
+			const Slot& slot = _slots[id & INDEX_MASK];
+			remove(_groups[slot.group], slot.index);
+		}
+	}
+
+	// ---------------------------------------------------------------
+	// advance all tweens of one group
+	// ---------------------------------------------------------------
+	template<class E>
+	void TweenEngine::advance(Group& group, float dt) {
+		int num = group.num;
+		float* start = group.start;
+		float* delta = group.delta;
+		float* timer = group.timer;
+		float* duration = group.duration;
+		float* values = group.values;
+		for (int i = 0; i < num; ++i) {
+			float t = timer[i] + dt;
+			timer[i] = t;
+			float n = t / duration[i];
+			n = n < 1.0f ? n : 1.0f;
+			values[i] = start[i] + delta[i] * E::ease(n);
+		}
+		float** targets = group.targets;
+		for (int i = 0; i < num; ++i) {
+			*targets[i] = values[i];
+		}
+	}
+
+	// ---------------------------------------------------------------
+	// tick
+	// ---------------------------------------------------------------
+	void TweenEngine::tick(float dt, EventStream* events) {
+		advance<EaseLinear>(_groups[TweenEasing::LINEAR], dt);
+		advance<EaseSinus>(_groups[TweenEasing::SINUS], dt);
+		advance<EaseInQuad>(_groups[TweenEasing::IN_QUAD], dt);
+		advance<EaseOutQuad>(_groups[TweenEasing::OUT_QUAD], dt);
+		advance<EaseInOutQuad>(_groups[TweenEasing::IN_OUT_QUAD], dt);
+		advance<EaseInCubic>(_groups[TweenEasing::IN_CUBIC], dt);
+		advance<EaseOutCubic>(_groups[TweenEasing::OUT_CUBIC], dt);
+		advance<EaseInOutCubic>(_groups[TweenEasing::IN_OUT_CUBIC], dt);
+		advance<EaseInBack>(_groups[TweenEasing::IN_BACK], dt);
+		advance<EaseOutBack>(_groups[TweenEasing::OUT_BACK], dt);
+		advance<EaseOutBounce>(_groups[TweenEasing::OUT_BOUNCE], dt);
+		advance<EaseOutElastic>(_groups[TweenEasing::OUT_ELASTIC], dt);
+		//
+		// remove finished tweens
+		//
+		for (int i = 0; i < TweenEasing::NUM; ++i) {
+			Group& g = _groups[i];
+			int j = 0;
+			while (j < g.num) {
+				if (g.timer[j] >= g.duration[j]) {
+					if (events != 0) {
+						TweenEvent event = { g.ids[j], g.userData[j] };
+						events->add(_eventType, &event, sizeof(TweenEvent));
+					}
+					remove(g, j);
+				}
+				else {
+					++j;
+				}
+			}
+		}
+	}
+
+}
@@ -0,0 +1,91 @@
+#pragma once
+#include <stdint.h>
+#include "DataArray.h"
+
+namespace ds {
+
+	class EventStream;
+
+	// ---------------------------------------------------------------
+	// easing functions supported by the tween engine
+	// ---------------------------------------------------------------
+	struct TweenEasing {
+
+		enum Enum {
+			LINEAR,
+			SINUS,
+			IN_QUAD,
+			OUT_QUAD,
+			IN_OUT_QUAD,
+			IN_CUBIC,
+			OUT_CUBIC,
+			IN_OUT_CUBIC,
+			IN_BACK,
+			OUT_BACK,
+			OUT_BOUNCE,
+			OUT_ELASTIC,
+			NUM
+		};
+	};
+
+	// ---------------------------------------------------------------
+	// payload of the event sent when a tween has finished
+	// ---------------------------------------------------------------
+	struct TweenEvent {
+		ID id;
+		int userData;
+	};
+
+	// ---------------------------------------------------------------
+	// TweenEngine
+	//
+	// Stores all active tweens as SoA arrays with one group per
+	// easing function. tick advances every group in one pass that
+	// calls its easing function directly and writes the results
+	// into the target floats. Finished tweens are removed and
+	// reported as events.
+	// ---------------------------------------------------------------
+	class TweenEngine {
+
+		struct Group {
+			float* start;
+			float* delta;
+			float* timer;
+			float* duration;
+			float* values;
+			float** targets;
+			ID* ids;
+			int* userData;
+			int num;
+			int capacity;
+		};
+
+		struct Slot {
+			ID id;
+			uint16_t group;
+			uint16_t next;
+			int index;
+		};
+
+	public:
+		TweenEngine(int capacity = 4096, uint32_t eventType = 0);
+		~TweenEngine();
+		ID start(float* target, float from, float to, float duration, TweenEasing::Enum easing = TweenEasing::LINEAR, int userData = 0);
+		bool isActive(ID id) const;
+		void stop(ID id);
+		void clear();
+		void tick(float dt, EventStream* events = 0);
+		int num() const;
+	private:
+		template<class E> void advance(Group& group, float dt);
+		void grow(Group& group);
+		void remove(Group& group, int index);
+		TweenEngine(const TweenEngine& orig) {}
+		Group _groups[TweenEasing::NUM];
+		Slot* _slots;
+		int _capacity;
+		uint16_t _freeList;
+		uint32_t _eventType;
+	};
+
+}
@@ -12,6 +12,8 @@
 #include <ds_tweening.h>
 #define DS_IMGUI_IMPLEMENTATION
 #include <ds_imgui.h>
+#define DS_PROFILER_IMPLEMENTATION
+#include <ds_profiler.h>
 #define BASE_APP_IMPLEMENTATION
 #include <ds_base_app.h>
 
@@ -1,19 +1,24 @@
 #include "CSVFile.h"
-#include <fstream>
+#include "../lib/LinearArena.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
 #include <assert.h>
+#include <new>
 
 // ------------------------------------------------------
 // CSVLine
 // ------------------------------------------------------
-TextLine::TextLine(const std::string& str) : _delimiter(',') {
-	set(str);
+TextLine::TextLine(const char* str, int length, const char delimiter) {
+	set(str, length, delimiter);
 }
 
-void TextLine::set(const std::string& str,const char delimiter) {
+void TextLine::set(const char* str, int length, const char delimiter) {
 	_content = str;
+	_length = length;
 	_num_delimiters = 0;
 	_delimiter = delimiter;
-	for ( int i = 0; i < _content.length();++i ) {
+	for ( int i = 0; i < _length;++i ) {
 		if ( _content[i] == delimiter ) {
 			++_num_delimiters;
 		}
@@ -25,7 +30,7 @@ int TextLine::num_tokens() const {
 }
 
 void TextLine::print() const {
-	printf("%s\n", _content.c_str());
+	printf("%s\n", _content);
 }
 // ------------------------------------------------------
 // find pos in string for field index
@@ -35,7 +40,7 @@ int TextLine::find_pos(int field_index) const {
 		return 0;
 	}
 	int cnt = 0;
-	for ( int i = 0; i < _content.length();++i ) {
+	for ( int i = 0; i < _length;++i ) {
 		if ( _content[i] == _delimiter ) {
 			++cnt;
 		}
@@ -47,22 +52,13 @@ int TextLine::find_pos(int field_index) const {
 }
 
 // ------------------------------------------------------
-// get int
+// get int - the number ends at the next delimiter so it
+// can be parsed in place
 // ------------------------------------------------------
 int TextLine::get_int(int index) const {
 	int idx = find_pos(index);
 	if ( idx != -1 ) {
-		int v;
-		int npos = find_pos(index+1);
-		if ( npos != -1 ) {
-			std::string str = _content.substr(idx,npos-idx-1);		
-			sscanf(str.c_str(),"%d",&v);
-		}
-		else {
-			std::string str = _content.substr(idx);		
-			sscanf(str.c_str(),"%d",&v);
-		}
-		return v;
+		return static_cast<int>(strtol(_content + idx, 0, 10));
 	}
 	return -1;
 }
@@ -73,17 +69,7 @@ int TextLine::get_int(int index) const {
 float TextLine::get_float(int index) const {
 	int idx = find_pos(index);
 	if (idx != -1) {
-		float v;
-		int npos = find_pos(index + 1);
-		if (npos != -1) {
-			std::string str = _content.substr(idx, npos - idx - 1);
-			sscanf(str.c_str(), "%g", &v);
-		}
-		else {
-			std::string str = _content.substr(idx);
-			sscanf(str.c_str(), "%g", &v);
-		}
-		return v;
+		return strtof(_content + idx, 0);
 	}
 	return -1;
 }
@@ -94,17 +80,13 @@ float TextLine::get_float(int index) const {
 int TextLine::get_string(int index,char* dest) const {
 	int idx = find_pos(index);
 	if ( idx != -1 ) {
-		int npos = find_pos(index+1);
-		if ( npos != -1 ) {			
-			std::string str = _content.substr(idx,npos-idx-1);		
-			strcpy(dest,str.c_str());
-			return str.length();
-		}
-		else {
-			std::string str = _content.substr(idx);		
-			strcpy(dest,str.c_str());
-			return str.length();
+		int len = 0;
+		while (idx + len < _length && _content[idx + len] != _delimiter) {
+			dest[len] = _content[idx + len];
+			++len;
 		}
+		dest[len] = '\0';
+		return len;
 	}
 	return 0;
 }
@@ -139,37 +121,90 @@ bool TextLine::get_bool(int index) const {
 // ------------------------------------------------------
 // CSVFile
 // ------------------------------------------------------
-CSVFile::CSVFile() {}
+CSVFile::CSVFile(ds::LinearArena* arena) : _arena(arena), _buffer(0), _lines(0), _numLines(0) {}
 
 
-CSVFile::~CSVFile() {}
+CSVFile::~CSVFile() {
+	release();
+}
+
+// ------------------------------------------------------
+// release - arena memory is freed by the owner of the arena
+// ------------------------------------------------------
+void CSVFile::release() {
+	if (_arena == 0) {
+		delete[] _lines;
+		delete[] _buffer;
+	}
+	_lines = 0;
+	_buffer = 0;
+	_numLines = 0;
+}
 
 // ------------------------------------------------------
 // load
 // ------------------------------------------------------
 bool CSVFile::load(const char* fileName,const char* directory) {
-	char buffer[256];
-	sprintf(buffer,"%s\\%s",directory,fileName);
-	std::string line;
-	std::ifstream myfile(buffer);
-	_lines.clear();
-	if (myfile.is_open()) {
-		while (std::getline(myfile, line)) {
-			if (line.find("#") == std::string::npos && line.find(",") != std::string::npos) {
-				_lines.push_back(TextLine(line));					
-			}
+	char name[256];
+	sprintf(name,"%s\\%s",directory,fileName);
+	release();
+	FILE* fp = fopen(name, "rb");
+	if (fp == 0) {
+		return false;
+	}
+	fseek(fp, 0, SEEK_END);
+	int size = static_cast<int>(ftell(fp));
+	fseek(fp, 0, SEEK_SET);
+	int maxLines = 1;
+	if (_arena != 0) {
+		_buffer = _arena->allocArray<char>(size + 1);
+	}
+	else {
+		_buffer = new char[size + 1];
+	}
+	size = static_cast<int>(fread(_buffer, 1, size, fp));
+	fclose(fp);
+	_buffer[size] = '\0';
+	for (int i = 0; i < size; ++i) {
+		if (_buffer[i] == '\n') {
+			++maxLines;
 		}
-		myfile.close();
-		return true;
 	}
-	return false;
+	if (_arena != 0) {
+		_lines = _arena->allocArray<TextLine>(maxLines);
+	}
+	else {
+		_lines = new TextLine[maxLines];
+	}
+	//
+	// terminate every line in place and keep the ones that
+	// are no comments and contain at least one delimiter
+	//
+	int start = 0;
+	while (start < size) {
+		int end = start;
+		while (end < size && _buffer[end] != '\n') {
+			++end;
+		}
+		int length = end - start;
+		_buffer[end] = '\0';
+		if (length > 0 && _buffer[start + length - 1] == '\r') {
+			_buffer[start + --length] = '\0';
+		}
+		const char* line = _buffer + start;
+		if (memchr(line, '#', length) == 0 && memchr(line, ',', length) != 0) {
+			new (&_lines[_numLines++]) TextLine(line, length);
+		}
+		start = end + 1;
+	}
+	return true;
 }
 
 // ------------------------------------------------------
 // get line
 // ------------------------------------------------------
 const TextLine& CSVFile::get(int index) const {
-	assert(index >= 0 && index < _lines.size());
+	assert(index >= 0 && index < _numLines);
 	return _lines[index];
 }
 
@@ -177,5 +212,5 @@ const TextLine& CSVFile::get(int index) const {
 // size
 // ------------------------------------------------------
 const size_t CSVFile::size() const {
-	return _lines.size();
-}
\ No newline at end of file
+	return _numLines;
+}
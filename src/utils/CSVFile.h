@@ -1,17 +1,23 @@
 #pragma once
-#include <string>
-#include <vector>
+#include <stddef.h>
+
+namespace ds {
+	class LinearArena;
+}
 
 // ------------------------------------------------------
 // TextLine
+//
+// View of one line inside the buffer of a CSVFile. The
+// line is zero terminated and is never copied.
 // ------------------------------------------------------
 class TextLine {
 
 public:
-	TextLine() {}
-	TextLine(const std::string& str);
+	TextLine() : _content(0), _length(0), _num_delimiters(0), _delimiter(',') {}
+	TextLine(const char* str, int length, const char delimiter = ',');
 	~TextLine() {}
-	void set(const std::string& str,const char delimiter = ',');
+	void set(const char* str, int length, const char delimiter = ',');
 	int find_pos(int field_index) const;
 	int get_int(int index) const;
 	float get_float(int index) const;
@@ -21,25 +27,33 @@ public:
 	int num_tokens() const;
 	void print() const;
 private:
+	const char* _content;
+	int _length;
 	int _num_delimiters;
-	std::string _content;
 	char _delimiter;
 };
 
 // ------------------------------------------------------
 // CSVFile
+//
+// Reads the entire file into one buffer. If an arena is
+// passed the buffer and the lines are allocated from it
+// and stay valid until the arena is rewound.
 // ------------------------------------------------------
 class CSVFile {
 
-typedef std::vector<TextLine> Lines;
-
 public:
-	CSVFile();
+	CSVFile(ds::LinearArena* arena = 0);
 	~CSVFile();
 	bool load(const char* fileName,const char* directory);
 	const TextLine& get(int index) const;
 	const size_t size() const;
 private:
-	Lines _lines;
+	void release();
+	CSVFile(const CSVFile& orig) {}
+	ds::LinearArena* _arena;
+	char* _buffer;
+	TextLine* _lines;
+	int _numLines;
 };
 